@@ -13,6 +13,7 @@
 # limitations under the License.
 
 from conan import ConanFile
+from conan.tools.cmake import CMake
 
 
 required_conan_version = ">=2.0.14"
@@ -25,16 +26,40 @@ class libhal_expander_conan(ConanFile):
     description = ("A collection of drivers for the expander")
     topics = ("expander", "libhal", "driver")
     settings = "compiler", "build_type", "os", "arch"
+    options = {"tracing": [True, False]}
+    default_options = {"tracing": False}
 
     python_requires = "libhal-bootstrap/[^4.0.0]"
     python_requires_extend = "libhal-bootstrap.library"
 
+    def init(self):
+        # Keep any options declared by the bootstrap library class
+        base = self.python_requires["libhal-bootstrap"].module.library
+        self.options.update(getattr(base, "options", {}),
+                            getattr(base, "default_options", {}))
+
     def requirements(self):
         # Adds libhal and libhal-util as transitive headers, meaning library
         # consumers get the libhal and libhal-util headers downstream.
         bootstrap = self.python_requires["libhal-bootstrap"]
         bootstrap.module.add_library_requirements(self)
 
+    def build(self):
+        cmake = CMake(self)
+        cmake.configure(variables={
+            "LIBHAL_EXPANDER_TRACING": bool(self.options.tracing)
+        })
+        cmake.build()
+
     def package_info(self):
         self.cpp_info.libs = ["libhal-expander"]
+        # Host and test utilities are only built for targets with an OS
+        if self.settings.os != "baremetal":
+            self.cpp_info.libs.insert(0, "libhal-expander-host")
+        if self.settings.os == "Linux":
+            self.cpp_info.system_libs = ["pthread"]
+        # Tracepoints change inline code in the headers, so consumers must be
+        # compiled with the same value as the library.
+        tracing = 1 if self.options.tracing else 0
+        self.cpp_info.defines = [f"LIBHAL_EXPANDER_TRACING={tracing}"]
         self.cpp_info.set_property("cmake_target_name", "libhal::expander")
@@ -0,0 +1,67 @@
+// Copyright 2024 Khalil Estell
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstdint>
+
+#include <libhal/steady_clock.hpp>
+#include <libhal/units.hpp>
+
+#include <libhal-expander/expander_policy.hpp>
+#include <libhal-expander/pca9685.hpp>
+#include <libhal-expander/tla2528.hpp>
+
+namespace hal::expander {
+/**
+ * @brief What autotune() measures
+ *
+ */
+struct autotune_settings
+{
+  /// Number of times each strategy's workload is repeated
+  std::uint16_t iterations = 8;
+  /// tla2528 pins scanned to time the scan strategies. Their pin modes
+  /// should be adc.
+  hal::byte tla2528_channels = 0xFF;
+};
+
+/**
+ * @brief Measure the update strategies of a board's drivers on the live bus
+ *
+ * For the pca9685, frames of registers spread over channels 0 to 8 are
+ * written with each candidate burst gap of 2, 8 and 64 bytes, each of which
+ * results in different traffic. The frames rewrite the registers' current
+ * values, so the outputs do not change while tuning. Registers whose values
+ * the driver does not know are left alone, and gaps only bridge known
+ * registers, so set every channel before tuning.
+ * For the tla2528, the selected pins are scanned with each scan mode, which
+ * only reads. Ties go to the candidate measured first, which is the one with
+ * fewer bytes on the bus.
+ *
+ * The chosen policy is applied to the drivers that were measured and returned
+ * so it can be stored and restored on later boots.
+ *
+ * @param p_clock - clock to time the strategies with
+ * @param p_pca9685 - pca9685 to measure, or nullptr to keep the default
+ * @param p_tla2528 - tla2528 to measure, or nullptr to keep the default
+ * @param p_settings - workload sizes
+ * @return expander_policy - fastest strategy for each driver
+ * @throws any exception thrown by the drivers' transactions
+ */
+expander_policy autotune(hal::steady_clock& p_clock,
+                         pca9685* p_pca9685,
+                         tla2528* p_tla2528,
+                         autotune_settings const& p_settings);
+}  // namespace hal::expander
@@ -0,0 +1,685 @@
+// Copyright 2024 Khalil Estell
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <optional>
+#include <span>
+
+#include <libhal/error.hpp>
+#include <libhal/steady_clock.hpp>
+#include <libhal/units.hpp>
+
+#include <libhal-expander/bus_policy.hpp>
+#include <libhal-expander/expander_policy.hpp>
+#include <libhal-expander/i2c_bus.hpp>
+#include <libhal-expander/pca9685_registers.hpp>
+#include <libhal-expander/tracepoint.hpp>
+
+namespace hal::expander {
+/**
+ * @brief pca9685 driver statically bound to a concrete i2c bus type
+ *
+ * This is the implementation of `pca9685`, which is the instantiation for
+ * `hal::i2c` with `hal::pwm` channel adapters. Bound to a concrete bus type,
+ * the driver calls the bus through that type and hands out channel objects
+ * that are not `hal::pwm` implementations. With the bus type marked `final`,
+ * the entire path from `duty_cycle()` to the bus peripheral's registers is
+ * visible to the compiler and contains no virtual calls. Use `pca9685` when
+ * the driver must work with any `hal::i2c` or its channels must be passed on
+ * as `hal::pwm`.
+ *
+ * USAGE:
+ *
+ *    hal::lpc40::i2c i2c(2);
+ *    hal::expander::basic_pca9685 pca9685(i2c, 0b100'0000);
+ *    auto pwm0 = pca9685.get_pwm_channel<0>();
+ *    pwm0.frequency(1_kHz);
+ *    pwm0.duty_cycle(0.25f);
+ *
+ * @tparam bus_type - i2c bus type such as a `final` implementation of hal::i2c
+ */
+template<i2c_bus bus_type>
+class basic_pca9685
+{
+public:
+  static constexpr size_t max_channel_count = 16;
+  /// Pin state choices if the OE pin is active
+  using disabled_pin_state = pca9685_disabled_pin_state;
+  /// Collection of settings that can be configured
+  using settings = pca9685_settings;
+  /// Ticks at which a channel's output goes HIGH and LOW
+  using channel_edges = pca9685_channel_edges;
+
+  /**
+   * @brief Statically dispatched pca9685 pwm channel
+   *
+   * @tparam channel - channel number from 0 to 15
+   */
+  template<hal::byte channel>
+  class pwm_channel
+  {
+  public:
+    /**
+     * @brief Change the frequency of all PWM channels
+     *
+     * See `basic_pca9685::frequency()`.
+     *
+     * @param p_frequency - frequency to set the whole pca9685 device to.
+     * @throws hal::argument_out_of_domain - if the frequency is outside of the
+     * available frequency ranges.
+     */
+    void frequency(hal::hertz p_frequency)
+    {
+      m_pca9685->frequency(p_frequency);
+    }
+
+    /**
+     * @brief Set the duty cycle of this channel
+     *
+     * @param p_duty_cycle - the desired pwm duty cycle from 0.0f to 1.0f
+     */
+    void duty_cycle(float p_duty_cycle)
+    {
+      m_pca9685->duty_cycle(channel, p_duty_cycle);
+    }
+
+  private:
+    explicit pwm_channel(basic_pca9685* p_pca9685)
+      : m_pca9685(p_pca9685)
+    {
+    }
+
+    basic_pca9685* m_pca9685;
+
+    friend class basic_pca9685;
+  };
+
+  /**
+   * @brief Create a pca9685 driver object
+   *
+   * @param p_i2c - i2c bus to communicate with the chip. Must outlive this
+   * object.
+   * @param p_address - the address of the device which can be anywhere from
+   * 0b100'0000 to 0x111'1111 depending on if the address pins are pulled to GND
+   * (0) or to VCC (1). The address is 0b100'0000 if all of the address pins are
+   * pulled to GND.
+   * @param p_settings - optional starting settings for the device. If this is
+   * not entered or is set to `std::nullopt`, then it will use the default
+   * settings.
+   * @throws hal::no_such_device - if the device cannot be found on the i2c bus
+   */
+  basic_pca9685(bus_type& p_i2c,
+                hal::byte p_address,
+                std::optional<settings> p_settings = std::nullopt)
+    : m_i2c(&p_i2c)
+    , m_address(p_address)
+  {
+    configure(p_settings.value_or(settings{}));
+  }
+
+  /**
+   * @brief Create a pca9685 driver for a device initialized by a board init
+   * script
+   *
+   * No transactions are made. The driver takes on the device's known register
+   * values, so later operations only write what changes.
+   *
+   * @param p_i2c - i2c bus to communicate with the chip. Must outlive this
+   * object.
+   * @param p_state - state of the device after the init script ran, see
+   * `initial_state()` in board.hpp
+   */
+  basic_pca9685(bus_type& p_i2c, pca9685_state const& p_state)
+    : m_i2c(&p_i2c)
+    , m_address(p_state.address)
+    , m_settings(p_state.settings)
+    , m_registers(p_state.registers)
+    , m_prescale(p_state.prescale)
+  {
+  }
+
+  /**
+   * @brief Get a pwm channel object
+   *
+   * @tparam channel - Which channel pin to get. Can be from 0 to 15.
+   * @return pwm_channel<channel> - handle for an individual pin on the pca9685
+   */
+  template<hal::byte channel>
+  pwm_channel<channel> get_pwm_channel()
+  {
+    static_assert(channel < max_channel_count,
+                  "The PCA9685 only has 16 channels!");
+
+    return pwm_channel<channel>(this);
+  }
+
+  /**
+   * @brief Configure the device
+   *
+   * The settings will be cached by the driver so that it can be restored when
+   * updating the PWM frequency. While updates are deferred,
+   * `output_changes_on_i2c_acknowledge` is held off, see `defer_updates()`.
+   *
+   * @param p_settings - settings to configure the device to
+   */
+  void configure(settings const& p_settings)
+  {
+    trace_scope trace(trace_op::pca9685_configure);
+    auto device_settings = p_settings;
+    if (m_deferral_clock != nullptr) {
+      device_settings.output_changes_on_i2c_acknowledge = false;
+    }
+    pca9685_registers::insert_settings(m_registers, device_settings);
+    flush(trace_op::pca9685_configure);
+    m_settings = p_settings;
+  }
+
+  /**
+   * @brief Change the frequency of all PWM channels
+   *
+   * Maximum frequency is 1526 Hz.
+   * Minimum frequency is 24 Hz.
+   *
+   * @param p_frequency - frequency to set the whole pca9685 device to.
+   * @throws hal::argument_out_of_domain - if the frequency is outside of the
+   * available frequency ranges.
+   */
+  void frequency(hal::hertz p_frequency)
+  {
+    trace_scope trace(trace_op::pca9685_frequency);
+    if (!pca9685_registers::frequency_in_range(p_frequency)) {
+      hal::safe_throw(hal::argument_out_of_domain(this));
+    }
+    set_prescale(pca9685_registers::prescale(p_frequency));
+  }
+
+  /**
+   * @brief Set the duty cycle of an individual channel
+   *
+   * @param p_channel - channel from 0 to 15
+   * @param p_duty_cycle - the desired pwm duty cycle from 0.0f to 1.0f
+   */
+  void duty_cycle(hal::byte p_channel, float p_duty_cycle)
+  {
+    trace_scope trace(trace_op::pca9685_duty_cycle);
+    tracepoint(trace_op::pca9685_duty_cycle, trace_phase::compute_begin);
+    m_registers.set(pca9685_registers::channel_address(p_channel),
+                    pca9685_registers::duty_cycle_registers(p_duty_cycle));
+    tracepoint(trace_op::pca9685_duty_cycle, trace_phase::compute_end);
+    flush_channels(trace_op::pca9685_duty_cycle);
+  }
+
+  /**
+   * @brief Set the pulse width of consecutive channels in one burst
+   *
+   * Intended for control loops that compute a whole frame of outputs in
+   * fixed point. Only the channels whose value changed are written, and
+   * changed channels next to each other are written in a single transaction.
+   *
+   * @param p_off_ticks - tick from 0 to 4095 at which each channel's output
+   * goes LOW. Larger values are limited to 4095.
+   * @param p_first_channel - channel the first value applies to
+   * @throws hal::argument_out_of_domain - if the channels extend beyond
+   * channel 15
+   */
+  void set_channel_ticks(std::span<std::uint16_t const> p_off_ticks,
+                         hal::byte p_first_channel = 0)
+  {
+    trace_scope trace(trace_op::pca9685_channel_ticks);
+    if (p_first_channel + p_off_ticks.size() > max_channel_count) {
+      hal::safe_throw(hal::argument_out_of_domain(this));
+    }
+
+    tracepoint(trace_op::pca9685_channel_ticks, trace_phase::compute_begin);
+    auto channel = p_first_channel;
+    for (auto const off_ticks : p_off_ticks) {
+      m_registers.set(pca9685_registers::channel_address(channel++),
+                      pca9685_registers::ticks_registers(off_ticks));
+    }
+    tracepoint(trace_op::pca9685_channel_ticks, trace_phase::compute_end);
+    flush_channels(trace_op::pca9685_channel_ticks);
+  }
+
+  /**
+   * @brief Set both edges of consecutive channels in one burst
+   *
+   * Unlike `set_channel_ticks()`, pulses can start anywhere in the cycle, so
+   * channels can be phase shifted against each other. Only the channels whose
+   * value changed are written, in as few transactions as
+   * `set_channel_ticks()`.
+   *
+   * @param p_edges - ON and OFF ticks of each channel
+   * @param p_first_channel - channel the first value applies to
+   * @throws hal::argument_out_of_domain - if the channels extend beyond
+   * channel 15
+   */
+  void set_channel_edges(std::span<channel_edges const> p_edges,
+                         hal::byte p_first_channel = 0)
+  {
+    trace_scope trace(trace_op::pca9685_channel_edges);
+    if (p_first_channel + p_edges.size() > max_channel_count) {
+      hal::safe_throw(hal::argument_out_of_domain(this));
+    }
+
+    tracepoint(trace_op::pca9685_channel_edges, trace_phase::compute_begin);
+    auto channel = p_first_channel;
+    for (auto const& edges : p_edges) {
+      m_registers.set(pca9685_registers::channel_address(channel++),
+                      pca9685_registers::edge_registers(edges));
+    }
+    tracepoint(trace_op::pca9685_channel_edges, trace_phase::compute_end);
+    flush_channels(trace_op::pca9685_channel_edges);
+  }
+
+  /**
+   * @brief Always write consecutive channels in one transaction
+   *
+   * Whenever any of the channels changes, all of their registers are written
+   * in a single burst, whatever the policy's burst gap and whichever bytes
+   * changed. For outputs that must change together, such as the two sides of
+   * a half bridge.
+   *
+   * @param p_first_channel - first channel of the group
+   * @param p_count - number of channels in the group
+   * @throws hal::argument_out_of_domain - if the channels extend beyond
+   * channel 15
+   */
+  void write_together(hal::byte p_first_channel, hal::byte p_count)
+  {
+    if (p_first_channel + p_count > max_channel_count) {
+      hal::safe_throw(hal::argument_out_of_domain(this));
+    }
+    for (hal::byte i = 1; i < p_count; i++) {
+      m_linked_channels |=
+        static_cast<std::uint16_t>(1U << (p_first_channel + i - 1));
+    }
+  }
+
+  /**
+   * @brief Bound the time spent on each i2c transaction and retry failures
+   *
+   * By default, transactions never time out and are never retried. After this
+   * call, every transaction made by this driver is limited by
+   * `p_policy.timeout` and retried according to the policy. The constructor's
+   * transactions are made before a policy can be set and are unbounded.
+   *
+   * @param p_clock - clock to measure timeouts and backoff delays with. Must
+   * outlive this object.
+   * @param p_policy - timeout, retry and backoff limits
+   */
+  void set_bus_policy(hal::steady_clock& p_clock, bus_policy const& p_policy)
+  {
+    m_bus = bus_guard(p_clock, p_policy);
+  }
+
+  /**
+   * @brief Use the update strategies of a board's policy
+   *
+   * @param p_policy - policy measured by `autotune()` or restored from storage
+   */
+  void set_policy(expander_policy const& p_policy)
+  {
+    m_burst_gap = p_policy.pca9685_burst_gap;
+  }
+
+  /**
+   * @return bus_guard const& - the policy in effect along with worst case and
+   * observed transaction latency, retry and failure counts.
+   */
+  [[nodiscard]] bus_guard const& bus() const
+  {
+    return m_bus;
+  }
+
+  /**
+   * @brief Write every register value the driver knows again with its next
+   * update
+   *
+   * Use after writes may have been lost without the driver seeing an error,
+   * such as chained writes of a `bus_session` whose `commit()` failed. Until
+   * then, `updates_pending()` is true, so `service()` writes them too.
+   */
+  void resync()
+  {
+    m_registers.mark_dirty(pca9685_registers::image::first_address,
+                           pca9685_registers::image::size);
+  }
+
+  /**
+   * @brief Write channel updates at most once per PWM period
+   *
+   * A new channel value only reaches the output at the end of the PWM cycle
+   * it was written in, so a value replaced within the same period never
+   * appears on the output and its write is wasted bus time. In deferred mode,
+   * `duty_cycle()`, `set_channel_ticks()` and `set_channel_edges()` only write
+   * to the bus if a full PWM period has passed since the last write. Otherwise
+   * the update is held in the register shadow, where later updates replace it,
+   * until `service()` or `flush_now()` writes every held channel.
+   *
+   * The period is computed from the prescale the driver last wrote, or the
+   * power on prescale. Configuration and frequency changes are always written
+   * immediately, along with any held channel updates.
+   *
+   * Holding updates for a period relies on outputs changing at the end of the
+   * PWM cycle. If `output_changes_on_i2c_acknowledge` is set, it is cleared on
+   * the device until `write_through()`.
+   *
+   * USAGE:
+   *
+   *    pca9685.defer_updates(clock);
+   *    while (true) {
+   *      pwm0.duty_cycle(compute_output());  // may be held
+   *      pca9685.service();
+   *    }
+   *
+   * @param p_clock - clock to measure PWM periods with. Must outlive this
+   * object or the next `write_through()` call.
+   */
+  void defer_updates(hal::steady_clock& p_clock)
+  {
+    m_deferral_clock = &p_clock;
+    if (m_settings.output_changes_on_i2c_acknowledge) {
+      configure(m_settings);
+    }
+    m_written_since_deferral = false;
+    update_period_ticks();
+  }
+
+  /**
+   * @brief Hold every channel update and write them from `service()`
+   *
+   * `duty_cycle()`, `set_channel_ticks()` and `set_channel_edges()` only
+   * update the register shadow and never touch the bus, so a bus error cannot
+   * reach the caller's control loop or lose the intended output. `service()`
+   * writes the held registers, retrying failed writes, and swallows the error
+   * if every attempt fails. Registers that failed stay held for the next
+   * `service()`, and `unconfirmed_channels()` reports which channels have not
+   * reached the device yet.
+   *
+   * Combined with `defer_updates()`, `service()` also writes at most once per
+   * PWM period. Configuration and frequency changes are written immediately
+   * and still throw.
+   *
+   * @param p_attempts - writes `service()` tries before giving up until its
+   * next call, values below 1 are treated as 1
+   */
+  void write_behind(hal::byte p_attempts = 3)
+  {
+    m_write_behind_attempts = std::max(p_attempts, hal::byte{ 1 });
+  }
+
+  /**
+   * @brief Leave deferred and write-behind modes, writing any held channel
+   * updates
+   *
+   * Restores `output_changes_on_i2c_acknowledge` if it was set.
+   */
+  void write_through()
+  {
+    m_write_behind_attempts = 0;
+    flush_now();
+    m_deferral_clock = nullptr;
+    if (m_settings.output_changes_on_i2c_acknowledge) {
+      configure(m_settings);
+    }
+  }
+
+  /**
+   * @brief Write held channel updates
+   *
+   * Call regularly while in deferred or write-behind mode, such as once per
+   * loop. In deferred mode, updates are only written once a PWM period has
+   * passed since the last write. In write-behind mode, errors are retried and
+   * then swallowed instead of thrown.
+   *
+   * @return true - if held updates were written
+   */
+  bool service()
+  {
+    if (!updates_pending() || !period_elapsed()) {
+      return false;
+    }
+    if (m_write_behind_attempts == 0) {
+      flush_now();
+      return true;
+    }
+
+    for (hal::byte attempt = 0; attempt < m_write_behind_attempts;
+         attempt++) {
+      try {
+        // Bursts that were written before a failure are clean, so each
+        // attempt only writes what is still dirty.
+        flush_now();
+        return true;
+      } catch (hal::exception const&) {
+        m_absorbed_failures++;
+      }
+    }
+    return false;
+  }
+
+  /**
+   * @brief Write held channel updates now, for changes that cannot wait for
+   * the next period
+   *
+   */
+  void flush_now()
+  {
+    trace_scope trace(trace_op::pca9685_deferred_flush);
+    flush(trace_op::pca9685_deferred_flush);
+  }
+
+  /**
+   * @return true - if channel updates are held for a later write
+   */
+  [[nodiscard]] bool updates_pending() const
+  {
+    return m_registers.dirty();
+  }
+
+  /**
+   * @return std::uint16_t - bit field of the channels with updates that have
+   * not been written to the device, bit 0 is channel 0
+   */
+  [[nodiscard]] std::uint16_t unconfirmed_channels() const
+  {
+    using namespace pca9685_registers;
+    std::uint16_t channels = 0;
+    for (hal::byte channel = 0; channel < max_channel_count; channel++) {
+      if (m_registers.dirty(channel_address(channel), pwm_channel0::width)) {
+        channels |= static_cast<std::uint16_t>(1U << channel);
+      }
+    }
+    return channels;
+  }
+
+  /**
+   * @return std::uint32_t - number of failed write attempts absorbed by
+   * `service()` in write-behind mode
+   */
+  [[nodiscard]] std::uint32_t absorbed_failures() const
+  {
+    return m_absorbed_failures;
+  }
+
+  /**
+   * @return hal::time_duration - length of one PWM cycle at the current
+   * prescale
+   */
+  [[nodiscard]] hal::time_duration pwm_period() const
+  {
+    return pca9685_registers::cycle_period(m_prescale);
+  }
+
+  friend autotune_access;
+
+protected:
+  /**
+   * @return hal::byte - PRE_SCALE value the driver last wrote, or the power on
+   * value
+   */
+  [[nodiscard]] hal::byte current_prescale() const
+  {
+    return m_prescale;
+  }
+
+  /**
+   * @brief Write the PRE_SCALE register, which sets the frequency of every
+   * channel
+   *
+   * @param p_prescale - PRE_SCALE register value
+   */
+  void set_prescale(hal::byte p_prescale)
+  {
+    // The device must be put to sleep before it can have its prescale value
+    // updated.
+    auto original_settings = m_settings;
+    // Ensure that the settings put the device to sleep.
+    m_settings.sleep = true;
+    configure(m_settings);
+
+    write(trace_op::pca9685_frequency,
+          std::array{ pca9685_registers::prescaler::address, p_prescale });
+    m_prescale = p_prescale;
+    update_period_ticks();
+
+    // Configure device back to what it was before which may or may not be
+    // asleep
+    configure(original_settings);
+  }
+
+  /**
+   * @brief Set the edges of a channel, such as from an integer duty cycle
+   *
+   * @param p_edges - ON and OFF ticks of the channel, including the full ON
+   * and full OFF bits
+   * @param p_channel - channel from 0 to 15
+   */
+  void set_channel_edge(channel_edges const& p_edges, hal::byte p_channel)
+  {
+    trace_scope trace(trace_op::pca9685_duty_cycle);
+    tracepoint(trace_op::pca9685_duty_cycle, trace_phase::compute_begin);
+    m_registers.set(pca9685_registers::channel_address(p_channel),
+                    pca9685_registers::edge_registers(p_edges));
+    tracepoint(trace_op::pca9685_duty_cycle, trace_phase::compute_end);
+    flush_channels(trace_op::pca9685_duty_cycle);
+  }
+
+private:
+  void flush(trace_op p_op)
+  {
+    complete_channel_groups();
+    auto const bursts = m_registers.flush(
+      [this, p_op](hal::byte p_register, std::span<hal::byte const> p_data) {
+        std::array<hal::byte, pca9685_registers::image::size + 1> buffer;
+        tracepoint(p_op, trace_phase::compute_begin);
+        auto const data = pca9685_registers::burst(buffer, p_register, p_data);
+        tracepoint(p_op, trace_phase::compute_end);
+        write(p_op, data);
+      },
+      m_burst_gap);
+
+    if (bursts > 0 && m_deferral_clock != nullptr) {
+      m_last_write = m_deferral_clock->uptime();
+      m_written_since_deferral = true;
+    }
+  }
+
+  /**
+   * With `output_changes_on_i2c_acknowledge` set, the device only changes an
+   * output once all 4 of its channel registers are loaded, so a channel is
+   * never written in part. Channels linked by `write_together()` are written
+   * whole along with the rest of their group, as one contiguous burst.
+   */
+  void complete_channel_groups()
+  {
+    using namespace pca9685_registers;
+    bool const whole_channels =
+      m_registers.extract<update_on_acknowledge>() != 0;
+    hal::byte channel = 0;
+    while (channel < max_channel_count) {
+      hal::byte count = 1;
+      while (channel + count < max_channel_count &&
+             (m_linked_channels >> (channel + count - 1) & 1U) != 0) {
+        count++;
+      }
+      auto const address = channel_address(channel);
+      auto const width = count * pwm_channel0::width;
+      if ((whole_channels || count > 1) && m_registers.dirty(address, width)) {
+        m_registers.mark_dirty(address, width);
+      }
+      channel += count;
+    }
+  }
+
+  void flush_channels(trace_op p_op)
+  {
+    if (m_write_behind_attempts > 0) {
+      return;
+    }
+    if (m_deferral_clock == nullptr || period_elapsed()) {
+      flush(p_op);
+    }
+  }
+
+  bool period_elapsed() const
+  {
+    if (m_deferral_clock == nullptr || !m_written_since_deferral) {
+      return true;
+    }
+    return m_deferral_clock->uptime() - m_last_write >= m_period_ticks;
+  }
+
+  void update_period_ticks()
+  {
+    if (m_deferral_clock == nullptr) {
+      return;
+    }
+    auto const period_ns = static_cast<double>(pwm_period().count());
+    auto const ticks_per_ns = m_deferral_clock->frequency() / 1e9;
+    m_period_ticks =
+      static_cast<std::uint64_t>(std::ceil(period_ns * ticks_per_ns));
+  }
+
+  void write(trace_op p_op, std::span<hal::byte const> p_data)
+  {
+    tracepoint(p_op, trace_phase::bus_begin);
+    m_bus.transaction(*m_i2c, m_address, p_data);
+    tracepoint(p_op, trace_phase::bus_end);
+  }
+
+  bus_type* m_i2c;
+  hal::byte m_address;
+  settings m_settings{};
+  pca9685_registers::image m_registers{};
+  bus_guard m_bus{};
+  hal::byte m_burst_gap = pca9685_registers::max_burst_gap;
+  hal::byte m_prescale = pca9685_registers::power_on_prescale;
+  // Bit n links channel n to channel n + 1, see write_together()
+  std::uint16_t m_linked_channels = 0;
+  // Set while updates are deferred
+  hal::steady_clock* m_deferral_clock = nullptr;
+  std::uint64_t m_last_write = 0;
+  std::uint64_t m_period_ticks = 0;
+  bool m_written_since_deferral = false;
+  // Non-zero while in write-behind mode
+  hal::byte m_write_behind_attempts = 0;
+  std::uint32_t m_absorbed_failures = 0;
+};
+}  // namespace hal::expander
@@ -0,0 +1,610 @@
+// Copyright 2024 Khalil Estell
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <span>
+
+#include <libhal-util/bit.hpp>
+#include <libhal/error.hpp>
+#include <libhal/steady_clock.hpp>
+#include <libhal/units.hpp>
+
+#include <libhal-expander/bus_policy.hpp>
+#include <libhal-expander/expander_policy.hpp>
+#include <libhal-expander/i2c_bus.hpp>
+#include <libhal-expander/tla2528_registers.hpp>
+#include <libhal-expander/tracepoint.hpp>
+
+namespace hal::expander {
+/**
+ * @brief tla2528 driver statically bound to a concrete i2c bus type
+ *
+ * This is the implementation of `tla2528`, which is the instantiation for
+ * `hal::i2c` with `hal::adc`, `hal::input_pin` and `hal::output_pin`
+ * adapters. Bound to a concrete bus type, the driver calls the bus through
+ * that type so that, with the bus type marked `final`, reading a pin or an
+ * adc channel involves no virtual calls. Use `tla2528` when the pins must be
+ * passed on as libhal interfaces.
+ *
+ * USAGE:
+ *
+ *    hal::lpc40::i2c i2c(2);
+ *    hal::expander::basic_tla2528 tla2528(i2c);
+ *    tla2528.set_pin_mode(hal::expander::tla2528_pin_mode::adc, 0);
+ *    float reading = tla2528.get_adc_reading(0);
+ *
+ * @tparam bus_type - i2c bus type such as a `final` implementation of hal::i2c
+ */
+template<i2c_bus bus_type>
+class basic_tla2528
+{
+public:
+  using pin_mode = tla2528_pin_mode;
+
+  /// i2c address for no resistors
+  static constexpr hal::byte default_address = 0x10;
+
+  /**
+   * @param p_i2c - i2c bus of the device. Must outlive this object.
+   * @param p_i2c_address - i2c address configured on the tla2528, by default
+   * is set to the i2c address of no resistors attached to address config pins.
+   */
+  explicit basic_tla2528(bus_type& p_i2c,
+                         hal::byte p_i2c_address = default_address)
+    : m_i2c(&p_i2c)
+    , m_i2c_address(p_i2c_address)
+  {
+    reset();
+  }
+
+  /**
+   * @brief Create a tla2528 driver for a device initialized by a board init
+   * script
+   *
+   * No transactions are made. The driver takes on the device's known register
+   * values, so later operations only write what changes.
+   *
+   * @param p_i2c - i2c bus of the device. Must outlive this object.
+   * @param p_state - state of the device after the init script ran, see
+   * `initial_state()` in board.hpp
+   */
+  basic_tla2528(bus_type& p_i2c, tla2528_state const& p_state)
+    : m_i2c(&p_i2c)
+    , m_i2c_address(p_state.address)
+    , m_registers(p_state.registers)
+  {
+  }
+
+  /**
+   * @brief set what service a pin will provide
+   *
+   * @param p_mode tla2528::pin_mode enum of desired pin mode
+   * @param p_channel which pin to configure
+   * @throws hal::argument_out_of_domain - if p_channel out of range (>7)
+   * @throws hal::resource_unavailable_try_again - if adapters are made for a
+   * pin an exception may be thrown to prevent invalid behavior
+   */
+  void set_pin_mode(pin_mode p_mode, hal::byte p_channel)
+  {
+    using namespace tla2528_registers;
+    trace_scope trace(trace_op::tla2528_set_pin_mode);
+    throw_if_invalid_channel(p_channel);
+    if (!m_registers.known(pin_cfg::address, pin_config_width)) {
+      std::array<hal::byte, pin_config_width> data_buffer;
+      constexpr std::array<hal::byte, 2> read_cmd_buffer = {
+        op_codes::continuous_register_read, pin_cfg::address
+      };
+      transaction(
+        trace_op::tla2528_set_pin_mode, read_cmd_buffer, data_buffer);
+      m_registers.load(pin_cfg::address, data_buffer);
+    }
+
+    hal::bit_mask channel_mask = hal::bit_mask::from(p_channel);
+    if (p_mode == pin_mode::output_pin_push_pull ||
+        p_mode == pin_mode::output_pin_open_drain) {
+      bool is_analog =
+        hal::bit_extract(channel_mask, m_registers.get<pin_cfg>());
+      bool is_input =
+        hal::bit_extract(channel_mask, m_registers.get<gpio_cfg>());
+      if (!(is_analog || is_input)) {
+        throw_if_channel_occupied(p_channel);
+      }
+    } else {
+      throw_if_channel_occupied(p_channel);
+    }
+
+    insert_pin_mode(m_registers, p_mode, p_channel);
+    flush(trace_op::tla2528_set_pin_mode);
+  }
+
+  /**
+   * @brief set digital output level of a pin
+   *
+   * @param p_channel pin to set output
+   * @param p_high the output level of the pin, true is high, false is low.
+   * @throws hal::argument_out_of_domain - if p_channel out of range (>7)
+   */
+  void set_output_pin(hal::byte p_channel, bool p_high)
+  {
+    throw_if_invalid_channel(p_channel);
+    hal::byte gpo_value_reg = m_registers.get<tla2528_registers::gpo_value>();
+    if (p_high) {
+      hal::bit_modify(gpo_value_reg).set(hal::bit_mask::from(p_channel));
+    } else {
+      hal::bit_modify(gpo_value_reg).clear(hal::bit_mask::from(p_channel));
+    }
+    set_output_bus(gpo_value_reg);
+  }
+
+  /**
+   * @brief set digital output levels on all pins
+   *
+   * @param p_values The byte is used as a bit field of bool values to set the
+   * pin outputs. i.e the 0th bit in the byte will set the 0 pin. If a bit is
+   * 1 it is high. If the bit is 0 it is low.
+   */
+  void set_output_bus(hal::byte p_values)
+  {
+    trace_scope trace(trace_op::tla2528_set_output);
+    // The device will write to a register that caches the desired output state
+    // weather in output mode or not. When a pin is in a digital output mode it
+    // will reference the desired state cache.
+    m_registers.set<tla2528_registers::gpo_value>(p_values);
+    flush(trace_op::tla2528_set_output);
+  }
+
+  /**
+   * @brief read digital output state register of an output pin
+   *
+   * @param p_channel pin you would like to get the ouput value
+   * @return true if the pin's output value register is high. If a pin is not
+   * set to output pin the returned state will be used once it changes to an
+   * output pin.
+   * @throws hal::argument_out_of_domain - if p_channel out of range (>7)
+   */
+  bool get_output_pin_state(hal::byte p_channel)
+  {
+    throw_if_invalid_channel(p_channel);
+    return hal::bit_extract(hal::bit_mask::from(p_channel),
+                            get_output_bus_state());
+  }
+
+  /**
+   * @brief read digital output state register of all output pins
+   *
+   * @return The byte is used as a bit field of bool values to give the pins'
+   * register. i.e the 0th bit in the byte will be the 0 pin's stored value. If
+   * a bit is 1 it is high. If the bit is 0 it is low. If the pin is not set to
+   * output pin the returned state will be used once it changes to an output
+   * pin.
+   */
+  hal::byte get_output_bus_state()
+  {
+    using namespace tla2528_registers;
+    trace_scope trace(trace_op::tla2528_get_output);
+    std::array<hal::byte, 1> data_buffer;
+    constexpr std::array<hal::byte, 2> cmd_buffer = {
+      op_codes::single_register_read,
+      gpo_value::address,
+    };
+    transaction(trace_op::tla2528_get_output, cmd_buffer, data_buffer);
+    if (!m_registers.dirty(gpo_value::address)) {
+      m_registers.load(gpo_value::address, data_buffer);
+    }
+    return data_buffer[0];
+  }
+
+  /**
+   * @brief read the digital level of a pin
+   *
+   * @return true if the pin's digital read value is high. If a pin is not set
+   * to digital input or output the returned value may not correlate with the
+   * true value.
+   * @throws hal::argument_out_of_domain - if p_channel out of range. (>7)
+   *
+   */
+  bool get_input_pin(hal::byte p_channel)
+  {
+    throw_if_invalid_channel(p_channel);
+    return hal::bit_extract(hal::bit_mask::from(p_channel), get_input_bus());
+  }
+
+  /**
+   * @brief read the digital levels of all pins
+   *
+   * @return The byte is used as a bit field of bool values to give the pins'
+   * digital read values. i.e the 0th bit in the byte will be the 0 pin's stored
+   * value. If a bit is 1 it is high. If the bit is 0 it is low. If the pin is
+   * not set to input pin or output pin the returned value may not correlate
+   * with the true value.
+   *
+   */
+  hal::byte get_input_bus()
+  {
+    using namespace tla2528_registers;
+    trace_scope trace(trace_op::tla2528_get_input);
+    std::array<hal::byte, 1> data_buffer;
+    constexpr std::array<hal::byte, 2> cmd_buffer = {
+      op_codes::single_register_read,
+      gpi_value::address,
+    };
+    transaction(trace_op::tla2528_get_input, cmd_buffer, data_buffer);
+    return data_buffer[0];
+  }
+
+  /**
+   * @brief read the raw conversion result of a pin
+   *
+   * @param p_channel - pin to read
+   * @return std::uint16_t - 12-bit conversion result from 0 to 4095
+   * @throws hal::argument_out_of_domain - if p_channel out of range (>7)
+   */
+  std::uint16_t get_adc_code(hal::byte p_channel)
+  {
+    using namespace tla2528_registers;
+    trace_scope trace(trace_op::tla2528_adc_reading);
+    throw_if_invalid_channel(p_channel);
+    m_registers.insert<manual_channel_id>(p_channel);
+    flush(trace_op::tla2528_adc_reading);
+
+    // TODO(#8): look into averaging & channel validation
+    std::array<hal::byte, 2> data_buffer;
+    constexpr std::array<hal::byte, 1> cmd_buffer = {
+      op_codes::single_register_read
+    };
+    transaction(trace_op::tla2528_adc_reading, cmd_buffer, data_buffer);
+    return adc_code(data_buffer);
+  }
+
+  /**
+   * @brief read the adc reading of a pin
+   *
+   * The reading is the code divided by 4095, so the largest code reads as
+   * 1.0. `code_to_microvolts()` in tla2528_registers.hpp and
+   * `codes_to_fractions()` use the converter's full scale of 4096 codes
+   * instead.
+   *
+   * @param p_channel if out of range (>7) an exception will be thrown
+   * @return adc reading as a float between 0 and 1 inclusive. If the pin is not
+   * set to adc the returned value may not correlate with the true
+   * value.
+   * @throws hal::argument_out_of_domain - if p_channel out of range. (>7)
+   */
+  float get_adc_reading(hal::byte p_channel)
+  {
+    return static_cast<float>(get_adc_code(p_channel)) / 4095.0f;
+  }
+
+  /**
+   * @brief read the raw conversion results of several pins
+   *
+   * Each pin is read with a single transaction that selects the channel and
+   * reads the conversion, and the channel is only selected when it changes.
+   * With a `tla2528_scan_mode::split` policy, the select and the read are
+   * separate transactions. Intended for control loops that work on raw codes
+   * in fixed point.
+   *
+   * @param p_channels - bit field of the pins to read, bit 0 is pin 0
+   * @param p_codes - receives the 12-bit conversion result, from 0 to 4095,
+   * of each pin read at the index of its pin number. Entries of pins not read
+   * are left unchanged.
+   */
+  void scan(hal::byte p_channels, std::span<std::uint16_t, 8> p_codes)
+  {
+    trace_scope trace(trace_op::tla2528_scan);
+    scan_each(p_channels,
+              [p_codes](hal::byte p_channel,
+                        std::array<hal::byte, 2> const& p_data) {
+                p_codes[p_channel] = tla2528_registers::adc_code(p_data);
+              });
+  }
+
+  /**
+   * @brief read the raw 16-bit frames of several pins
+   *
+   * Same as `scan()`, except that each result keeps the fraction of a code
+   * that oversampling averages carry, see `tla2528_registers::adc_frame()`.
+   * For measurements that need to resolve less than one code.
+   *
+   * @param p_channels - bit field of the pins to read, bit 0 is pin 0
+   * @param p_frames - receives the result in sixteenths of a code of each pin
+   * read at the index of its pin number. Entries of pins not read are left
+   * unchanged.
+   */
+  void scan_frames(hal::byte p_channels, std::span<std::uint16_t, 8> p_frames)
+  {
+    trace_scope trace(trace_op::tla2528_scan);
+    scan_each(p_channels,
+              [p_frames](hal::byte p_channel,
+                         std::array<hal::byte, 2> const& p_data) {
+                p_frames[p_channel] = tla2528_registers::adc_frame(p_data);
+              });
+  }
+
+  /**
+   * @brief Use a fixed reference voltage for voltage conversions
+   *
+   * Voltages are computed as a fraction of AVDD. This is the default, with
+   * AVDD assumed to be 3.3 V.
+   *
+   * @param p_avdd_microvolts - voltage of the AVDD supply in microvolts
+   */
+  void set_reference(std::uint32_t p_avdd_microvolts)
+  {
+    m_reference_microvolts = p_avdd_microvolts;
+    m_reference_channel = no_reference_channel;
+  }
+
+  /**
+   * @brief Use a pin with a known voltage as the reference for voltage
+   * conversions
+   *
+   * The reference pin is read in the same scan as every voltage conversion and
+   * voltages are computed as a fraction of it, which cancels drift of AVDD.
+   * The pin may be a precision reference, which measures AVDD, or the supply
+   * of a ratiometric sensor such as a bridge or potentiometer, in which case
+   * the result follows the sensor and not the supply. The pin's mode must be
+   * set to adc.
+   *
+   * @param p_channel - pin connected to the reference
+   * @param p_microvolts - nominal voltage of the reference in microvolts
+   * @throws hal::argument_out_of_domain - if p_channel out of range (>7)
+   */
+  void set_reference(hal::byte p_channel, std::uint32_t p_microvolts)
+  {
+    throw_if_invalid_channel(p_channel);
+    m_reference_microvolts = p_microvolts;
+    m_reference_channel = p_channel;
+  }
+
+  /**
+   * @brief read the voltages of several pins
+   *
+   * @param p_channels - bit field of the pins to read, bit 0 is pin 0
+   * @param p_microvolts - receives the voltage of each pin read at the index
+   * of its pin number. Entries of pins not read are left unchanged.
+   * @throws hal::io_error - if the reference pin reads as 0
+   */
+  void scan_microvolts(hal::byte p_channels,
+                       std::span<std::uint32_t, 8> p_microvolts)
+  {
+    using namespace tla2528_registers;
+    std::array<std::uint16_t, channel_count> codes{};
+    std::uint32_t reference_code = full_scale_codes;
+
+    if (m_reference_channel == no_reference_channel) {
+      scan(p_channels, codes);
+    } else {
+      auto const reference_mask = hal::bit_mask::from(m_reference_channel);
+      auto channels = p_channels;
+      hal::bit_modify(channels).set(reference_mask);
+      scan(channels, codes);
+      reference_code = codes[m_reference_channel];
+      if (reference_code == 0) {
+        hal::safe_throw(hal::io_error(this));
+      }
+    }
+
+    for (hal::byte channel = 0; channel < channel_count; channel++) {
+      if (hal::bit_extract(hal::bit_mask::from(channel), p_channels)) {
+        p_microvolts[channel] = code_to_microvolts(
+          codes[channel], m_reference_microvolts, reference_code);
+      }
+    }
+  }
+
+  /**
+   * @brief read the voltage of a pin in microvolts
+   *
+   * @param p_channel - pin to read
+   * @return std::uint32_t - voltage in microvolts
+   * @throws hal::argument_out_of_domain - if p_channel out of range (>7)
+   * @throws hal::io_error - if the reference pin reads as 0
+   */
+  std::uint32_t get_microvolts(hal::byte p_channel)
+  {
+    throw_if_invalid_channel(p_channel);
+    std::array<std::uint32_t, tla2528_registers::channel_count> microvolts{};
+    scan_microvolts(static_cast<hal::byte>(1U << p_channel), microvolts);
+    return microvolts[p_channel];
+  }
+
+  /**
+   * @brief read the voltage of a pin in millivolts
+   *
+   * @param p_channel - pin to read
+   * @return std::uint32_t - voltage in millivolts, rounded to nearest
+   * @throws hal::argument_out_of_domain - if p_channel out of range (>7)
+   * @throws hal::io_error - if the reference pin reads as 0
+   */
+  std::uint32_t get_millivolts(hal::byte p_channel)
+  {
+    return (get_microvolts(p_channel) + 500) / 1000;
+  }
+
+  /**
+   * @brief Average several conversions into each result
+   *
+   * Averaging lowers noise at the cost of a longer conversion, and the ratio
+   * applies to every pin. `characterize_noise()` in tla2528_noise.hpp picks
+   * the smallest ratio that meets a noise target.
+   *
+   * The device returns the average with 16 bits of resolution. Every result
+   * of this driver is the average rounded to the nearest 12-bit code, so
+   * codes, fractions and voltages keep their ranges at any ratio.
+   *
+   * @param p_ratio - number of conversions averaged
+   */
+  void set_oversampling(tla2528_oversampling p_ratio)
+  {
+    trace_scope trace(trace_op::tla2528_oversampling);
+    m_registers.insert<tla2528_registers::oversampling_ratio>(
+      static_cast<hal::byte>(p_ratio));
+    flush(trace_op::tla2528_oversampling);
+  }
+
+  /**
+   * @return tla2528_oversampling - the ratio set by `set_oversampling()`
+   */
+  [[nodiscard]] tla2528_oversampling get_oversampling() const
+  {
+    return static_cast<tla2528_oversampling>(
+      m_registers.extract<tla2528_registers::oversampling_ratio>());
+  }
+
+  /**
+   * @brief Bound the time spent on each i2c transaction and retry failures
+   *
+   * By default, transactions never time out and are never retried. After this
+   * call, every transaction made by this driver and its adapters is limited by
+   * `p_policy.timeout` and retried according to the policy.
+   *
+   * @param p_clock - clock to measure timeouts and backoff delays with. Must
+   * outlive this object.
+   * @param p_policy - timeout, retry and backoff limits
+   */
+  void set_bus_policy(hal::steady_clock& p_clock, bus_policy const& p_policy)
+  {
+    m_bus = bus_guard(p_clock, p_policy);
+  }
+
+  /**
+   * @return bus_guard const& - the policy in effect along with worst case and
+   * observed transaction latency, retry and failure counts.
+   */
+  [[nodiscard]] bus_guard const& bus() const
+  {
+    return m_bus;
+  }
+
+  /**
+   * @brief Write every register value the driver knows again with its next
+   * register write
+   *
+   * Use after writes may have been lost without the driver seeing an error,
+   * such as chained writes of a `bus_session` whose `commit()` failed.
+   */
+  void resync()
+  {
+    m_registers.mark_dirty(tla2528_registers::image::first_address,
+                           tla2528_registers::image::size);
+  }
+
+  /**
+   * @brief Use the scan strategy of a board's policy
+   *
+   * @param p_policy - policy measured by `autotune()` or restored from storage
+   */
+  void set_policy(expander_policy const& p_policy)
+  {
+    m_scan_mode = p_policy.tla2528_scan;
+  }
+
+  friend autotune_access;
+
+protected:
+  void throw_if_invalid_channel(hal::byte p_channel)
+  {
+    if (p_channel >= tla2528_registers::channel_count) {
+      hal::safe_throw(hal::argument_out_of_domain(this));
+    }
+  }
+
+  void throw_if_channel_occupied(hal::byte p_channel)
+  {
+    if (hal::bit_extract(hal::bit_mask::from(p_channel), m_object_created)) {
+      hal::safe_throw(hal::resource_unavailable_try_again(this));
+    }
+  }
+
+  hal::byte m_object_created = 0x00;  // tracks adapter channel reservations
+
+private:
+  static constexpr std::uint32_t default_avdd_microvolts = 3'300'000;
+  static constexpr hal::byte no_reference_channel = 0xFF;
+
+  void reset()
+  {
+    // TODO(#9): implement reset command
+  }
+
+  // Selects and reads each pin in p_channels, then hands the pin and the two
+  // bytes read to p_receive
+  template<class receiver>
+  void scan_each(hal::byte p_channels, receiver&& p_receive)
+  {
+    using namespace tla2528_registers;
+    for (hal::byte channel = 0; channel < channel_count; channel++) {
+      if (!hal::bit_extract(hal::bit_mask::from(channel), p_channels)) {
+        continue;
+      }
+
+      std::array<hal::byte, 2> data_buffer;
+      m_registers.insert<manual_channel_id>(channel);
+      if (m_registers.dirty(channel_sel::address)) {
+        std::array<hal::byte, 3> const select_buffer = {
+          op_codes::single_register_write,
+          channel_sel::address,
+          m_registers.get<channel_sel>(),
+        };
+        if (m_scan_mode == tla2528_scan_mode::combined) {
+          transaction(trace_op::tla2528_scan, select_buffer, data_buffer);
+        } else {
+          transaction(trace_op::tla2528_scan, select_buffer);
+          transaction(trace_op::tla2528_scan, {}, data_buffer);
+        }
+        m_registers.load(channel_sel::address,
+                         std::span(select_buffer).subspan(2));
+      } else {
+        transaction(trace_op::tla2528_scan, {}, data_buffer);
+      }
+      p_receive(channel, data_buffer);
+    }
+  }
+
+  void flush(trace_op p_op)
+  {
+    m_registers.flush(
+      [this, p_op](hal::byte p_register, std::span<hal::byte const> p_data) {
+        std::array<hal::byte, tla2528_registers::image::size + 2> buffer;
+        tracepoint(p_op, trace_phase::compute_begin);
+        auto const data = tla2528_registers::burst(buffer, p_register, p_data);
+        tracepoint(p_op, trace_phase::compute_end);
+        transaction(p_op, data);
+      },
+      tla2528_registers::max_burst_gap);
+  }
+
+  void transaction(trace_op p_op,
+                   std::span<hal::byte const> p_data_out,
+                   std::span<hal::byte> p_data_in = {})
+  {
+    tracepoint(p_op, trace_phase::bus_begin);
+    m_bus.transaction(*m_i2c, m_i2c_address, p_data_out, p_data_in);
+    tracepoint(p_op, trace_phase::bus_end);
+  }
+
+  bus_type* m_i2c;
+  hal::byte m_i2c_address;
+  // caches register values to reduce i2c requests
+  tla2528_registers::image m_registers{};
+  bus_guard m_bus{};
+  std::uint32_t m_reference_microvolts = default_avdd_microvolts;
+  hal::byte m_reference_channel = no_reference_channel;
+  tla2528_scan_mode m_scan_mode = tla2528_scan_mode::combined;
+};
+}  // namespace hal::expander
@@ -0,0 +1,294 @@
+// Copyright 2024 Khalil Estell
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+#include <libhal/error.hpp>
+#include <libhal/i2c.hpp>
+#include <libhal/units.hpp>
+
+#include <libhal-expander/pca9685_registers.hpp>
+#include <libhal-expander/tla2528_registers.hpp>
+
+namespace hal::expander {
+/**
+ * @brief Compile-time description of a pca9685 on a board
+ *
+ */
+struct pca9685_description
+{
+  /// Largest number of init script bytes a pca9685 can need
+  static constexpr std::size_t max_script_size = 80;
+
+  hal::byte address = 0b100'0000;
+  pca9685_settings settings{};
+  /// PWM frequency from 24 Hz to 1526 Hz. 0 keeps the power on frequency of
+  /// about 200 Hz.
+  hal::hertz frequency = 0.0f;
+  /// Bit field of the channels set to `initial_ticks`, bit 0 is channel 0.
+  /// Other channels keep their power on state of fully off.
+  std::uint16_t initial_channels = 0;
+  /// OFF tick of each channel in `initial_channels`, from 0 to 4095
+  std::array<std::uint16_t, 16> initial_ticks{};
+};
+
+/**
+ * @brief Compile-time description of a tla2528 on a board
+ *
+ */
+struct tla2528_description
+{
+  /// Largest number of init script bytes a tla2528 can need
+  static constexpr std::size_t max_script_size = 14;
+
+  hal::byte address = 0x10;
+  /// Mode of each pin, indexed by pin number
+  std::array<tla2528_pin_mode, 8> pin_modes{};
+  /// Bit field of output levels, bit 0 is pin 0
+  hal::byte initial_outputs = 0;
+};
+
+/**
+ * @brief Sequence of i2c writes that initializes the devices of a board
+ *
+ * Each write is stored as the device address, the number of bytes, and the
+ * bytes themselves. Scripts made by `make_init_script()` are sized exactly
+ * and can be placed in flash as `static constexpr` variables.
+ *
+ * @tparam capacity - number of bytes the script can hold
+ */
+template<std::size_t capacity>
+class init_script
+{
+public:
+  /**
+   * @brief Add a write to the script
+   *
+   * @param p_address - device address
+   * @param p_data - bytes to write, at most 255
+   * @throws hal::argument_out_of_domain - if the script is out of space,
+   * which fails compilation in a constant expression.
+   */
+  constexpr void append(hal::byte p_address, std::span<hal::byte const> p_data)
+  {
+    if (m_size + 2 + p_data.size() > capacity || p_data.size() > 255) {
+      throw hal::argument_out_of_domain(nullptr);
+    }
+    m_bytes[m_size++] = p_address;
+    m_bytes[m_size++] = static_cast<hal::byte>(p_data.size());
+    for (auto const value : p_data) {
+      m_bytes[m_size++] = value;
+    }
+    m_writes++;
+  }
+
+  /**
+   * @return std::span<hal::byte const> - the encoded script
+   */
+  [[nodiscard]] constexpr std::span<hal::byte const> bytes() const
+  {
+    return std::span(m_bytes).first(m_size);
+  }
+
+  /**
+   * @return std::size_t - number of bytes used by the script
+   */
+  [[nodiscard]] constexpr std::size_t size() const
+  {
+    return m_size;
+  }
+
+  /**
+   * @return std::size_t - number of i2c writes in the script
+   */
+  [[nodiscard]] constexpr std::size_t write_count() const
+  {
+    return m_writes;
+  }
+
+private:
+  std::array<hal::byte, capacity> m_bytes{};
+  std::size_t m_size = 0;
+  std::size_t m_writes = 0;
+};
+
+namespace board_detail {
+constexpr pca9685_registers::image registers(
+  pca9685_description const& p_device)
+{
+  using namespace pca9685_registers;
+
+  image result{};
+  insert_settings(result, p_device.settings);
+  for (hal::byte channel = 0; channel < 16; channel++) {
+    if (p_device.initial_channels & (1U << channel)) {
+      result.set(channel_address(channel),
+                 ticks_registers(p_device.initial_ticks[channel]));
+    }
+  }
+  return result;
+}
+
+constexpr tla2528_registers::image registers(
+  tla2528_description const& p_device)
+{
+  using namespace tla2528_registers;
+
+  image result{};
+  // Start from the power on values, which are all 0, and write the whole
+  // pin configuration so the result does not depend on the device's state.
+  std::array<hal::byte, pin_config_width> const power_on{};
+  result.load(pin_cfg::address, power_on);
+  for (hal::byte pin = 0; pin < channel_count; pin++) {
+    insert_pin_mode(result, p_device.pin_modes[pin], pin);
+  }
+  result.mark_dirty(pin_cfg::address, pin_config_width);
+  result.set<gpo_value>(p_device.initial_outputs);
+  return result;
+}
+
+template<class script>
+constexpr void append(script& p_script, pca9685_description const& p_device)
+{
+  using namespace pca9685_registers;
+
+  if (p_device.frequency != 0.0f) {
+    if (!frequency_in_range(p_device.frequency)) {
+      throw hal::argument_out_of_domain(nullptr);
+    }
+    // The prescaler can only be written while the device is asleep
+    auto sleeping = p_device.settings;
+    sleeping.sleep = true;
+    image sleep_registers{};
+    insert_settings(sleep_registers, sleeping);
+    std::array const sleep{ mode1::address, sleep_registers.get<mode1>() };
+    std::array const frequency{ prescaler::address,
+                                prescale(p_device.frequency) };
+    p_script.append(p_device.address, sleep);
+    p_script.append(p_device.address, frequency);
+  }
+
+  auto device_registers = registers(p_device);
+  device_registers.flush(
+    [&](hal::byte p_register, std::span<hal::byte const> p_data) {
+      std::array<hal::byte, image::size + 1> buffer{};
+      p_script.append(p_device.address, burst(buffer, p_register, p_data));
+    },
+    max_burst_gap);
+}
+
+template<class script>
+constexpr void append(script& p_script, tla2528_description const& p_device)
+{
+  using namespace tla2528_registers;
+
+  auto device_registers = registers(p_device);
+  device_registers.flush(
+    [&](hal::byte p_register, std::span<hal::byte const> p_data) {
+      std::array<hal::byte, image::size + 2> buffer{};
+      p_script.append(p_device.address, burst(buffer, p_register, p_data));
+    },
+    max_burst_gap);
+}
+
+template<auto... devices>
+constexpr auto full_init_script()
+{
+  init_script<(decltype(devices)::max_script_size + ...)> script;
+  (append(script, devices), ...);
+  return script;
+}
+}  // namespace board_detail
+
+/**
+ * @brief Generate the init script of a board at compile time
+ *
+ * The script writes every device's configuration with the fewest bursts,
+ * without reading anything back first.
+ *
+ * USAGE:
+ *
+ *    constexpr hal::expander::pca9685_description leds{
+ *      .address = 0x40,
+ *      .frequency = 1000.0f,
+ *    };
+ *    constexpr hal::expander::tla2528_description sensors{
+ *      .pin_modes = { hal::expander::tla2528_pin_mode::adc,
+ *                     hal::expander::tla2528_pin_mode::output_pin_push_pull },
+ *    };
+ *    static constexpr auto board_init =
+ *      hal::expander::make_init_script<leds, sensors>();
+ *
+ *    hal::expander::run_init_script(i2c, board_init.bytes());
+ *    hal::expander::pca9685 pca9685(i2c, initial_state(leds));
+ *    hal::expander::tla2528 tla2528(i2c, initial_state(sensors));
+ *
+ * @tparam devices - pca9685_description and tla2528_description constants
+ * @return init_script - script sized exactly to its contents
+ */
+template<auto... devices>
+constexpr auto make_init_script()
+{
+  constexpr auto full = board_detail::full_init_script<devices...>();
+  init_script<full.size()> exact;
+  auto const bytes = full.bytes();
+  for (std::size_t i = 0; i < bytes.size(); i += 2 + bytes[i + 1]) {
+    exact.append(bytes[i], bytes.subspan(i + 2, bytes[i + 1]));
+  }
+  return exact;
+}
+
+/**
+ * @param p_device - description of a pca9685
+ * @return pca9685_state - state of the device once its part of the init
+ * script has run
+ */
+constexpr pca9685_state initial_state(pca9685_description const& p_device)
+{
+  auto device_registers = board_detail::registers(p_device);
+  device_registers.flush([](hal::byte, std::span<hal::byte const>) {});
+  return { .address = p_device.address,
+           .settings = p_device.settings,
+           .registers = device_registers,
+           .prescale = p_device.frequency != 0.0f
+                         ? pca9685_registers::prescale(p_device.frequency)
+                         : pca9685_registers::power_on_prescale };
+}
+
+/**
+ * @param p_device - description of a tla2528
+ * @return tla2528_state - state of the device once its part of the init
+ * script has run
+ */
+constexpr tla2528_state initial_state(tla2528_description const& p_device)
+{
+  auto device_registers = board_detail::registers(p_device);
+  device_registers.flush([](hal::byte, std::span<hal::byte const>) {});
+  return { .address = p_device.address, .registers = device_registers };
+}
+
+/**
+ * @brief Perform every write of an init script in order
+ *
+ * @param p_i2c - bus the board's devices are on
+ * @param p_script - bytes of an init_script
+ * @throws hal::no_such_device - if a device does not acknowledge
+ */
+void run_init_script(hal::i2c& p_i2c, std::span<hal::byte const> p_script);
+}  // namespace hal::expander
@@ -0,0 +1,120 @@
+// Copyright 2024 Khalil Estell
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstdint>
+#include <span>
+
+#include <libhal/units.hpp>
+
+namespace hal::expander {
+/**
+ * @brief Implementations of the bulk conversion kernels
+ *
+ * Every backend produces bit-identical results. `automatic` picks the fastest
+ * backend the running CPU supports.
+ */
+enum class bulk_backend : hal::byte
+{
+  automatic,
+  scalar,
+  /// x86-64 baseline
+  sse2,
+  /// x86-64, selected at runtime if the CPU supports it
+  avx2,
+  /// AArch64 baseline
+  neon,
+};
+
+/**
+ * @param p_backend - backend to check
+ * @return true - if the backend was compiled in and the running CPU supports
+ * it. `automatic` and `scalar` are always supported.
+ */
+[[nodiscard]] bool bulk_backend_supported(bulk_backend p_backend);
+
+/**
+ * @brief Convert duty cycles to pca9685 channel register values
+ *
+ * Each duty cycle becomes the same 4 bytes, LEDn_ON_L through LEDn_OFF_H, as
+ * `pca9685_registers::duty_cycle_registers()`, so a frame can be sent to
+ * consecutive channels as one burst. Values below 0.0f and NaN are treated as
+ * 0.0f, values above 1.0f as 1.0f.
+ *
+ * @param p_duty_cycles - duty cycles from 0.0f to 1.0f
+ * @param p_registers - receives 4 bytes per duty cycle
+ * @param p_backend - implementation to use
+ * @throws hal::argument_out_of_domain - if p_registers is smaller than 4 bytes
+ * per duty cycle
+ * @throws hal::operation_not_supported - if the backend is not supported
+ */
+void duty_cycles_to_registers(std::span<float const> p_duty_cycles,
+                              std::span<hal::byte> p_registers,
+                              bulk_backend p_backend = bulk_backend::automatic);
+
+/**
+ * @brief Convert tla2528 conversion results to fractions of full scale
+ *
+ * Each result is the code divided by the converter's full scale of 4096
+ * codes. `tla2528::get_adc_reading()` divides by 4095 instead, so its largest
+ * code reads as 1.0.
+ *
+ * @param p_codes - 12-bit conversion results
+ * @param p_fractions - receives a value from 0.0f to 4095/4096 per code, the
+ * code divided by 4096 as in `codes_to_microvolts()`
+ * @param p_backend - implementation to use
+ * @throws hal::argument_out_of_domain - if p_fractions is smaller than p_codes
+ * @throws hal::operation_not_supported - if the backend is not supported
+ */
+void codes_to_fractions(std::span<std::uint16_t const> p_codes,
+                        std::span<float> p_fractions,
+                        bulk_backend p_backend = bulk_backend::automatic);
+
+/**
+ * @brief Convert tla2528 conversion results to microvolts
+ *
+ * Each result is the same as `tla2528_registers::code_to_microvolts()` with a
+ * fixed reference.
+ *
+ * @param p_codes - 12-bit conversion results
+ * @param p_reference_microvolts - AVDD in microvolts
+ * @param p_microvolts - receives the voltage of each code
+ * @param p_backend - implementation to use
+ * @throws hal::argument_out_of_domain - if p_microvolts is smaller than p_codes
+ * @throws hal::operation_not_supported - if the backend is not supported
+ */
+void codes_to_microvolts(std::span<std::uint16_t const> p_codes,
+                         std::uint32_t p_reference_microvolts,
+                         std::span<std::uint32_t> p_microvolts,
+                         bulk_backend p_backend = bulk_backend::automatic);
+
+/**
+ * @brief Convert tla2528 conversion results to millivolts
+ *
+ * Each result is the same as `tla2528::get_millivolts()` with a fixed
+ * reference.
+ *
+ * @param p_codes - 12-bit conversion results
+ * @param p_reference_microvolts - AVDD in microvolts
+ * @param p_millivolts - receives the voltage of each code
+ * @param p_backend - implementation to use
+ * @throws hal::argument_out_of_domain - if p_millivolts is smaller than p_codes
+ * @throws hal::operation_not_supported - if the backend is not supported
+ */
+void codes_to_millivolts(std::span<std::uint16_t const> p_codes,
+                         std::uint32_t p_reference_microvolts,
+                         std::span<std::uint32_t> p_millivolts,
+                         bulk_backend p_backend = bulk_backend::automatic);
+}  // namespace hal::expander
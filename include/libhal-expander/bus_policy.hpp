@@ -0,0 +1,207 @@
+// Copyright 2024 Khalil Estell
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <span>
+
+#include <libhal-util/steady_clock.hpp>
+#include <libhal/error.hpp>
+#include <libhal/steady_clock.hpp>
+#include <libhal/units.hpp>
+
+#include <libhal-expander/i2c_bus.hpp>
+
+namespace hal::expander {
+/**
+ * @brief Time and retry limits for a driver's i2c transactions
+ *
+ */
+struct bus_policy
+{
+  /// Longest a single transaction attempt may take before it is abandoned
+  /// with `hal::timed_out`.
+  hal::time_duration timeout = std::chrono::milliseconds(5);
+  /// Number of additional attempts made after an attempt fails
+  std::uint8_t retries = 2;
+  /// Delay before the first retry. Each following retry waits twice as long as
+  /// the one before it, up to `max_backoff_doublings` times.
+  hal::time_duration backoff = std::chrono::microseconds(250);
+
+  /// Number of times the backoff delay doubles before it stops growing, which
+  /// keeps the delay from overflowing for large retry counts.
+  static constexpr std::uint32_t max_backoff_doublings = 16;
+
+  /**
+   * @param p_retry - retry number, 0 for the first retry
+   * @return hal::time_duration - delay before the retry
+   */
+  [[nodiscard]] constexpr hal::time_duration backoff_delay(
+    std::uint32_t p_retry) const
+  {
+    auto const doublings = p_retry < max_backoff_doublings
+                             ? p_retry
+                             : max_backoff_doublings;
+    return backoff * (std::int64_t{ 1 } << doublings);
+  }
+
+  /**
+   * @brief Longest time a single guarded transaction can block the caller
+   *
+   * This is every attempt running into its timeout plus every backoff delay.
+   *
+   * @return hal::time_duration - upper bound on the latency of one transaction
+   */
+  [[nodiscard]] constexpr hal::time_duration worst_case_latency() const
+  {
+    auto total = timeout * (retries + 1);
+    for (std::uint32_t retry = 0; retry < retries; retry++) {
+      total += backoff_delay(retry);
+    }
+    return total;
+  }
+};
+
+/**
+ * @brief Runs i2c transactions under a bus_policy and records their latency
+ *
+ * A default constructed bus_guard has no clock. It never times out and never
+ * retries, which matches a plain `hal::write`/`hal::write_then_read` call.
+ *
+ * Once given a clock, each attempt is bounded by `bus_policy::timeout`. An
+ * attempt that fails with `hal::no_such_device` (NACK), `hal::io_error`,
+ * `hal::timed_out` or `hal::resource_unavailable_try_again` (lost arbitration)
+ * is retried after the backoff delay. When the retries run out the last error
+ * is rethrown to the caller. No other exception is retried.
+ */
+class bus_guard
+{
+public:
+  bus_guard() = default;
+
+  /**
+   * @param p_clock - clock used for timeouts, backoff and latency measurement.
+   * Must outlive this object.
+   * @param p_policy - limits to apply to each transaction
+   */
+  bus_guard(hal::steady_clock& p_clock, bus_policy const& p_policy);
+
+  /**
+   * @brief Perform an i2c transaction under the policy
+   *
+   * @tparam bus_type - i2c bus type, such as hal::i2c
+   * @param p_i2c - i2c bus to use
+   * @param p_address - device address
+   * @param p_data_out - bytes to write, may be empty
+   * @param p_data_in - bytes to read, may be empty
+   * @throws hal::timed_out - if the final attempt timed out
+   * @throws hal::no_such_device - if the final attempt was not acknowledged
+   * @throws hal::io_error - if the final attempt failed on the bus
+   * @throws hal::resource_unavailable_try_again - if the final attempt lost
+   * arbitration
+   */
+  template<i2c_bus bus_type>
+  void transaction(bus_type& p_i2c,
+                   hal::byte p_address,
+                   std::span<hal::byte const> p_data_out,
+                   std::span<hal::byte> p_data_in = {})
+  {
+    if (m_clock == nullptr) {
+      p_i2c.transaction(
+        p_address, p_data_out, p_data_in, hal::never_timeout());
+      return;
+    }
+
+    auto const start = m_clock->uptime();
+    for (std::uint32_t attempt = 0;; attempt++) {
+      try {
+        auto timeout = hal::create_timeout(*m_clock, m_policy.timeout);
+        p_i2c.transaction(p_address, p_data_out, p_data_in, timeout);
+        record_latency(start);
+        return;
+      } catch (hal::no_such_device const&) {
+        if (out_of_retries(attempt, start)) {
+          throw;
+        }
+      } catch (hal::io_error const&) {
+        if (out_of_retries(attempt, start)) {
+          throw;
+        }
+      } catch (hal::timed_out const&) {
+        if (out_of_retries(attempt, start)) {
+          throw;
+        }
+      } catch (hal::resource_unavailable_try_again const&) {
+        if (out_of_retries(attempt, start)) {
+          throw;
+        }
+      }
+      back_off(attempt);
+    }
+  }
+
+  /**
+   * @return bus_policy const& - policy in effect
+   */
+  [[nodiscard]] bus_policy const& policy() const;
+
+  /**
+   * @return true - if transactions are bounded by a clock
+   */
+  [[nodiscard]] bool bounded() const;
+
+  /**
+   * @return hal::time_duration - upper bound on the time a single transaction
+   * can take under this policy. Returns `hal::time_duration::max()` if the
+   * guard has no clock.
+   */
+  [[nodiscard]] hal::time_duration worst_case_latency() const;
+
+  /**
+   * @return hal::time_duration - longest time a transaction took, including
+   * retries, since construction or the last `reset_statistics()`. Always zero
+   * if the guard has no clock.
+   */
+  [[nodiscard]] hal::time_duration max_observed_latency() const;
+
+  /**
+   * @return std::uint32_t - number of retries performed
+   */
+  [[nodiscard]] std::uint32_t retry_count() const;
+
+  /**
+   * @return std::uint32_t - number of transactions that failed after using up
+   * all retries
+   */
+  [[nodiscard]] std::uint32_t failure_count() const;
+
+  /**
+   * @brief Clear the latency, retry and failure statistics
+   */
+  void reset_statistics();
+
+private:
+  void record_latency(std::uint64_t p_start);
+  bool out_of_retries(std::uint32_t p_attempt, std::uint64_t p_start);
+  void back_off(std::uint32_t p_attempt);
+
+  hal::steady_clock* m_clock = nullptr;
+  bus_policy m_policy{};
+  std::uint64_t m_max_observed_ticks = 0;
+  std::uint32_t m_retry_count = 0;
+  std::uint32_t m_failure_count = 0;
+};
+}  // namespace hal::expander
@@ -0,0 +1,152 @@
+// Copyright 2024 Khalil Estell
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <libhal/functional.hpp>
+
+namespace hal::expander {
+/**
+ * @brief Capability of an i2c implementation to chain transactions
+ *
+ * Implemented by `hal::i2c` implementations that can send the transactions
+ * made between `begin_sequence()` and `end_sequence()` as one sequence joined
+ * by repeated START conditions, with a STOP at the end. Reads and a full
+ * queue can send the sequence early, see `bus_session`.
+ */
+class i2c_sequencer
+{
+public:
+  /**
+   * @brief Start chaining transactions
+   *
+   * Sequences may be nested. The sequence is sent when the outermost one ends.
+   * Transactions that read may have to send the sequence so far in order to
+   * return their data, in which case the sequence continues after them.
+   */
+  void begin_sequence()
+  {
+    driver_begin_sequence();
+  }
+
+  /**
+   * @brief End a sequence and send it once the outermost sequence ends
+   *
+   * @throws any exception the implementation's transactions throw
+   */
+  void end_sequence()
+  {
+    driver_end_sequence();
+  }
+
+  virtual ~i2c_sequencer() = default;
+
+private:
+  virtual void driver_begin_sequence() = 0;
+  virtual void driver_end_sequence() = 0;
+};
+
+/**
+ * @brief Scope in which the operations of several devices on one bus are
+ * chained with repeated START conditions
+ *
+ * Ordinarily every driver call ends with a STOP, so updating a pca9685 and
+ * then reading a tla2528 releases the bus in between. Within a session the
+ * operations of every driver on the bus are chained into as few sequences as
+ * the bus allows, which saves a STOP and START per operation and narrows the
+ * windows in which another master on a multi-master bus can take the bus.
+ *
+ * A session does not hold the bus for its whole duration. A transaction that
+ * reads sends the sequence so far, itself included, followed by a STOP. A
+ * sequence that outgrows the bus's queue, such as more than
+ * `linux_i2c::max_messages` messages, is also sent with a STOP before it
+ * continues. The session then carries on with a new sequence, and another
+ * master can take the bus at each of those points.
+ *
+ * If the bus cannot chain transactions, a session is created without a
+ * sequencer and every operation is its own transaction, as without a session.
+ *
+ * Because chained writes are sent later, errors from them are reported by
+ * `commit()` or by the next read made in the session. A session destroyed
+ * without `commit()`, such as during an exception, still sends its chained
+ * writes but discards any error from them.
+ *
+ * A chained write succeeds as soon as it is queued, so drivers consider it
+ * written and are not able to retry it. If sending the sequence fails, the
+ * session calls its failure handler, which should call `resync()` on the
+ * drivers used in the session so that their next update writes their
+ * registers again. A read in the session that throws can also lose the
+ * writes chained before it, in which case the caller should resync them.
+ *
+ * USAGE:
+ *
+ *    hal::expander::linux_i2c i2c(file, batch_buffer);
+ *    hal::expander::pca9685 pca9685(i2c, 0b100'0000);
+ *    hal::expander::tla2528 tla2528(i2c);
+ *
+ *    auto pwm0 = pca9685.get_pwm_channel<0>();
+ *    auto pwm1 = pca9685.get_pwm_channel<1>();
+ *
+ *    hal::expander::bus_session session(&i2c, [&]() {
+ *      pca9685.resync();
+ *      tla2528.resync();
+ *    });
+ *    pwm0.duty_cycle(0.25f);
+ *    pwm1.duty_cycle(0.75f);                       // same sequence
+ *    auto const inputs = tla2528.get_input_bus();  // read sends the sequence
+ *    session.commit();
+ */
+class bus_session
+{
+public:
+  /**
+   * @param p_sequencer - sequencer of the bus, or nullptr if the bus cannot
+   * chain transactions. Must outlive this object.
+   * @param p_on_failure - called if sending the chained transactions fails,
+   * before the error is thrown or discarded
+   */
+  explicit bus_session(i2c_sequencer* p_sequencer,
+                       hal::callback<void()> p_on_failure = {});
+
+  bus_session(bus_session const&) = delete;
+  bus_session& operator=(bus_session const&) = delete;
+  bus_session(bus_session&&) = delete;
+  bus_session& operator=(bus_session&&) = delete;
+
+  /**
+   * @brief Ends the session if it has not been committed
+   */
+  ~bus_session();
+
+  /**
+   * @brief Send the chained transactions and end the session
+   *
+   * Does nothing if the session has already been committed. If sending
+   * fails, the failure handler is called before the error is thrown.
+   *
+   * @throws any exception the bus's transactions throw
+   */
+  void commit();
+
+  /**
+   * @return true - if the session has not been committed and its operations
+   * are chained
+   */
+  [[nodiscard]] bool chained() const;
+
+private:
+  i2c_sequencer* m_sequencer;
+  hal::callback<void()> m_on_failure;
+};
+}  // namespace hal::expander
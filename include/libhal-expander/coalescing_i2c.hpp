@@ -0,0 +1,133 @@
+// Copyright 2024 Khalil Estell
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstddef>
+#include <span>
+
+#include <libhal/i2c.hpp>
+#include <libhal/units.hpp>
+
+namespace hal::expander {
+/**
+ * @brief i2c wrapper that merges back to back register writes into bursts
+ *
+ * Devices such as the pca9685 take a register address as the first byte of a
+ * write followed by data, and auto increment the register address after each
+ * data byte. Writing channel 0 and then channel 1 as two transactions costs
+ * twice the start, address, and stop overhead of writing both in one burst.
+ *
+ * Between `begin_batch()` and `end_batch()`, write only transactions to one of
+ * the auto increment devices passed to the constructor are held in a buffer.
+ * A following write to the same device that starts at the register right after
+ * the held data is appended to it. Anything else, such as a read, a write to
+ * another device, a non-contiguous register, or a full buffer, first sends the
+ * held burst to the bus. Outside of a batch every transaction is forwarded
+ * as-is.
+ *
+ * Because held writes are sent later, an i2c error caused by a held write is
+ * reported by whichever call flushes it, usually `end_batch()`.
+ *
+ * USAGE:
+ *
+ *    std::array<hal::byte, 65> buffer;
+ *    std::array<hal::byte, 1> devices{ 0b100'0000 };
+ *    hal::expander::coalescing_i2c coalesced(i2c, buffer, devices);
+ *    hal::expander::pca9685 pca9685(coalesced, 0b100'0000);
+ *
+ *    coalesced.begin_batch();
+ *    pwm0.duty_cycle(0.25f);
+ *    pwm1.duty_cycle(0.50f);  // merged with the previous write
+ *    coalesced.end_batch();   // one burst reaches the bus
+ */
+class coalescing_i2c : public hal::i2c
+{
+public:
+  /**
+   * @brief Create a coalescing i2c wrapper
+   *
+   * @param p_i2c - i2c bus to forward transactions to
+   * @param p_buffer - storage for the held burst including its register
+   * address byte. Writes that do not fit are sent as separate bursts. Must
+   * outlive this object.
+   * @param p_auto_increment_devices - i2c addresses of devices whose writes are
+   * formatted as a register address followed by data, and auto increment the
+   * register address. Writes to any other device are never merged. Must
+   * outlive this object.
+   */
+  coalescing_i2c(hal::i2c& p_i2c,
+                 std::span<hal::byte> p_buffer,
+                 std::span<hal::byte const> p_auto_increment_devices);
+
+  coalescing_i2c(coalescing_i2c const&) = delete;
+  coalescing_i2c& operator=(coalescing_i2c const&) = delete;
+  coalescing_i2c(coalescing_i2c&&) = delete;
+  coalescing_i2c& operator=(coalescing_i2c&&) = delete;
+
+  /**
+   * @brief Start holding and merging writes
+   *
+   * Batches may be nested. Writes are held until the outermost batch ends.
+   */
+  void begin_batch();
+
+  /**
+   * @brief End a batch and send any held burst once the outermost batch ends
+   *
+   * @param p_timeout - timeout for the flushed burst
+   * @throws any exception thrown by the wrapped i2c's transaction
+   */
+  void end_batch(hal::function_ref<hal::timeout_function> p_timeout =
+                   hal::never_timeout());
+
+  /**
+   * @brief Send any held burst to the bus immediately
+   *
+   * @param p_timeout - timeout for the flushed burst
+   * @throws any exception thrown by the wrapped i2c's transaction
+   */
+  void flush(hal::function_ref<hal::timeout_function> p_timeout =
+               hal::never_timeout());
+
+  /**
+   * @return true - if a batch is active
+   */
+  [[nodiscard]] bool batching() const;
+
+  /**
+   * @return std::size_t - number of bytes currently held, including the
+   * register address byte
+   */
+  [[nodiscard]] std::size_t pending() const;
+
+private:
+  void driver_configure(settings const& p_settings) override;
+  void driver_transaction(
+    hal::byte p_address,
+    std::span<hal::byte const> p_data_out,
+    std::span<hal::byte> p_data_in,
+    hal::function_ref<hal::timeout_function> p_timeout) override;
+
+  bool auto_increments(hal::byte p_address) const;
+  bool try_append(hal::byte p_address, std::span<hal::byte const> p_data_out);
+
+  hal::i2c* m_i2c;
+  std::span<hal::byte> m_buffer;
+  std::span<hal::byte const> m_auto_increment_devices;
+  std::size_t m_pending = 0;
+  std::size_t m_depth = 0;
+  hal::byte m_pending_device = 0;
+};
+}  // namespace hal::expander
@@ -0,0 +1,120 @@
+// Copyright 2024 Khalil Estell
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <optional>
+#include <span>
+
+#include <libhal/units.hpp>
+
+namespace hal::expander {
+/**
+ * @brief How tla2528::scan() selects each channel
+ *
+ */
+enum class tla2528_scan_mode : hal::byte
+{
+  /// Select the channel and read its conversion in one write then read
+  /// transaction
+  combined = 0,
+  /// Select the channel with a write, then read the conversion in a second
+  /// transaction, for buses where a combined transaction is slow
+  split = 1,
+};
+
+/**
+ * @brief Update strategies of the expander drivers for one board
+ *
+ * Which strategy is fastest depends on the i2c implementation and clock rate
+ * of the board, so it is measured once with `autotune()` and stored with
+ * `serialize()`, such as in flash or a file. Later boots restore it with
+ * `deserialize()` and hand it to each driver's `set_policy()`.
+ */
+struct expander_policy
+{
+  /// Size of the serialized policy in bytes
+  static constexpr std::size_t serialized_size = 5;
+  /// Smallest stored `pca9685_burst_gap`. Bridging one or two bytes is never
+  /// more bytes than starting a new transaction, so smaller gaps are never
+  /// chosen by `autotune()`.
+  static constexpr hal::byte min_pca9685_burst_gap = 2;
+
+  /// Longest run of unchanged pca9685 registers rewritten to merge the changed
+  /// registers on either side into one burst
+  hal::byte pca9685_burst_gap = 2;
+  /// How tla2528 scans select channels
+  tla2528_scan_mode tla2528_scan = tla2528_scan_mode::combined;
+
+  /**
+   * @return std::array<hal::byte, serialized_size> - the policy with a format
+   * marker, version and checksum
+   */
+  [[nodiscard]] constexpr std::array<hal::byte, serialized_size> serialize()
+    const
+  {
+    std::array<hal::byte, serialized_size> bytes{
+      marker,
+      version,
+      pca9685_burst_gap,
+      static_cast<hal::byte>(tla2528_scan),
+      0,
+    };
+    bytes.back() = checksum(std::span(bytes).first(serialized_size - 1));
+    return bytes;
+  }
+
+  /**
+   * @param p_bytes - bytes produced by `serialize()`
+   * @return std::optional<expander_policy> - the stored policy, or
+   * std::nullopt if the bytes are not a valid policy of this version, in which
+   * case the board should be tuned again.
+   */
+  [[nodiscard]] static constexpr std::optional<expander_policy> deserialize(
+    std::span<hal::byte const> p_bytes)
+  {
+    if (p_bytes.size() != serialized_size || p_bytes[0] != marker ||
+        p_bytes[1] != version ||
+        p_bytes.back() != checksum(p_bytes.first(serialized_size - 1)) ||
+        p_bytes[2] < min_pca9685_burst_gap ||
+        p_bytes[3] > static_cast<hal::byte>(tla2528_scan_mode::split)) {
+      return std::nullopt;
+    }
+    return expander_policy{
+      .pca9685_burst_gap = p_bytes[2],
+      .tla2528_scan = static_cast<tla2528_scan_mode>(p_bytes[3]),
+    };
+  }
+
+  constexpr bool operator==(expander_policy const&) const = default;
+
+private:
+  static constexpr hal::byte marker = 0xE5;
+  static constexpr hal::byte version = 1;
+
+  static constexpr hal::byte checksum(std::span<hal::byte const> p_bytes)
+  {
+    hal::byte sum = 0;
+    for (auto const value : p_bytes) {
+      sum = static_cast<hal::byte>(sum * 31 + value);
+    }
+    return sum;
+  }
+};
+
+/// Gives autotune() access to driver internals, defined in autotune.cpp
+struct autotune_access;
+}  // namespace hal::expander
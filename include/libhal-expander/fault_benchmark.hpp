@@ -0,0 +1,84 @@
+// Copyright 2024 Khalil Estell
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+#include <libhal-expander/bus_policy.hpp>
+#include <libhal-expander/fault_injector.hpp>
+#include <libhal-expander/simulation.hpp>
+
+namespace hal::expander {
+/**
+ * @brief Fault load and driver policy of `benchmark_under_faults()`
+ *
+ */
+struct fault_benchmark_settings
+{
+  /// Faults injected at random into every transaction
+  fault_rates faults{ .nack = 0.01f, .stretch = 0.05f };
+  /// Timeout, retry and backoff limits of both drivers
+  bus_policy policy{};
+  /// Number of times each operation is run
+  std::uint32_t iterations = 1000;
+  /// Seed of the random fault sequence, must not be 0
+  std::uint32_t seed = 1;
+};
+
+/**
+ * @brief Latency of each driver operation under fault load
+ *
+ */
+struct fault_benchmark_report
+{
+  /// `pca9685::duty_cycle()` of one channel
+  latency_report pca9685_duty_cycle{};
+  /// `pca9685::set_channel_ticks()` of all 16 channels
+  latency_report pca9685_channel_ticks{};
+  /// `tla2528::get_adc_reading()` of one pin
+  latency_report tla2528_adc_reading{};
+  /// `tla2528::scan()` of all 8 pins
+  latency_report tla2528_scan{};
+  /// Retries made by the drivers' bus policies
+  std::uint32_t retries = 0;
+  /// Faults injected, indexed by `i2c_fault`
+  std::array<std::uint32_t, 5> injected{};
+};
+
+/**
+ * @brief Report p50/p99/max latency of the pca9685 and tla2528 operations on
+ * a simulated bus that injects faults
+ *
+ * Builds a simulated bus with a pca9685 at 0x40 and a tla2528 at its default
+ * address behind a `fault_injector`, applies `p_settings.policy` to both
+ * drivers and runs each operation with `measure_latency()`. The drivers are
+ * created before faults are injected. Results are reproducible for a given
+ * seed, so timeout and retry limits can be compared against each other.
+ *
+ * USAGE:
+ *
+ *    auto const report = hal::expander::benchmark_under_faults({
+ *      .faults = { .nack = 0.05f, .max_stretch = 2ms },
+ *      .policy = { .timeout = 1ms, .retries = 3 },
+ *    });
+ *    // report.tla2528_scan.p99 is the 99th percentile scan latency
+ *
+ * @param p_settings - fault load, policy and iteration count
+ * @return fault_benchmark_report - latency of each operation
+ */
+[[nodiscard]] fault_benchmark_report benchmark_under_faults(
+  fault_benchmark_settings const& p_settings = {});
+}  // namespace hal::expander
@@ -0,0 +1,168 @@
+// Copyright 2024 Khalil Estell
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include <libhal/i2c.hpp>
+#include <libhal/units.hpp>
+
+#include <libhal-expander/simulation.hpp>
+
+namespace hal::expander {
+/**
+ * @brief Kinds of faults a fault_injector can inject into a transaction
+ *
+ */
+enum class i2c_fault : hal::byte
+{
+  /// Transaction passes through untouched
+  none,
+  /// The device does not acknowledge its address. Throws
+  /// hal::no_such_device without reaching the bus.
+  nack,
+  /// Another controller wins arbitration. Throws
+  /// hal::resource_unavailable_try_again without reaching the bus.
+  arbitration_lost,
+  /// The device stretches the clock before the transaction proceeds. The
+  /// transaction's timeout is polled while the clock is held.
+  stretch,
+  /// One bit of the bytes read is flipped
+  corrupt_read,
+};
+
+/**
+ * @brief A fault to inject into one transaction
+ *
+ */
+struct fault
+{
+  i2c_fault kind = i2c_fault::none;
+  /// How long the clock is held for `i2c_fault::stretch`
+  hal::time_duration stretch{};
+};
+
+/**
+ * @brief Probability of each fault being injected into a transaction
+ *
+ * At most one fault is injected per transaction. The probabilities are
+ * checked in declaration order and should sum to at most 1.0f.
+ */
+struct fault_rates
+{
+  float nack = 0.0f;
+  float arbitration_lost = 0.0f;
+  float stretch = 0.0f;
+  float corrupt_read = 0.0f;
+  /// Clock stretches last a random duration up to this
+  hal::time_duration max_stretch = hal::time_duration(1'000'000);
+};
+
+/**
+ * @brief hal::i2c wrapper that injects faults into transactions
+ *
+ * Wraps a bus, normally a `simulated_i2c`, and injects NACKs, lost
+ * arbitration, clock stretching and corrupted read data. Faults are taken
+ * from a script first, one per transaction, and then drawn at random from the
+ * configured rates. The random sequence is reproducible for a given seed.
+ *
+ * USAGE:
+ *
+ *    hal::expander::simulated_clock clock;
+ *    hal::expander::simulated_i2c bus(clock);
+ *    hal::expander::simulated_pca9685 device;
+ *    bus.attach(0b100'0000, device);
+ *    hal::expander::fault_injector i2c(bus, clock);
+ *    i2c.randomize({ .nack = 0.01f, .stretch = 0.05f });
+ *
+ *    hal::expander::pca9685 pca9685(i2c, 0b100'0000);
+ *    pca9685.set_bus_policy(clock, { .timeout = 500us, .retries = 3 });
+ *    auto pwm0 = pca9685.get_pwm_channel<0>();
+ *    auto report = hal::expander::measure_latency(
+ *      clock, 10'000, [&pwm0]() { pwm0.duty_cycle(0.5f); });
+ */
+class fault_injector : public hal::i2c
+{
+public:
+  /**
+   * @param p_bus - bus to forward transactions to. Must outlive this object.
+   * @param p_clock - clock advanced while the clock is stretched. Must outlive
+   * this object.
+   * @param p_seed - seed of the random fault sequence, must not be 0
+   */
+  fault_injector(hal::i2c& p_bus,
+                 simulated_clock& p_clock,
+                 std::uint32_t p_seed = 1);
+
+  /**
+   * @brief Inject faults at random
+   *
+   * @param p_rates - probability of each fault per transaction
+   */
+  void randomize(fault_rates const& p_rates);
+
+  /**
+   * @brief Inject a scripted sequence of faults
+   *
+   * Each upcoming transaction takes the next fault in the script, replacing
+   * any remaining script. Random faults resume once the script is exhausted.
+   *
+   * @param p_faults - faults for the upcoming transactions in order
+   */
+  void script(std::span<fault const> p_faults);
+
+  /**
+   * @brief Stop injecting faults and clear the statistics
+   *
+   */
+  void clear();
+
+  /**
+   * @param p_kind - kind of fault
+   * @return std::uint32_t - number of times the fault was injected
+   */
+  [[nodiscard]] std::uint32_t injected(i2c_fault p_kind) const;
+
+  /**
+   * @return std::uint32_t - number of transactions seen
+   */
+  [[nodiscard]] std::uint32_t transaction_count() const;
+
+private:
+  void driver_configure(settings const& p_settings) override;
+  void driver_transaction(
+    hal::byte p_address,
+    std::span<hal::byte const> p_data_out,
+    std::span<hal::byte> p_data_in,
+    hal::function_ref<hal::timeout_function> p_timeout) override;
+
+  fault next_fault();
+  std::uint32_t random();
+  float random_fraction();
+
+  hal::i2c* m_bus;
+  simulated_clock* m_clock;
+  std::uint32_t m_state;
+  fault_rates m_rates{};
+  std::vector<fault> m_script{};
+  std::size_t m_script_position = 0;
+  std::array<std::uint32_t, 5> m_injected{};
+  std::uint32_t m_transaction_count = 0;
+};
+}  // namespace hal::expander
@@ -0,0 +1,38 @@
+// Copyright 2024 Khalil Estell
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <span>
+
+#include <libhal/timeout.hpp>
+#include <libhal/units.hpp>
+
+namespace hal::expander {
+/**
+ * @brief Any type that can perform i2c transactions like `hal::i2c`
+ *
+ * `hal::i2c` itself models this concept, as does every class derived from it.
+ * Drivers templated on a concrete bus type, preferably one marked `final`,
+ * let the compiler resolve and inline the transaction instead of making a
+ * virtual call through `hal::i2c`.
+ */
+template<class T>
+concept i2c_bus = requires(T& p_bus,
+                           hal::byte p_address,
+                           std::span<hal::byte const> p_data_out,
+                           std::span<hal::byte> p_data_in) {
+  p_bus.transaction(p_address, p_data_out, p_data_in, hal::never_timeout());
+};
+}  // namespace hal::expander
@@ -0,0 +1,331 @@
+// Copyright 2024 Khalil Estell
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+
+#include <libhal-util/bit.hpp>
+#include <libhal/error.hpp>
+#include <libhal/units.hpp>
+
+#include <libhal-expander/tla2528.hpp>
+
+namespace hal::expander {
+namespace linearization_detail {
+/**
+ * @brief Natural logarithm usable in constant expressions
+ *
+ * @param p_value - value greater than 0
+ * @return double - ln(p_value)
+ */
+constexpr double log(double p_value)
+{
+  constexpr double ln2 = 0.693147180559945309417;
+
+  // Reduce to [1, 2), then ln(x) = 2 * atanh((x - 1) / (x + 1)) which
+  // converges quickly as the argument is below 1/3.
+  int exponent = 0;
+  while (p_value >= 2.0) {
+    p_value /= 2.0;
+    exponent++;
+  }
+  while (p_value < 1.0) {
+    p_value *= 2.0;
+    exponent--;
+  }
+
+  double const y = (p_value - 1.0) / (p_value + 1.0);
+  double const y_squared = y * y;
+  double term = y;
+  double sum = 0.0;
+  for (int n = 1; n < 40; n += 2) {
+    sum += term / n;
+    term *= y_squared;
+  }
+  return 2.0 * sum + exponent * ln2;
+}
+
+/// Ratio of a 12-bit code to full scale, kept away from 0 and 1 where a
+/// divider's resistance is 0 or infinite
+constexpr double code_ratio(double p_code)
+{
+  constexpr double full_scale = 4096.0;
+  auto const code = p_code < 0.5              ? 0.5
+                    : p_code > full_scale - 0.5 ? full_scale - 0.5
+                                                : p_code;
+  return code / full_scale;
+}
+
+/// Resistance of the thermistor in a divider from the reading's ratio
+constexpr double thermistor_resistance(double p_ratio,
+                                       double p_series_resistance,
+                                       bool p_thermistor_on_high_side)
+{
+  if (p_thermistor_on_high_side) {
+    return p_series_resistance * (1.0 - p_ratio) / p_ratio;
+  }
+  return p_series_resistance * p_ratio / (1.0 - p_ratio);
+}
+
+constexpr double kelvin_offset = 273.15;
+}  // namespace linearization_detail
+
+/**
+ * @brief Interpolated lookup table from a 12-bit code to milli-units
+ *
+ * The code range is split into `segments` equal segments. Converting a code
+ * takes a shift, a mask, a multiply and an add. Tables are generated at
+ * compile time with `make_linearization_table()`.
+ *
+ * @tparam segments - number of segments, a power of 2 up to 4096. More
+ * segments trade memory for accuracy on strongly curved sensors.
+ */
+template<std::size_t segments>
+struct linearization_table
+{
+  static_assert(std::has_single_bit(segments) && segments <= 4096,
+                "segments must be a power of 2 up to 4096");
+
+  /// log2 of the number of codes in one segment
+  static constexpr int shift = 12 - std::countr_zero(segments);
+
+  /// milli-unit value at the start of each segment, and at code 4096
+  std::array<std::int32_t, segments + 1> knots{};
+
+  /**
+   * @param p_code - 12-bit code, larger values are limited to 4095
+   * @return std::int32_t - value in milli-units
+   */
+  [[nodiscard]] constexpr std::int32_t operator()(std::uint16_t p_code) const
+  {
+    constexpr std::uint32_t max_code = 4095;
+    constexpr std::uint32_t fraction_mask = (1U << shift) - 1U;
+
+    auto const code = p_code < max_code ? std::uint32_t{ p_code } : max_code;
+    auto const index = code >> shift;
+    auto const fraction = static_cast<std::int64_t>(code & fraction_mask);
+    auto const start = knots[index];
+    auto const rise = std::int64_t{ knots[index + 1] } - start;
+    return static_cast<std::int32_t>(start + ((rise * fraction) >> shift));
+  }
+};
+
+/**
+ * @brief Generate a linearization table from a conversion function
+ *
+ * Intended to be evaluated at compile time, so the conversion function may
+ * use floating point and the logarithm in `linearization_detail` freely.
+ *
+ * @tparam segments - number of segments of the table
+ * @param p_function - callable taking a code as a double, from 0 to 4096, and
+ * returning the value in whole units
+ * @return linearization_table<segments> - table in milli-units
+ */
+template<std::size_t segments, class Function>
+constexpr linearization_table<segments> make_linearization_table(
+  Function p_function)
+{
+  linearization_table<segments> table{};
+  constexpr double codes_per_segment = 4096.0 / segments;
+  for (std::size_t i = 0; i < table.knots.size(); i++) {
+    double const milli =
+      p_function(static_cast<double>(i) * codes_per_segment) * 1000.0;
+    table.knots[i] = static_cast<std::int32_t>(milli < 0.0 ? milli - 0.5
+                                                            : milli + 0.5);
+  }
+  return table;
+}
+
+/**
+ * @brief NTC thermistor described by its Beta value
+ *
+ */
+struct ntc_beta
+{
+  /// Resistance in ohms at the nominal temperature
+  double nominal_resistance = 10'000.0;
+  /// Temperature in degrees Celsius at which the nominal resistance applies
+  double nominal_temperature = 25.0;
+  /// Beta value in kelvin
+  double beta = 3950.0;
+  /// Resistance in ohms of the other resistor of the divider
+  double series_resistance = 10'000.0;
+  /// true if the thermistor connects to the reference voltage and the series
+  /// resistor to ground
+  bool thermistor_on_high_side = false;
+
+  /**
+   * @param p_code - 12-bit code read from the divider
+   * @return double - temperature in degrees Celsius
+   */
+  constexpr double operator()(double p_code) const
+  {
+    using namespace linearization_detail;
+    auto const resistance = thermistor_resistance(
+      code_ratio(p_code), series_resistance, thermistor_on_high_side);
+    auto const inverse_kelvin =
+      1.0 / (nominal_temperature + kelvin_offset) +
+      log(resistance / nominal_resistance) / beta;
+    return 1.0 / inverse_kelvin - kelvin_offset;
+  }
+};
+
+/**
+ * @brief Thermistor described by Steinhart-Hart coefficients
+ *
+ * 1/T = a + b * ln(R) + c * ln(R)^3, with T in kelvin and R in ohms
+ */
+struct ntc_steinhart_hart
+{
+  double a;
+  double b;
+  double c;
+  /// Resistance in ohms of the other resistor of the divider
+  double series_resistance = 10'000.0;
+  /// true if the thermistor connects to the reference voltage and the series
+  /// resistor to ground
+  bool thermistor_on_high_side = false;
+
+  /**
+   * @param p_code - 12-bit code read from the divider
+   * @return double - temperature in degrees Celsius
+   */
+  constexpr double operator()(double p_code) const
+  {
+    using namespace linearization_detail;
+    auto const resistance = thermistor_resistance(
+      code_ratio(p_code), series_resistance, thermistor_on_high_side);
+    auto const ln_r = log(resistance);
+    auto const inverse_kelvin = a + b * ln_r + c * ln_r * ln_r * ln_r;
+    return 1.0 / inverse_kelvin - kelvin_offset;
+  }
+};
+
+/**
+ * @brief A measured point of a sensor's response
+ *
+ */
+struct linearization_point
+{
+  /// 12-bit code read
+  double code;
+  /// value in whole units at the code
+  double value;
+};
+
+/**
+ * @brief Sensor described by a list of measured points
+ *
+ * Values between points are linearly interpolated, and values beyond the
+ * first and last points extrapolated from the nearest two points.
+ *
+ * @tparam count - number of points, at least 2
+ */
+template<std::size_t count>
+struct point_list
+{
+  static_assert(count >= 2, "at least two points are required");
+
+  /// points sorted by ascending code
+  std::array<linearization_point, count> points;
+
+  /**
+   * @param p_code - 12-bit code
+   * @return double - interpolated value in whole units
+   */
+  constexpr double operator()(double p_code) const
+  {
+    std::size_t upper = 1;
+    while (upper < count - 1 && points[upper].code < p_code) {
+      upper++;
+    }
+    auto const& low = points[upper - 1];
+    auto const& high = points[upper];
+    auto const slope = (high.value - low.value) / (high.code - low.code);
+    return low.value + slope * (p_code - low.code);
+  }
+};
+
+/**
+ * @brief A tla2528 analog input converted to engineering units
+ *
+ * USAGE:
+ *
+ *    static constexpr auto ntc_table =
+ *      hal::expander::make_linearization_table<64>(hal::expander::ntc_beta{
+ *        .beta = 3435.0 });
+ *    hal::expander::tla2528_sensor temperature(tla2528, 2, ntc_table);
+ *    std::int32_t const milli_celsius = temperature.read();
+ *
+ * @tparam segments - number of segments of the table
+ */
+template<std::size_t segments>
+class tla2528_sensor
+{
+public:
+  /**
+   * @param p_tla2528 - device the sensor is connected to. Must outlive this
+   * object.
+   * @param p_channel - analog input pin of the sensor. Its pin mode is set
+   * to adc and the pin is reserved until this object is destroyed.
+   * @param p_table - conversion table. Must outlive this object.
+   * @throws hal::argument_out_of_domain - if p_channel out of range (>7)
+   * @throws hal::resource_unavailable_try_again - if p_channel is already in
+   * use by another adapter or sensor
+   */
+  tla2528_sensor(tla2528& p_tla2528,
+                 hal::byte p_channel,
+                 linearization_table<segments> const& p_table)
+    : m_tla2528(&p_tla2528)
+    , m_table(&p_table)
+    , m_channel(p_channel)
+  {
+    m_tla2528->throw_if_invalid_channel(m_channel);
+    m_tla2528->throw_if_channel_occupied(m_channel);
+    m_tla2528->set_pin_mode(tla2528::pin_mode::adc, m_channel);
+    hal::bit_modify(m_tla2528->m_object_created)
+      .set(hal::bit_mask::from(m_channel));
+  }
+
+  tla2528_sensor(tla2528_sensor const&) = delete;
+  tla2528_sensor& operator=(tla2528_sensor const&) = delete;
+
+  ~tla2528_sensor()
+  {
+    hal::bit_modify(m_tla2528->m_object_created)
+      .clear(hal::bit_mask::from(m_channel));
+  }
+
+  /**
+   * @brief Sample the sensor
+   *
+   * @return std::int32_t - value in milli-units
+   */
+  [[nodiscard]] std::int32_t read()
+  {
+    std::array<std::uint16_t, 8> codes{};
+    m_tla2528->scan(static_cast<hal::byte>(1U << m_channel), codes);
+    return (*m_table)(codes[m_channel]);
+  }
+
+private:
+  tla2528* m_tla2528;
+  linearization_table<segments> const* m_table;
+  hal::byte m_channel;
+};
+}  // namespace hal::expander
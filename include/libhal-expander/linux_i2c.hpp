@@ -0,0 +1,235 @@
+// Copyright 2024 Khalil Estell
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+#include <libhal/i2c.hpp>
+#include <libhal/units.hpp>
+
+#include <libhal-expander/bus_session.hpp>
+
+namespace hal::expander {
+/**
+ * @brief One message of an I2C_RDWR combined transaction
+ *
+ * Mirrors `struct i2c_msg` from `<linux/i2c.h>` so that this header does not
+ * depend on Linux headers and can be used with a fake file on any host.
+ */
+struct i2c_dev_message
+{
+  /// 7-bit device address
+  hal::byte address;
+  /// true for a read message, false for a write message
+  bool read;
+  /// bytes to write or storage for bytes read. Write messages are never
+  /// modified.
+  std::span<hal::byte> data;
+};
+
+/**
+ * @brief The file descriptor layer beneath linux_i2c
+ *
+ * The real implementation, `linux_i2c_dev_file`, issues the I2C_RDWR ioctl on
+ * an open `/dev/i2c-N` file. Tests substitute their own implementation to
+ * observe the messages handed to the kernel and inject errors.
+ */
+class i2c_dev_file
+{
+public:
+  /**
+   * @brief Submit messages as one combined transaction
+   *
+   * Messages are separated by repeated START conditions and the transaction
+   * ends with a single STOP.
+   *
+   * @param p_messages - messages in bus order
+   * @return int - 0 on success, otherwise the errno value of the failure
+   */
+  int rdwr(std::span<i2c_dev_message const> p_messages)
+  {
+    return driver_rdwr(p_messages);
+  }
+
+  virtual ~i2c_dev_file() = default;
+
+private:
+  virtual int driver_rdwr(std::span<i2c_dev_message const> p_messages) = 0;
+};
+
+#if defined(__linux__)
+/**
+ * @brief i2c_dev_file for a Linux `/dev/i2c-N` character device
+ *
+ */
+class linux_i2c_dev_file : public i2c_dev_file
+{
+public:
+  /**
+   * @param p_path - path to the i2c character device such as "/dev/i2c-1"
+   * @throws hal::no_such_device - if the device file cannot be opened
+   */
+  explicit linux_i2c_dev_file(char const* p_path);
+
+  linux_i2c_dev_file(linux_i2c_dev_file const&) = delete;
+  linux_i2c_dev_file& operator=(linux_i2c_dev_file const&) = delete;
+  linux_i2c_dev_file(linux_i2c_dev_file&& p_other) noexcept;
+  linux_i2c_dev_file& operator=(linux_i2c_dev_file&& p_other) noexcept;
+  ~linux_i2c_dev_file() override;
+
+private:
+  int driver_rdwr(std::span<i2c_dev_message const> p_messages) override;
+
+  int m_file_descriptor = -1;
+};
+#endif
+
+/**
+ * @brief hal::i2c implementation for Linux i2c-dev using I2C_RDWR
+ *
+ * Every transaction is made with a single ioctl. A write followed by a read is
+ * sent as one combined transaction with a repeated START between the two, and
+ * not as two separate system calls.
+ *
+ * Between `begin_batch()` and `end_batch()`, write only transactions, such as
+ * pca9685 duty cycle updates, are copied into the batch buffer and queued. A
+ * transaction that reads, such as a tla2528 register read, is appended to the
+ * queue and the whole queue is submitted with it in one ioctl. Transactions
+ * that must read back data later can be queued explicitly with
+ * `queue_read()` so an entire scan is submitted in one ioctl. Because queued
+ * writes are sent later, an error caused by one is reported by whichever call
+ * submits it.
+ *
+ * As an `i2c_sequencer`, a sequence is a batch, so a `bus_session` chains the
+ * operations of every device on the bus into as few ioctls as possible.
+ *
+ * The kernel adapter's own timeout applies to each ioctl. The timeout
+ * callback passed to a transaction is only polled before submission.
+ *
+ * USAGE:
+ *
+ *    hal::expander::linux_i2c_dev_file file("/dev/i2c-1");
+ *    std::array<hal::byte, 256> batch_buffer;
+ *    hal::expander::linux_i2c i2c(file, batch_buffer);
+ *    hal::expander::pca9685 pca9685(i2c, 0b100'0000);
+ *
+ *    i2c.begin_batch();
+ *    pwm0.duty_cycle(0.25f);
+ *    pwm1.duty_cycle(0.50f);
+ *    i2c.end_batch();  // one ioctl for both updates
+ */
+class linux_i2c
+  : public hal::i2c
+  , public i2c_sequencer
+{
+public:
+  /// Largest number of messages the kernel accepts in one I2C_RDWR ioctl
+  static constexpr std::size_t max_messages = 42;
+
+  /**
+   * @param p_file - i2c-dev file to submit transactions to. Must outlive this
+   * object.
+   * @param p_batch_buffer - storage for the data of queued writes. If empty,
+   * write only transactions are never queued. Must outlive this object.
+   */
+  explicit linux_i2c(i2c_dev_file& p_file,
+                     std::span<hal::byte> p_batch_buffer = {});
+
+  linux_i2c(linux_i2c const&) = delete;
+  linux_i2c& operator=(linux_i2c const&) = delete;
+  linux_i2c(linux_i2c&&) = delete;
+  linux_i2c& operator=(linux_i2c&&) = delete;
+
+  /**
+   * @brief Start queueing write only transactions
+   *
+   * Batches may be nested. The queue is submitted when the outermost batch
+   * ends.
+   */
+  void begin_batch();
+
+  /**
+   * @brief End a batch and submit the queue once the outermost batch ends
+   *
+   * @throws hal::no_such_device - if a device did not acknowledge. If the
+   * batch addressed several devices, each is probed with a zero length write
+   * to report the address of the one that does not respond.
+   * @throws hal::timed_out - if the kernel adapter timed out
+   * @throws hal::resource_unavailable_try_again - if arbitration was lost
+   * @throws hal::io_error - for any other failure
+   */
+  void end_batch();
+
+  /**
+   * @brief Queue a write then read transaction to run on the next submission
+   *
+   * Unlike `hal::write_then_read()`, this returns before `p_data_in` is filled.
+   * Both spans must remain valid until `submit()` or `end_batch()` returns.
+   * If the queue is full, it is submitted first.
+   *
+   * @param p_address - device address
+   * @param p_data_out - bytes to write before the read, may be empty
+   * @param p_data_in - storage for the bytes read
+   */
+  void queue_read(hal::byte p_address,
+                  std::span<hal::byte const> p_data_out,
+                  std::span<hal::byte> p_data_in);
+
+  /**
+   * @brief Submit every queued message in one ioctl
+   *
+   * @throws see end_batch()
+   */
+  void submit();
+
+  /**
+   * @return std::size_t - number of messages waiting to be submitted
+   */
+  [[nodiscard]] std::size_t queued() const;
+
+  /**
+   * @return std::uint32_t - number of I2C_RDWR system calls made
+   */
+  [[nodiscard]] std::uint32_t syscall_count() const;
+
+private:
+  void driver_configure(settings const& p_settings) override;
+  void driver_transaction(
+    hal::byte p_address,
+    std::span<hal::byte const> p_data_out,
+    std::span<hal::byte> p_data_in,
+    hal::function_ref<hal::timeout_function> p_timeout) override;
+  void driver_begin_sequence() override;
+  void driver_end_sequence() override;
+
+  void append_write(hal::byte p_address,
+                    std::span<hal::byte const> p_data_out);
+  void append_read(hal::byte p_address, std::span<hal::byte> p_data_in);
+  void reserve(std::size_t p_messages, std::size_t p_bytes);
+  hal::byte unresponsive_address(std::span<i2c_dev_message const> p_messages);
+  void throw_on_error(int p_error, std::span<i2c_dev_message const> p_messages);
+
+  i2c_dev_file* m_file;
+  std::span<hal::byte> m_batch_buffer;
+  std::array<i2c_dev_message, max_messages> m_messages{};
+  std::size_t m_message_count = 0;
+  std::size_t m_buffer_used = 0;
+  std::size_t m_depth = 0;
+  std::uint32_t m_syscall_count = 0;
+};
+}  // namespace hal::expander
@@ -0,0 +1,173 @@
+// Copyright 2024 Khalil Estell
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#if defined(__linux__)
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <libhal/functional.hpp>
+#include <libhal/i2c.hpp>
+#include <libhal/units.hpp>
+
+#include <libhal-expander/snapshot_buffer.hpp>
+
+namespace hal::expander {
+/**
+ * @brief Runs the work of several independent i2c buses in parallel
+ *
+ * Host side only. On a Linux gateway with several i2c adapters, every bus can
+ * transfer at the same time, but a single application thread serializes them.
+ * The engine gives each bus its own worker thread, optionally pinned to a CPU
+ * core. Each worker repeatedly runs the jobs added for its bus, such as a
+ * tla2528 scan or a pca9685 frame commit, in the order they were added.
+ *
+ * Jobs publish their results through `snapshot_buffer`s so consumers on other
+ * threads can read the latest complete result without locks. Jobs for one bus
+ * only ever run on that bus's worker, so drivers owned by a bus need no
+ * locking. An exception escaping a job is counted in `errors()` and the
+ * worker continues with the next job.
+ *
+ * USAGE:
+ *
+ *    hal::expander::snapshot_buffer<std::array<float, 8>> readings;
+ *    hal::expander::multi_bus_engine engine;
+ *    engine.add_job(i2c1, [&]() {
+ *      std::array<float, 8> frame;
+ *      for (hal::byte i = 0; i < 8; i++) {
+ *        frame[i] = tla2528.get_adc_reading(i);
+ *      }
+ *      readings.publish(frame);
+ *    });
+ *    engine.start();
+ *    // ... any thread: readings.read()
+ */
+class multi_bus_engine
+{
+public:
+  /**
+   * @brief Per-bus worker settings
+   *
+   */
+  struct worker_settings
+  {
+    /// Minimum time between the start of two cycles through the bus's jobs. A
+    /// period of zero runs the jobs back to back. Cycles missed because of an
+    /// overrun are skipped and the next cycle starts one period later.
+    hal::time_duration period{};
+    /// CPU core to pin the worker thread to, before it runs any job. Negative
+    /// leaves the thread unpinned. Must be below CPU_SETSIZE.
+    int cpu = -1;
+  };
+
+  multi_bus_engine() = default;
+  multi_bus_engine(multi_bus_engine const&) = delete;
+  multi_bus_engine& operator=(multi_bus_engine const&) = delete;
+  multi_bus_engine(multi_bus_engine&&) = delete;
+  multi_bus_engine& operator=(multi_bus_engine&&) = delete;
+
+  /**
+   * @brief Stops and joins every worker
+   */
+  ~multi_bus_engine();
+
+  /**
+   * @brief Set the worker settings of a bus
+   *
+   * @param p_bus - bus to configure, added to the engine if it is new
+   * @param p_settings - settings for the bus's worker
+   * @throws hal::operation_not_permitted - if the engine is running
+   * @throws hal::argument_out_of_domain - if the CPU is not below CPU_SETSIZE
+   */
+  void configure_bus(hal::i2c& p_bus, worker_settings const& p_settings);
+
+  /**
+   * @brief Add a job to the cycle of a bus
+   *
+   * @param p_bus - bus the job communicates over, added to the engine if it
+   * is new
+   * @param p_job - work to run once per cycle on the bus's worker
+   * @throws hal::operation_not_permitted - if the engine is running
+   */
+  void add_job(hal::i2c& p_bus, hal::callback<void()> p_job);
+
+  /**
+   * @brief Start one worker thread per bus that has jobs
+   *
+   */
+  void start();
+
+  /**
+   * @brief Signal every worker to stop after its current job and join them
+   *
+   * Workers waiting for their next cycle stop without finishing the wait.
+   */
+  void stop();
+
+  /**
+   * @return true - if the workers are running
+   */
+  [[nodiscard]] bool running() const;
+
+  /**
+   * @return std::size_t - number of buses in the engine
+   */
+  [[nodiscard]] std::size_t bus_count() const;
+
+  /**
+   * @param p_bus - bus to query
+   * @return std::uint64_t - number of completed cycles through the bus's jobs,
+   * 0 if the bus is unknown.
+   */
+  [[nodiscard]] std::uint64_t cycles(hal::i2c const& p_bus) const;
+
+  /**
+   * @param p_bus - bus to query
+   * @return std::uint64_t - number of jobs that threw, 0 if the bus is
+   * unknown.
+   */
+  [[nodiscard]] std::uint64_t errors(hal::i2c const& p_bus) const;
+
+private:
+  struct bus_worker
+  {
+    hal::i2c* bus = nullptr;
+    worker_settings settings{};
+    std::vector<hal::callback<void()>> jobs{};
+    std::atomic<std::uint64_t> cycles{ 0 };
+    std::atomic<std::uint64_t> errors{ 0 };
+    // Waited on between cycles so that a stop request ends the wait
+    std::mutex sleep_lock{};
+    std::condition_variable_any wake{};
+    std::jthread thread{};
+  };
+
+  bus_worker& find_or_add(hal::i2c& p_bus);
+  bus_worker const* find(hal::i2c const& p_bus) const;
+  static void run(std::stop_token p_stop, bus_worker& p_worker);
+
+  std::vector<std::unique_ptr<bus_worker>> m_workers;
+  bool m_running = false;
+};
+}  // namespace hal::expander
+
+#endif
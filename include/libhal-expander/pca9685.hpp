@@ -20,7 +20,11 @@
 #include <libhal/pwm.hpp>
 #include <libhal/units.hpp>
 
+#include <libhal-expander/basic_pca9685.hpp>
+
 namespace hal::expander {
+extern template class basic_pca9685<hal::i2c>;
+
 /**
  * @brief pca9685 driver: 16 channel 12-bit PWM generator over I2C
  *
@@ -40,6 +44,13 @@ namespace hal::expander {
  *    pwm0.frequency(1_kHz);
  *    pwm0.duty_cycle(0.25f);
  *
+ * Or, with integer duty cycles and the shared frequency set in one place:
+ *
+ *    auto group = pca9685.get_pwm_group_manager();
+ *    auto pwm1 = pca9685.get_pwm16_channel<1>();
+ *    group.frequency(1000);
+ *    pwm1.duty_cycle(0x4000);
+ *
  * After creating the `pca9685` driver, it can be configured or have its
  * frequency updated. It defaults to ~200 Hz. In order to control individual PWM
  * channels, `get_pwm_channel<N>()` must be called with the channel number in
@@ -49,11 +60,13 @@ namespace hal::expander {
  * their parent pca9685 driver is destroyed. It is important to ensure that
  * the lifetime of the pca9685 exceeds the lifetime of the pwm channel objects,
  * otherwise, using such object will result in undefined behavior.
+ *
+ * The driver is `basic_pca9685` bound to `hal::i2c`, with channel objects that
+ * implement the libhal pwm interfaces.
  */
-class pca9685
+class pca9685 : public basic_pca9685<hal::i2c>
 {
 public:
-  static constexpr size_t max_channel_count = 16;
   /**
    * @brief Representation & implementation of a pca9685 pwm channel/pin
    *
@@ -73,7 +86,7 @@ public:
      *
      * NOTE: that setting the frequency of one pwm channel will set the
      * frequency of all pwm channels because they all use the same PWM
-     * frequency.
+     * frequency. `pwm_group_manager` makes that explicit.
      *
      * @param p_frequency - frequency to set the whole pca9685 device to.
      * @throws hal::argument_out_of_domain - if the frequency is outside of the
@@ -94,41 +107,62 @@ public:
   };
 
   /**
-   * @brief Enumeration describing the pin state choices if the OE pin is active
+   * @brief Integer duty cycle interface to a pca9685 pwm channel/pin
    *
+   * The 16-bit duty cycle is scaled to the channel's 12-bit OFF tick with
+   * integer math, so no floating point is used between the caller and the
+   * register bytes. 65535 sets the full ON bit for a 100% duty cycle. The
+   * channel can report the device's frequency, but only the
+   * `pwm_group_manager` can change it.
    */
-  enum class disabled_pin_state : hal::byte
+  class pwm16_channel : public hal::pwm16_channel
   {
-    /// Set all pins to LOW voltage when output enable is asserted.
-    set_low = 0b00,
-    /// Set all the pins to HIGH voltage when output enable is asserted.
-    /// When the pins are set to be open_collector, meaning the device was
-    /// configured for `totem_pole_output = false`, then the output is high-Z.
-    set_high = 0b10,
-    /// Set all pins to HIGH-Z output
-    set_high_z = 0b11,
+  private:
+    pwm16_channel(pca9685* p_pca9685, hal::byte p_channel);
+
+    /**
+     * @return u32 - PWM frequency of every channel, rounded to the nearest
+     * hertz
+     */
+    u32 driver_frequency() override;
+    /**
+     * @brief Set the duty cycle of an individual channel
+     *
+     * @param p_duty_cycle - duty cycle from 0 (LOW for the whole cycle) to
+     * 65535 (HIGH for the whole cycle)
+     */
+    void driver_duty_cycle(u16 p_duty_cycle) override;
+
+    pca9685* m_pca9685;
+    hal::byte m_channel;
+
+    friend class pca9685;
   };
 
   /**
-   * @brief Collection of settings that can be configured
+   * @brief Control of the PWM frequency shared by all 16 channels
    *
    */
-  struct settings
+  class pwm_group_manager : public hal::pwm_group_manager
   {
-    /// Invert the voltage for all pins.
-    bool invert_outputs = false;
-    /// Update PWM channels on acknowledge
-    bool output_changes_on_i2c_acknowledge = false;
-    /// If true: output channels are configured as totem pole.
-    /// If false, the pin will be open collector
-    bool totem_pole_output = true;
-    /// Put the device to sleep and turn off the oscillator
-    /// This will disable all outputs if set to `true`.
-    /// Set to false to re-enable the device.
-    bool sleep = false;
-    /// Control what the state of the pins is when the output enable is
-    /// asserted.
-    disabled_pin_state pin_disabled_state = disabled_pin_state::set_low;
+  private:
+    explicit pwm_group_manager(pca9685* p_pca9685);
+
+    /**
+     * @brief Change the frequency of all PWM channels
+     *
+     * Maximum frequency is 1525 Hz.
+     * Minimum frequency is 25 Hz.
+     *
+     * @param p_frequency - frequency in Hz to set the whole pca9685 device to.
+     * @throws hal::argument_out_of_domain - if the frequency is outside of the
+     * available frequency ranges.
+     */
+    void driver_frequency(u32 p_frequency) override;
+
+    pca9685* m_pca9685;
+
+    friend class pca9685;
   };
 
   /**
@@ -146,7 +180,20 @@ public:
    */
   pca9685(hal::i2c& p_i2c,
           hal::byte p_address,
-          std::optional<pca9685::settings> p_settings = std::nullopt);
+          std::optional<settings> p_settings = std::nullopt);
+
+  /**
+   * @brief Create a pca9685 driver for a device initialized by a board init
+   * script
+   *
+   * No transactions are made. The driver takes on the device's known register
+   * values, so later operations only write what changes.
+   *
+   * @param p_i2c - an i2c bus driver to communicate with the chip
+   * @param p_state - state of the device after the init script ran, see
+   * `initial_state()` in board.hpp
+   */
+  pca9685(hal::i2c& p_i2c, pca9685_state const& p_state);
 
   /**
    * @brief Get a pwm channel object
@@ -161,28 +208,35 @@ public:
   template<hal::byte channel>
   pwm_channel get_pwm_channel()
   {
-    static_assert(channel <= max_channel_count,
+    static_assert(channel < max_channel_count,
                   "The PCA9685 only has 16 channels!");
 
     return pwm_channel(this, channel);
   }
 
   /**
-   * @brief Configure the device
+   * @brief Get an integer duty cycle pwm channel object
    *
-   * The settings will be cached by the driver so that it can be restored when
-   * updating the PWM frequency.
+   * Unlike `pwm_channel`, the channel cannot change the frequency of the
+   * device. Use `get_pwm_group_manager()` for that.
    *
-   * @param p_settings - settings to configure the device to
+   * @tparam channel - Which channel pin to get. Can be from 0 to 15.
+   * @return pwm16_channel - implementation of hal::pwm16_channel for an
+   * individual pin on the pca9685.
    */
-  void configure(settings const& p_settings);
+  template<hal::byte channel>
+  pwm16_channel get_pwm16_channel()
+  {
+    static_assert(channel < max_channel_count,
+                  "The PCA9685 only has 16 channels!");
 
-private:
-  void set_channel_frequency(hal::hertz p_frequency);
-  void set_channel_duty_cycle(float p_duty_cycle, hal::byte p_channel);
+    return pwm16_channel(this, channel);
+  }
 
-  hal::i2c* m_i2c;
-  hal::byte m_address;
-  settings m_settings{};
+  /**
+   * @return pwm_group_manager - implementation of hal::pwm_group_manager for
+   * the frequency shared by every channel of the pca9685.
+   */
+  pwm_group_manager get_pwm_group_manager();
 };
 }  // namespace hal::expander
@@ -0,0 +1,189 @@
+// Copyright 2024 Khalil Estell
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+#include <libhal/units.hpp>
+
+#include <libhal-expander/pca9685.hpp>
+
+namespace hal::expander {
+/**
+ * @brief 8-bit per component RGB color with an optional white component
+ *
+ */
+struct rgb_color
+{
+  std::uint8_t red = 0;
+  std::uint8_t green = 0;
+  std::uint8_t blue = 0;
+  /// Only used by groups of 4 channels
+  std::uint8_t white = 0;
+};
+
+/**
+ * @brief Integer HSV color
+ *
+ */
+struct hsv_color
+{
+  /// Hue in degrees from 0 to 359. Larger values wrap around.
+  std::uint16_t hue = 0;
+  std::uint8_t saturation = 255;
+  std::uint8_t value = 255;
+};
+
+/// Lookup table from an 8-bit component to a 12-bit pca9685 tick count
+using gamma_table = std::array<std::uint16_t, 256>;
+
+/**
+ * @brief Create a gamma correction table
+ *
+ * Uses floating point, so create tables once at startup and share them
+ * between groups.
+ *
+ * @param p_gamma - gamma exponent, such as 2.2f. 1.0f is linear.
+ * @return gamma_table - table mapping a component to its corrected ticks
+ */
+gamma_table make_gamma_table(float p_gamma);
+
+/**
+ * @brief Convert an HSV color to RGB using integer math only
+ *
+ * @param p_color - HSV color to convert
+ * @return rgb_color - equivalent RGB color with a white component of 0
+ */
+constexpr rgb_color to_rgb(hsv_color const& p_color)
+{
+  auto const hue = static_cast<std::uint32_t>(p_color.hue % 360);
+  std::uint32_t const saturation = p_color.saturation;
+  std::uint32_t const value = p_color.value;
+
+  auto const region = hue / 60;
+  // Position within the 60 degree region scaled to 0 to 255
+  auto const remainder = (hue % 60) * 255 / 60;
+  auto const p = value * (255 - saturation) / 255;
+  auto const q = value * (255 - (saturation * remainder) / 255) / 255;
+  auto const t = value * (255 - (saturation * (255 - remainder)) / 255) / 255;
+
+  auto const make = [](std::uint32_t p_red,
+                       std::uint32_t p_green,
+                       std::uint32_t p_blue) {
+    return rgb_color{ .red = static_cast<std::uint8_t>(p_red),
+                      .green = static_cast<std::uint8_t>(p_green),
+                      .blue = static_cast<std::uint8_t>(p_blue) };
+  };
+
+  switch (region) {
+    case 0:
+      return make(value, t, p);
+    case 1:
+      return make(q, value, p);
+    case 2:
+      return make(p, value, t);
+    case 3:
+      return make(p, q, value);
+    case 4:
+      return make(t, p, value);
+    default:
+      return make(value, p, q);
+  }
+}
+
+/**
+ * @brief RGB or RGBW LED driven by 3 or 4 consecutive pca9685 channels
+ *
+ * Colors are converted to channel ticks with integer math: white balance
+ * scales each component, then a gamma table maps it to a 12-bit tick count.
+ * All channels of the group are written with one burst, so the color changes
+ * at once and hue sweeps cost one transaction per fixture.
+ *
+ * USAGE:
+ *
+ *    static auto const gamma = hal::expander::make_gamma_table(2.2f);
+ *    hal::expander::pca9685_color_group fixture(
+ *      pca9685, 0, 3, { .white_balance = { 255, 200, 180 }, .gamma = &gamma });
+ *    for (std::uint16_t hue = 0; hue < 360; hue++) {
+ *      fixture.set(hal::expander::hsv_color{ .hue = hue });
+ *    }
+ */
+class pca9685_color_group
+{
+public:
+  /**
+   * @brief Color correction of the group
+   *
+   */
+  struct settings
+  {
+    /// Scale of the red, green, blue and white components, 255 is full scale
+    std::array<std::uint8_t, 4> white_balance{ 255, 255, 255, 255 };
+    /// Gamma table to apply after white balance. nullptr is linear. Must
+    /// outlive the group.
+    gamma_table const* gamma = nullptr;
+    /// For groups of 4 channels, move the part of red, green and blue that
+    /// all three share onto the white channel.
+    bool extract_white = false;
+  };
+
+  /**
+   * @param p_pca9685 - device the LED is connected to. Must outlive this
+   * object.
+   * @param p_first_channel - channel driving red. Green, blue and white follow
+   * on the next channels.
+   * @param p_channel_count - 3 for RGB or 4 for RGBW
+   * @param p_settings - color correction of the group
+   * @throws hal::argument_out_of_domain - if the channel count is not 3 or 4
+   * or the channels extend beyond channel 15.
+   */
+  pca9685_color_group(pca9685& p_pca9685,
+                      hal::byte p_first_channel,
+                      hal::byte p_channel_count,
+                      settings const& p_settings);
+
+  /**
+   * @brief Show an RGB color
+   *
+   * @param p_color - color to show
+   */
+  void set(rgb_color const& p_color);
+
+  /**
+   * @brief Show an HSV color
+   *
+   * @param p_color - color to show
+   */
+  void set(hsv_color const& p_color);
+
+  /**
+   * @brief Replace the color correction of the group
+   *
+   * Takes effect on the next color update.
+   *
+   * @param p_settings - new color correction
+   */
+  void configure(settings const& p_settings);
+
+private:
+  std::uint16_t ticks(std::uint8_t p_component, std::size_t p_channel) const;
+
+  pca9685* m_pca9685;
+  hal::byte m_first_channel;
+  hal::byte m_channel_count;
+  settings m_settings;
+};
+}  // namespace hal::expander
@@ -0,0 +1,197 @@
+// Copyright 2024 Khalil Estell
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+
+#include <libhal/units.hpp>
+
+#include <libhal-expander/pca9685.hpp>
+
+namespace hal::expander {
+/**
+ * @brief Convert a dead time to a whole number of pca9685 ticks
+ *
+ * Rounds up so the dead time produced is never shorter than requested.
+ *
+ * @param p_dead_time - minimum time between one output going LOW and the other
+ * going HIGH
+ * @param p_frequency - PWM frequency the device is configured for
+ * @return std::uint16_t - dead time in ticks, limited to half a cycle
+ */
+constexpr std::uint16_t dead_time_ticks(hal::time_duration p_dead_time,
+                                        hal::hertz p_frequency)
+{
+  using namespace pca9685_registers;
+  constexpr auto max_dead_time = cycle_ticks / 2;
+
+  auto const exact = static_cast<float>(p_dead_time.count()) * p_frequency *
+                     static_cast<float>(cycle_ticks) / 1e9f;
+  if (exact <= 0.0f) {
+    return 0;
+  }
+  if (exact >= static_cast<float>(max_dead_time)) {
+    return max_dead_time;
+  }
+  auto ticks = static_cast<std::uint16_t>(exact);
+  if (static_cast<float>(ticks) < exact) {
+    ticks++;
+  }
+  return ticks;
+}
+
+/**
+ * @brief Compute the edges of a complementary pair of outputs
+ *
+ * The high side output is HIGH from tick 0 to `p_high_ticks`. The low side
+ * output is HIGH for the rest of the cycle minus the dead time at both of its
+ * edges, so neither edge of one output is closer than the dead time to an edge
+ * of the other. If no time remains for the low side, it stays LOW for the
+ * whole cycle.
+ *
+ * @param p_high_ticks - ticks of the 4096 tick cycle the high side is HIGH,
+ * values above 4096 are limited to 4096.
+ * @param p_dead_time - dead time in ticks
+ * @return std::array<pca9685_channel_edges, 2> - edges of the high side then
+ * the low side
+ */
+constexpr std::array<pca9685_channel_edges, 2> complementary_edges(
+  std::uint16_t p_high_ticks,
+  std::uint16_t p_dead_time)
+{
+  using namespace pca9685_registers;
+  constexpr pca9685_channel_edges always_low{ .on_tick = 0,
+                                              .off_tick = full_cycle };
+  constexpr pca9685_channel_edges always_high{ .on_tick = full_cycle,
+                                               .off_tick = 0 };
+
+  auto const high_ticks = std::min(p_high_ticks, cycle_ticks);
+  if (high_ticks == cycle_ticks) {
+    return { always_high, always_low };
+  }
+
+  auto const high = high_ticks == 0
+                      ? always_low
+                      : pca9685_channel_edges{ .on_tick = 0,
+                                               .off_tick = high_ticks };
+
+  // Computed in 32 bits, as the sum can exceed a 16-bit value for large dead
+  // times
+  std::uint32_t const low_on = high_ticks + p_dead_time;
+  std::uint32_t const low_off =
+    cycle_ticks - std::min<std::uint32_t>(p_dead_time, cycle_ticks);
+  if (low_on >= low_off) {
+    return { high, always_low };
+  }
+  if (low_off - low_on == cycle_ticks) {
+    return { high, always_high };
+  }
+
+  // Without dead time the low side ends with the cycle, at tick 0 of the next
+  // one. 4096 would be the full OFF bit and keep the output LOW.
+  return { high,
+           pca9685_channel_edges{
+             .on_tick = static_cast<std::uint16_t>(low_on),
+             .off_tick = static_cast<std::uint16_t>(low_off % cycle_ticks),
+           } };
+}
+
+/**
+ * @brief Two pca9685 channels driving the high and low side of a half bridge
+ *
+ * The low side channel produces the complement of the high side channel, with
+ * a dead time around every edge during which both outputs are LOW. Both
+ * channels are always written whole in a single transaction, see
+ * `pca9685::write_together()`, and the device applies register writes
+ * together at the STOP condition, so the outputs are never updated one at a
+ * time and never overlap.
+ *
+ * Leave `output_changes_on_i2c_acknowledge` clear. With it set, each channel
+ * changes at its own acknowledge within the transaction, so for a moment the
+ * new high side runs against the old low side.
+ *
+ * The high side is the first channel and the low side the one after it.
+ *
+ * USAGE:
+ *
+ *    hal::expander::pca9685_complementary_pair bridge(pca9685, 0);
+ *    bridge.dead_time(500ns, 1000.0_Hz);
+ *    bridge.duty_cycle(0.4f);
+ */
+class pca9685_complementary_pair
+{
+public:
+  /**
+   * @param p_pca9685 - device the bridge is connected to. Must outlive this
+   * object.
+   * @param p_high_side_channel - channel of the high side, the low side is the
+   * next channel
+   * @param p_dead_time - dead time in ticks
+   * @throws hal::argument_out_of_domain - if the high side is channel 15, as
+   * there is no low side channel
+   */
+  pca9685_complementary_pair(pca9685& p_pca9685,
+                             hal::byte p_high_side_channel,
+                             std::uint16_t p_dead_time = 0);
+
+  /**
+   * @brief Set the dead time in ticks
+   *
+   * Takes effect on the next update.
+   *
+   * @param p_dead_time - dead time in ticks
+   */
+  void dead_time(std::uint16_t p_dead_time);
+
+  /**
+   * @brief Set the dead time in nanoseconds
+   *
+   * Takes effect on the next update.
+   *
+   * @param p_dead_time - minimum dead time, rounded up to whole ticks
+   * @param p_frequency - PWM frequency the device is configured for
+   */
+  void dead_time(hal::time_duration p_dead_time, hal::hertz p_frequency);
+
+  /**
+   * @return std::uint16_t - dead time in ticks
+   */
+  [[nodiscard]] std::uint16_t dead_time() const;
+
+  /**
+   * @brief Set the high side duty cycle
+   *
+   * @param p_duty_cycle - fraction of the cycle the high side is HIGH, from
+   * 0.0f to 1.0f
+   * @throws hal::argument_out_of_domain - if the duty cycle is outside of 0.0f
+   * to 1.0f
+   */
+  void duty_cycle(float p_duty_cycle);
+
+  /**
+   * @brief Set the high side on time in ticks
+   *
+   * @param p_high_ticks - ticks of the 4096 tick cycle the high side is HIGH
+   */
+  void high_side_ticks(std::uint16_t p_high_ticks);
+
+private:
+  pca9685* m_pca9685;
+  hal::byte m_high_side_channel;
+  std::uint16_t m_dead_time;
+};
+}  // namespace hal::expander
@@ -0,0 +1,379 @@
+// Copyright 2024 Khalil Estell
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+#include <libhal-util/bit.hpp>
+#include <libhal-util/enum.hpp>
+#include <libhal/units.hpp>
+
+#include <libhal-expander/register_map.hpp>
+
+namespace hal::expander {
+/**
+ * @brief Enumeration describing the pin state choices if the OE pin is active
+ *
+ */
+enum class pca9685_disabled_pin_state : hal::byte
+{
+  /// Set all pins to LOW voltage when output enable is asserted.
+  set_low = 0b00,
+  /// Set all the pins to HIGH voltage when output enable is asserted.
+  /// When the pins are set to be open_collector, meaning the device was
+  /// configured for `totem_pole_output = false`, then the output is high-Z.
+  set_high = 0b10,
+  /// Set all pins to HIGH-Z output
+  set_high_z = 0b11,
+};
+
+/**
+ * @brief Collection of pca9685 settings that can be configured
+ *
+ */
+struct pca9685_settings
+{
+  /// Invert the voltage for all pins.
+  bool invert_outputs = false;
+  /// Update PWM channels on acknowledge. Held off while the driver defers
+  /// updates.
+  bool output_changes_on_i2c_acknowledge = false;
+  /// If true: output channels are configured as totem pole.
+  /// If false, the pin will be open collector
+  bool totem_pole_output = true;
+  /// Put the device to sleep and turn off the oscillator
+  /// This will disable all outputs if set to `true`.
+  /// Set to false to re-enable the device.
+  bool sleep = false;
+  /// Control what the state of the pins is when the output enable is
+  /// asserted.
+  pca9685_disabled_pin_state pin_disabled_state =
+    pca9685_disabled_pin_state::set_low;
+};
+
+/**
+ * @brief Ticks of the 4096 tick PWM cycle at which a channel's output changes
+ *
+ * Values are the 13-bit register values. Bit 12 of `on_tick` holds the output
+ * HIGH for the whole cycle and bit 12 of `off_tick` holds it LOW, which takes
+ * precedence. `on_tick` and `off_tick` must otherwise differ.
+ */
+struct pca9685_channel_edges
+{
+  /// tick at which the output goes HIGH
+  std::uint16_t on_tick = 0;
+  /// tick at which the output goes LOW, may be before `on_tick` for a pulse
+  /// that wraps around the end of the cycle
+  std::uint16_t off_tick = 0;
+};
+
+/**
+ * @brief pca9685 register map and encoding shared by `pca9685` and
+ * `basic_pca9685`
+ *
+ */
+namespace pca9685_registers {
+/// Shadow of MODE1 (0x00) through LED15_OFF_H (0x45)
+using image = register_shadow<0x00, 0x46>;
+
+using mode1 = register_id<0x00>;
+using mode2 = register_id<0x01>;
+using pwm_channel0 = register_id<0x06, 4>;
+using prescaler = register_id<0xFE>;
+
+// MODE1 fields
+using enable_external_oscillator =
+  register_field<mode1, bit_mask::from<6>()>;
+using auto_increment_address = register_field<mode1, bit_mask::from<5>()>;
+using sleep = register_field<mode1, bit_mask::from<4>()>;
+using sub1_enable = register_field<mode1, bit_mask::from<3>()>;
+using sub2_enable = register_field<mode1, bit_mask::from<2>()>;
+using sub3_enable = register_field<mode1, bit_mask::from<1>()>;
+using all_call_enable = register_field<mode1, bit_mask::from<0>()>;
+
+// MODE2 fields
+using invert_logic = register_field<mode2, bit_mask::from<4>()>;
+using update_on_acknowledge = register_field<mode2, bit_mask::from<3>()>;
+using output_drive = register_field<mode2, bit_mask::from<2>()>;
+using output_enable_pin_state =
+  register_field<mode2, bit_mask::from<1, 0>()>;
+
+// Starting a new write costs the register address byte plus the device
+// address byte, so re-sending up to two known bytes is never worse.
+constexpr std::size_t max_burst_gap = 2;
+constexpr float max_pwm_ticks = 4095.0f;
+/// Number of ticks in one PWM cycle
+constexpr std::uint16_t cycle_ticks = 4096;
+
+/**
+ * @param p_channel - pwm channel from 0 to 15
+ * @return constexpr hal::byte - address of the channel's LEDn_ON_L register
+ */
+constexpr hal::byte channel_address(hal::byte p_channel)
+{
+  return static_cast<hal::byte>(pwm_channel0::address +
+                                (p_channel * pwm_channel0::width));
+}
+
+/**
+ * @brief Encode the settings into the MODE1 and MODE2 registers
+ *
+ * @param p_registers - register image to update
+ * @param p_settings - settings to encode
+ */
+constexpr void insert_settings(image& p_registers,
+                               pca9685_settings const& p_settings)
+{
+  p_registers.insert<enable_external_oscillator>(0U);
+  p_registers.insert<auto_increment_address>(1U);
+  p_registers.insert<sleep>(p_settings.sleep);
+  p_registers.insert<sub1_enable>(0U);
+  p_registers.insert<sub2_enable>(0U);
+  p_registers.insert<sub3_enable>(0U);
+  p_registers.insert<all_call_enable>(0U);
+
+  p_registers.insert<invert_logic>(p_settings.invert_outputs);
+  p_registers.insert<update_on_acknowledge>(
+    p_settings.output_changes_on_i2c_acknowledge);
+  p_registers.insert<output_drive>(p_settings.totem_pole_output);
+  p_registers.insert<output_enable_pin_state>(
+    hal::value(p_settings.pin_disabled_state));
+}
+
+/**
+ * @param p_frequency - desired pwm frequency
+ * @return true - if the frequency can be generated by the internal oscillator
+ */
+constexpr bool frequency_in_range(hal::hertz p_frequency)
+{
+  using namespace hal::literals;
+  return 24.0_Hz < p_frequency && p_frequency < 1526.0_Hz;
+}
+
+/**
+ * @param p_frequency - desired pwm frequency, must be within range
+ * @return hal::byte - PRE_SCALE register value for the frequency
+ */
+constexpr hal::byte prescale(hal::hertz p_frequency)
+{
+  using namespace hal::literals;
+  constexpr auto internal_oscillator = 25.0_MHz;
+  // Rounds to nearest like std::round, which is not constexpr, for the
+  // positive values within the frequency range.
+  auto const prescale_value = static_cast<hal::byte>(
+    internal_oscillator / (float{ cycle_ticks } * p_frequency) + 0.5f);
+  return static_cast<hal::byte>(prescale_value - 1);
+}
+
+/**
+ * @param p_frequency - desired pwm frequency in Hz
+ * @return true - if the frequency can be generated by the internal oscillator
+ */
+constexpr bool frequency_in_range_hz(std::uint32_t p_frequency)
+{
+  return 24U < p_frequency && p_frequency < 1526U;
+}
+
+/**
+ * @brief Integer counterpart of `prescale(hal::hertz)`
+ *
+ * Uses the same formula, so both return the same PRE_SCALE value for a whole
+ * number of hertz. `prescale_frequency()` is its inverse.
+ *
+ * @param p_frequency - desired pwm frequency in Hz, must be within range
+ * @return hal::byte - PRE_SCALE register value for the frequency
+ */
+constexpr hal::byte prescale_hz(std::uint32_t p_frequency)
+{
+  constexpr std::uint32_t internal_oscillator = 25'000'000;
+  auto const divisor = std::uint32_t{ cycle_ticks } * p_frequency;
+  auto const prescale_value = (internal_oscillator + divisor / 2) / divisor;
+  return static_cast<hal::byte>(prescale_value - 1);
+}
+
+/**
+ * @param p_prescale - PRE_SCALE register value
+ * @return std::uint32_t - PWM frequency generated by the internal oscillator,
+ * rounded to the nearest hertz
+ */
+constexpr std::uint32_t prescale_frequency(hal::byte p_prescale)
+{
+  constexpr std::uint32_t internal_oscillator = 25'000'000;
+  auto const divisor = std::uint32_t{ cycle_ticks } * (p_prescale + 1U);
+  return (internal_oscillator + divisor / 2) / divisor;
+}
+
+/// Largest OFF count of a channel, the last tick of the 12-bit cycle
+constexpr std::uint16_t max_ticks = 4095;
+
+/**
+ * @brief Encode a left aligned pulse as channel ON/OFF register values
+ *
+ * The PCA9685 works by setting a HIGH point and a LOW point out of the 12-bit
+ * timer cycle. The pulse goes HIGH at the start of the cycle, position 0, and
+ * goes LOW at the given tick.
+ *
+ * @param p_off_ticks - tick at which the output goes LOW, values above 4095
+ * are limited to 4095.
+ * @return std::array<hal::byte, 4> - LEDn_ON_L through LEDn_OFF_H values
+ */
+constexpr std::array<hal::byte, 4> ticks_registers(std::uint16_t p_off_ticks)
+{
+  constexpr hal::byte high_point_msb_lsb = 0U;
+
+  auto const low_point = std::min(p_off_ticks, max_ticks);
+  auto const low_point_lsb = static_cast<hal::byte>(low_point & 0xFF);
+  auto const low_point_msb = static_cast<hal::byte>(low_point >> 8);
+
+  return { high_point_msb_lsb,
+           high_point_msb_lsb,
+           low_point_lsb,
+           low_point_msb };
+}
+
+/**
+ * @brief Scale a 16-bit duty cycle to the 12-bit OFF tick of a channel
+ *
+ * Rounds to nearest with integer math only. 0 maps to tick 0 and 65535 maps
+ * to tick 4095, which still leaves the output LOW for the last tick of the
+ * cycle. Use `duty_cycle_edges()` to reach a 100% duty cycle.
+ *
+ * @param p_duty_cycle - duty cycle from 0 to 65535
+ * @return std::uint16_t - tick from 0 to 4095 at which the output goes LOW
+ */
+constexpr std::uint16_t duty_cycle_ticks(std::uint16_t p_duty_cycle)
+{
+  constexpr std::uint32_t full_scale = 65535;
+  return static_cast<std::uint16_t>(
+    (p_duty_cycle * std::uint32_t{ max_ticks } + full_scale / 2) / full_scale);
+}
+
+/// Bit 12 of an edge, holding the output HIGH or LOW for the whole cycle
+constexpr std::uint16_t full_cycle = 0x1000;
+
+/**
+ * @brief Scale a 16-bit duty cycle to the edges of a left aligned pulse
+ *
+ * Like `duty_cycle_ticks()`, except that 65535 sets the full ON bit so the
+ * output stays HIGH for the whole cycle, and duty cycles that round to tick 0
+ * set the full OFF bit, as equal ON and OFF ticks are not allowed.
+ *
+ * @param p_duty_cycle - duty cycle from 0 to 65535
+ * @return pca9685_channel_edges - ON and OFF ticks of the channel
+ */
+constexpr pca9685_channel_edges duty_cycle_edges(std::uint16_t p_duty_cycle)
+{
+  constexpr std::uint16_t full_scale = 65535;
+  if (p_duty_cycle == full_scale) {
+    return { .on_tick = full_cycle, .off_tick = 0 };
+  }
+  auto const off_tick = duty_cycle_ticks(p_duty_cycle);
+  if (off_tick == 0) {
+    return { .on_tick = 0, .off_tick = full_cycle };
+  }
+  return { .on_tick = 0, .off_tick = off_tick };
+}
+
+/// PRE_SCALE value after power on, a PWM frequency of about 200 Hz
+constexpr hal::byte power_on_prescale = 0x1E;
+
+/**
+ * @param p_prescale - PRE_SCALE register value
+ * @return hal::time_duration - length of one PWM cycle with the internal
+ * oscillator
+ */
+constexpr hal::time_duration cycle_period(hal::byte p_prescale)
+{
+  // Each of the 4096 ticks of a cycle lasts (prescale + 1) periods of the
+  // 25 MHz oscillator, which are 40 ns each.
+  constexpr std::int64_t oscillator_period_ns = 40;
+  return hal::time_duration((p_prescale + 1) * std::int64_t{ cycle_ticks } *
+                            oscillator_period_ns);
+}
+
+/**
+ * @brief Encode arbitrary channel edges as ON/OFF register values
+ *
+ * @param p_edges - ON and OFF ticks of the channel, bits above bit 12 are
+ * ignored.
+ * @return std::array<hal::byte, 4> - LEDn_ON_L through LEDn_OFF_H values
+ */
+constexpr std::array<hal::byte, 4> edge_registers(
+  pca9685_channel_edges const& p_edges)
+{
+  constexpr std::uint16_t edge_mask = 0x1FFF;
+
+  auto const on = static_cast<std::uint16_t>(p_edges.on_tick & edge_mask);
+  auto const off = static_cast<std::uint16_t>(p_edges.off_tick & edge_mask);
+
+  return { static_cast<hal::byte>(on & 0xFF),
+           static_cast<hal::byte>(on >> 8),
+           static_cast<hal::byte>(off & 0xFF),
+           static_cast<hal::byte>(off >> 8) };
+}
+
+/**
+ * @brief Encode a left aligned duty cycle as channel ON/OFF register values
+ *
+ * @param p_duty_cycle - duty cycle from 0.0f to 1.0f
+ * @return std::array<hal::byte, 4> - LEDn_ON_L through LEDn_OFF_H values
+ */
+inline std::array<hal::byte, 4> duty_cycle_registers(float p_duty_cycle)
+{
+  auto low_point_float = std::round(max_pwm_ticks * p_duty_cycle);
+  return ticks_registers(static_cast<std::uint16_t>(low_point_float));
+}
+
+/**
+ * @brief Write a register burst into a transaction buffer
+ *
+ * @param p_buffer - buffer large enough for the register address and data
+ * @param p_register - address of the first register in the burst
+ * @param p_data - register values of the burst
+ * @return std::span<hal::byte const> - the bytes to write to the device
+ */
+constexpr std::span<hal::byte const> burst(
+  std::array<hal::byte, image::size + 1>& p_buffer,
+  hal::byte p_register,
+  std::span<hal::byte const> p_data)
+{
+  p_buffer[0] = p_register;
+  std::copy(p_data.begin(), p_data.end(), p_buffer.begin() + 1);
+  return std::span(p_buffer).first(p_data.size() + 1);
+}
+}  // namespace pca9685_registers
+
+/**
+ * @brief State of an initialized pca9685 known ahead of time
+ *
+ * Produced by `initial_state()` from a board description, so that a pca9685
+ * driver can be constructed for a device initialized by a board init script
+ * without any bus traffic.
+ */
+struct pca9685_state
+{
+  hal::byte address = 0;
+  pca9685_settings settings{};
+  /// Register values of the device after initialization, marked known
+  pca9685_registers::image registers{};
+  /// PRE_SCALE value after initialization
+  hal::byte prescale = pca9685_registers::power_on_prescale;
+};
+}  // namespace hal::expander
@@ -0,0 +1,398 @@
+// Copyright 2024 Khalil Estell
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+#include <libhal-util/bit.hpp>
+#include <libhal/units.hpp>
+
+namespace hal::expander {
+/**
+ * @brief Compile-time description of a device register
+ *
+ * @tparam p_address - address of the first byte of the register
+ * @tparam p_width - number of consecutive bytes the register occupies
+ */
+template<hal::byte p_address, std::size_t p_width = 1>
+struct register_id
+{
+  static constexpr hal::byte address = p_address;
+  static constexpr std::size_t width = p_width;
+};
+
+/**
+ * @brief Compile-time description of a bit field within a one byte register
+ *
+ * @tparam register_type - the register_id the field lives in
+ * @tparam p_mask - bit positions of the field within the register
+ */
+template<class register_type, hal::bit_mask p_mask>
+struct register_field
+{
+  static_assert(register_type::width == 1,
+                "Fields can only be described within single byte registers");
+  using reg = register_type;
+  static constexpr hal::bit_mask mask = p_mask;
+};
+
+/**
+ * @brief Shadow image of a window of device registers with dirty tracking
+ *
+ * The shadow holds the driver's view of every byte in the register window
+ * [p_first_address, p_first_address + p_size). Each byte is tracked as either
+ * "known", meaning the shadow value matches what the device holds or is about
+ * to hold, and "dirty", meaning the shadow value has yet to be written to the
+ * device.
+ *
+ * Writes to the shadow only mark a byte dirty when its value changes or when
+ * the device's value is not known. `flush()` then walks the image and emits
+ * the smallest set of contiguous bursts that cover every dirty byte. Runs of
+ * dirty bytes separated by a small gap of known bytes are merged into a single
+ * burst when re-sending the gap costs fewer bytes than starting a new
+ * transaction.
+ *
+ * Drivers should only keep plain read/write storage registers in the shadow.
+ * Command bits, self-clearing bits, and write-1-to-clear status bits must be
+ * written directly, otherwise a flush could replay them as part of a burst.
+ *
+ * @tparam p_first_address - address of the first register in the window
+ * @tparam p_size - number of register bytes in the window
+ */
+template<hal::byte p_first_address, std::size_t p_size>
+class register_shadow
+{
+public:
+  static constexpr hal::byte first_address = p_first_address;
+  static constexpr std::size_t size = p_size;
+
+  static_assert(p_size > 0, "Register window must contain at least one byte");
+  static_assert(p_first_address + p_size <= 256,
+                "Register window must fit within an 8-bit address space");
+
+  /**
+   * @brief Determine if a span of register bytes lies within the window
+   *
+   * @param p_address - address of the first byte
+   * @param p_width - number of bytes
+   * @return true - if every byte is within the window
+   */
+  static constexpr bool contains(hal::byte p_address, std::size_t p_width = 1)
+  {
+    return p_address >= first_address &&
+           p_address + p_width <= first_address + size;
+  }
+
+  /**
+   * @param p_address - register address
+   * @return hal::byte - the shadow value of the register. Unknown registers
+   * read back as 0.
+   */
+  constexpr hal::byte get(hal::byte p_address) const
+  {
+    return m_image[index(p_address)];
+  }
+
+  /**
+   * @tparam reg - single byte register_id to read
+   * @return hal::byte - the shadow value of the register
+   */
+  template<class reg>
+  constexpr hal::byte get() const
+  {
+    static_assert(reg::width == 1, "Use get(address) for wide registers");
+    static_assert(contains(reg::address, reg::width));
+    return get(reg::address);
+  }
+
+  /**
+   * @tparam field - register_field to read
+   * @return hal::byte - the value of the field shifted down to bit 0
+   */
+  template<class field>
+  constexpr hal::byte extract() const
+  {
+    return hal::bit_extract(field::mask, get<typename field::reg>());
+  }
+
+  /**
+   * @brief Update a register byte in the shadow
+   *
+   * The byte is marked dirty if the value differs from the shadow or if the
+   * device's value is not known.
+   *
+   * @param p_address - register address
+   * @param p_value - new register value
+   */
+  constexpr void set(hal::byte p_address, hal::byte p_value)
+  {
+    auto const i = index(p_address);
+    if (!test(m_known, i) || m_image[i] != p_value) {
+      m_image[i] = p_value;
+      assign(m_known, i, true);
+      assign(m_dirty, i, true);
+    }
+  }
+
+  /**
+   * @brief Update consecutive register bytes in the shadow
+   *
+   * @param p_address - address of the first register byte
+   * @param p_values - new register values
+   */
+  constexpr void set(hal::byte p_address, std::span<hal::byte const> p_values)
+  {
+    for (std::size_t i = 0; i < p_values.size(); i++) {
+      set(static_cast<hal::byte>(p_address + i), p_values[i]);
+    }
+  }
+
+  /**
+   * @tparam reg - single byte register_id to update
+   * @param p_value - new register value
+   */
+  template<class reg>
+  constexpr void set(hal::byte p_value)
+  {
+    static_assert(reg::width == 1, "Use set(address, span) for wide registers");
+    static_assert(contains(reg::address, reg::width));
+    set(reg::address, p_value);
+  }
+
+  /**
+   * @brief Update a bit field within a register, leaving other bits untouched
+   *
+   * @tparam field - register_field to update
+   * @param p_value - new value of the field, aligned to bit 0
+   */
+  template<class field>
+  constexpr void insert(std::uint32_t p_value)
+  {
+    auto value = hal::bit_value<hal::byte>(get<typename field::reg>());
+    value.insert(field::mask, static_cast<hal::byte>(p_value));
+    set<typename field::reg>(value.get());
+  }
+
+  /**
+   * @brief Record values read back from the device
+   *
+   * Loaded bytes become known and clean.
+   *
+   * @param p_address - address of the first register byte read
+   * @param p_values - values read from the device
+   */
+  constexpr void load(hal::byte p_address, std::span<hal::byte const> p_values)
+  {
+    for (std::size_t i = 0; i < p_values.size(); i++) {
+      auto const position = index(static_cast<hal::byte>(p_address + i));
+      m_image[position] = p_values[i];
+      assign(m_known, position, true);
+      assign(m_dirty, position, false);
+    }
+  }
+
+  /**
+   * @param p_address - address of the first register byte
+   * @param p_width - number of bytes to check
+   * @return true - if every byte in the range has a known device value
+   */
+  constexpr bool known(hal::byte p_address, std::size_t p_width = 1) const
+  {
+    for (std::size_t i = 0; i < p_width; i++) {
+      if (!test(m_known, index(static_cast<hal::byte>(p_address + i)))) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  /**
+   * @param p_address - address of the first register byte
+   * @param p_width - number of bytes to check
+   * @return true - if any byte in the range still needs to be written
+   */
+  constexpr bool dirty(hal::byte p_address, std::size_t p_width = 1) const
+  {
+    for (std::size_t i = 0; i < p_width; i++) {
+      if (test(m_dirty, index(static_cast<hal::byte>(p_address + i)))) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  /**
+   * @return true - if any byte in the window still needs to be written
+   */
+  constexpr bool dirty() const
+  {
+    for (auto const word : m_dirty) {
+      if (word != 0) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  /**
+   * @brief Force a range of known registers to be written on the next flush
+   *
+   * @param p_address - address of the first register byte
+   * @param p_width - number of bytes
+   */
+  constexpr void mark_dirty(hal::byte p_address, std::size_t p_width = 1)
+  {
+    for (std::size_t i = 0; i < p_width; i++) {
+      auto const position = index(static_cast<hal::byte>(p_address + i));
+      if (test(m_known, position)) {
+        assign(m_dirty, position, true);
+      }
+    }
+  }
+
+  /**
+   * @brief Forget the device's value of a range of registers
+   *
+   * Use this after the device changes registers on its own, such as after a
+   * reset. Forgotten bytes are neither known nor dirty.
+   *
+   * @param p_address - address of the first register byte
+   * @param p_width - number of bytes
+   */
+  constexpr void forget(hal::byte p_address, std::size_t p_width = 1)
+  {
+    for (std::size_t i = 0; i < p_width; i++) {
+      auto const position = index(static_cast<hal::byte>(p_address + i));
+      m_image[position] = 0;
+      assign(m_known, position, false);
+      assign(m_dirty, position, false);
+    }
+  }
+
+  /**
+   * @brief Forget the device's value of every register in the window
+   */
+  constexpr void forget()
+  {
+    forget(first_address, size);
+  }
+
+  /**
+   * @brief Write every dirty byte to the device using minimal bursts
+   *
+   * Each burst is handed to `p_writer` which must send the bytes to the
+   * device starting at the given register address. A burst's dirty bits are
+   * only cleared once `p_writer` returns, so if the writer throws, the failed
+   * burst and every burst after it remain dirty and will be retried on the
+   * next flush.
+   *
+   * @param p_writer - callable with the signature
+   * `void(hal::byte p_address, std::span<hal::byte const> p_data)`
+   * @param p_max_gap - largest run of clean, known bytes between two dirty runs
+   * that will be re-sent in order to merge the two runs into a single burst.
+   * This should be set to the number of bytes it costs the device's protocol
+   * to start a new transaction.
+   * @return std::size_t - number of bursts emitted
+   */
+  template<class writer>
+  constexpr std::size_t flush(writer&& p_writer, std::size_t p_max_gap = 0)
+  {
+    std::size_t bursts = 0;
+    std::size_t start = 0;
+    while (true) {
+      while (start < size && !test(m_dirty, start)) {
+        start++;
+      }
+      if (start >= size) {
+        return bursts;
+      }
+
+      std::size_t end = start + 1;
+      while (end < size) {
+        if (test(m_dirty, end)) {
+          end++;
+          continue;
+        }
+        auto const gap_end = bridgeable_gap_end(end, p_max_gap);
+        if (gap_end == end) {
+          break;
+        }
+        end = gap_end;
+      }
+
+      p_writer(static_cast<hal::byte>(first_address + start),
+               std::span<hal::byte const>(m_image.data() + start, end - start));
+
+      for (auto i = start; i < end; i++) {
+        assign(m_dirty, i, false);
+      }
+      bursts++;
+      start = end;
+    }
+  }
+
+private:
+  static constexpr std::size_t word_bits = 32;
+  static constexpr std::size_t words = (size + word_bits - 1) / word_bits;
+  using bitset = std::array<std::uint32_t, words>;
+
+  static constexpr std::size_t index(hal::byte p_address)
+  {
+    return static_cast<std::size_t>(p_address - first_address);
+  }
+
+  static constexpr bool test(bitset const& p_bits, std::size_t p_index)
+  {
+    return (p_bits[p_index / word_bits] >> (p_index % word_bits)) & 1U;
+  }
+
+  static constexpr void assign(bitset& p_bits,
+                               std::size_t p_index,
+                               bool p_value)
+  {
+    auto const mask = std::uint32_t{ 1U } << (p_index % word_bits);
+    if (p_value) {
+      p_bits[p_index / word_bits] |= mask;
+    } else {
+      p_bits[p_index / word_bits] &= ~mask;
+    }
+  }
+
+  /**
+   * @return std::size_t - index of the dirty byte that ends the gap starting
+   * at p_index, or p_index if the gap cannot be bridged.
+   */
+  constexpr std::size_t bridgeable_gap_end(std::size_t p_index,
+                                           std::size_t p_max_gap) const
+  {
+    for (auto i = p_index; i < size && i - p_index <= p_max_gap; i++) {
+      if (test(m_dirty, i)) {
+        return i;
+      }
+      if (!test(m_known, i)) {
+        return p_index;
+      }
+    }
+    return p_index;
+  }
+
+  std::array<hal::byte, size> m_image{};
+  bitset m_known{};
+  bitset m_dirty{};
+};
+}  // namespace hal::expander
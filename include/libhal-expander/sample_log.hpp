@@ -0,0 +1,339 @@
+// Copyright 2024 Khalil Estell
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <span>
+
+#include <libhal/functional.hpp>
+#include <libhal/units.hpp>
+
+namespace hal::expander {
+/**
+ * @brief One decoded frame of a sample log
+ *
+ */
+struct sample_log_frame
+{
+  /// Time of the scan in ticks of the logging clock
+  std::uint64_t timestamp = 0;
+  /// Conversion result of each pin by pin number. Pins that are not logged
+  /// are 0.
+  std::array<std::uint16_t, 8> codes{};
+};
+
+/**
+ * @brief Layout of the sample log format
+ *
+ * A log is a header followed by fixed size blocks, so block N starts at
+ * `header_size + N * block_size` and can be read without decoding the blocks
+ * before it. All multi-byte fields are little endian.
+ *
+ * Header, `header_size` bytes:
+ *
+ *    magic "TLAL", version, logged pin bit field, block size (u16),
+ *    timestamp frequency in Hz (u32)
+ *
+ * Block, `block_size` bytes:
+ *
+ *    sequence number (u32), frame count (u16), timestamp of the first frame
+ *    (u64), frames, zero padding
+ *
+ * Each frame is the unsigned varint timestamp delta from the previous frame,
+ * followed by one zigzag varint code delta per logged pin in pin order. The
+ * deltas of the first frame of a block are from the block's timestamp and
+ * codes of 0, so every block decodes on its own. Readings of a slowly
+ * changing input typically take 1 byte per pin.
+ */
+namespace sample_log_format {
+constexpr std::array<hal::byte, 4> magic{ 'T', 'L', 'A', 'L' };
+constexpr hal::byte version = 1;
+constexpr std::size_t header_size = 12;
+constexpr std::size_t block_header_size = 14;
+/// Largest encoded frame: a 64-bit varint and 8 zigzag varints of a 16-bit
+/// delta
+constexpr std::size_t max_frame_size = 10 + 8 * 3;
+/// Smallest block that can hold every frame
+constexpr std::size_t min_block_size = block_header_size + max_frame_size;
+}  // namespace sample_log_format
+
+/**
+ * @brief Streaming encoder of tla2528 scans in the sample log format
+ *
+ * Compared to logging `get_adc_reading()` values as text, storing raw codes as
+ * deltas from the previous scan takes a fraction of the space and write
+ * bandwidth. Frames are encoded into a caller provided block buffer, so the
+ * encoder uses constant memory. Each block is handed to the sink once it is
+ * full, and the log header is handed to the sink on construction.
+ *
+ * USAGE:
+ *
+ *    std::array<hal::byte, 512> block;
+ *    hal::expander::sample_log_encoder log(
+ *      0xFF, clock.frequency(), block, [&](std::span<hal::byte const> p_data) {
+ *        sd_card.write(p_data);
+ *      });
+ *    std::array<std::uint16_t, 8> codes{};
+ *    while (true) {
+ *      adc.scan(0xFF, codes);
+ *      log.append(clock.uptime(), codes);
+ *    }
+ */
+class sample_log_encoder
+{
+public:
+  /// Receives the log header and every completed block
+  using sink = hal::callback<void(std::span<hal::byte const>)>;
+
+  /**
+   * @param p_channels - bit field of the pins to log, bit 0 is pin 0
+   * @param p_timestamp_frequency - frequency of the clock timestamps come
+   * from, stored in the header
+   * @param p_block - buffer for the block being encoded, its size is the
+   * block size of the log. Must outlive this object.
+   * @param p_sink - destination of the encoded log
+   * @throws hal::argument_out_of_domain - if p_block is smaller than
+   * `sample_log_format::min_block_size` or larger than 65535 bytes
+   */
+  sample_log_encoder(hal::byte p_channels,
+                     hal::hertz p_timestamp_frequency,
+                     std::span<hal::byte> p_block,
+                     sink p_sink);
+
+  sample_log_encoder(sample_log_encoder const&) = delete;
+  sample_log_encoder& operator=(sample_log_encoder const&) = delete;
+  sample_log_encoder(sample_log_encoder&&) = delete;
+  sample_log_encoder& operator=(sample_log_encoder&&) = delete;
+
+  /**
+   * @brief Encode one scan
+   *
+   * If the frame does not fit in the current block, the block is completed
+   * and the frame starts the next one.
+   *
+   * @param p_timestamp - time of the scan, such as `clock.uptime()`
+   * @param p_codes - conversion results indexed by pin number, as filled by
+   * `tla2528::scan()`. Only the logged pins are read.
+   * @throws hal::argument_out_of_domain - if p_timestamp is earlier than the
+   * previous frame's
+   */
+  void append(std::uint64_t p_timestamp,
+              std::span<std::uint16_t const, 8> p_codes);
+
+  /**
+   * @brief Complete the current block even if it is not full
+   *
+   * Call before closing the log so the last frames are not lost. Does nothing
+   * if the block holds no frames.
+   */
+  void flush();
+
+  /**
+   * @return std::uint32_t - number of blocks handed to the sink
+   */
+  [[nodiscard]] std::uint32_t blocks_written() const;
+
+  /**
+   * @return std::size_t - number of frames in the current block
+   */
+  [[nodiscard]] std::size_t pending_frames() const;
+
+private:
+  std::size_t encode(std::uint64_t p_timestamp,
+                     std::span<std::uint16_t const, 8> p_codes,
+                     std::span<hal::byte, sample_log_format::max_frame_size>
+                       p_frame) const;
+  void start_block(std::uint64_t p_timestamp);
+
+  std::span<hal::byte> m_block;
+  sink m_sink;
+  std::array<std::uint16_t, 8> m_codes{};
+  std::uint64_t m_timestamp = 0;
+  std::size_t m_used = 0;
+  std::uint32_t m_sequence = 0;
+  std::uint16_t m_frames = 0;
+  hal::byte m_channels;
+};
+
+/**
+ * @brief The frames of one block of a sample log
+ *
+ * References the bytes of the log and decodes frames as they are iterated,
+ * without copying or allocating.
+ */
+class sample_log_block
+{
+public:
+  /**
+   * @brief Input iterator over the frames of a block
+   *
+   * @throws hal::io_error - when incremented onto a frame that runs past the
+   * end of the block, which means the log is corrupt
+   */
+  class iterator
+  {
+  public:
+    using iterator_concept = std::input_iterator_tag;
+    using value_type = sample_log_frame;
+    using difference_type = std::ptrdiff_t;
+
+    iterator() = default;
+
+    sample_log_frame const& operator*() const
+    {
+      return m_frame;
+    }
+
+    sample_log_frame const* operator->() const
+    {
+      return &m_frame;
+    }
+
+    iterator& operator++()
+    {
+      m_remaining--;
+      if (m_remaining > 0) {
+        decode();
+      }
+      return *this;
+    }
+
+    void operator++(int)
+    {
+      ++*this;
+    }
+
+    bool operator==(std::default_sentinel_t) const
+    {
+      return m_remaining == 0;
+    }
+
+  private:
+    iterator(sample_log_block const& p_block);
+    void decode();
+
+    hal::byte const* m_cursor = nullptr;
+    hal::byte const* m_end = nullptr;
+    std::size_t m_remaining = 0;
+    sample_log_frame m_frame{};
+    hal::byte m_channels = 0;
+
+    friend class sample_log_block;
+  };
+
+  /**
+   * @return std::uint32_t - position of the block in the log as written,
+   * which detects blocks that were lost or reordered
+   */
+  [[nodiscard]] std::uint32_t sequence() const;
+
+  /**
+   * @return std::size_t - number of frames in the block
+   */
+  [[nodiscard]] std::size_t size() const;
+
+  /**
+   * @return std::uint64_t - timestamp of the first frame
+   */
+  [[nodiscard]] std::uint64_t first_timestamp() const;
+
+  /**
+   * @return iterator - the first frame
+   * @throws hal::io_error - if the first frame is corrupt
+   */
+  [[nodiscard]] iterator begin() const;
+
+  [[nodiscard]] std::default_sentinel_t end() const
+  {
+    return std::default_sentinel;
+  }
+
+private:
+  sample_log_block(std::span<hal::byte const> p_bytes, hal::byte p_channels);
+
+  std::span<hal::byte const> m_bytes;
+  hal::byte m_channels;
+
+  friend class sample_log_reader;
+};
+
+/**
+ * @brief Zero copy reader of a sample log
+ *
+ * Intended for the host side, such as a tool reading a log file mapped into
+ * memory. Any block can be decoded on its own, and `find()` locates the block
+ * holding a point in time with a binary search over the block headers.
+ *
+ * USAGE:
+ *
+ *    hal::expander::sample_log_reader log(file_bytes);
+ *    for (std::size_t i = 0; i < log.block_count(); i++) {
+ *      for (auto const& frame : log.block(i)) {
+ *        print(frame.timestamp, frame.codes[0]);
+ *      }
+ *    }
+ */
+class sample_log_reader
+{
+public:
+  /**
+   * @param p_log - the whole log, starting with its header. Must outlive this
+   * object and every block taken from it.
+   * @throws hal::io_error - if the header is missing, of another version or
+   * describes an invalid block size
+   */
+  explicit sample_log_reader(std::span<hal::byte const> p_log);
+
+  /**
+   * @return hal::byte - bit field of the logged pins
+   */
+  [[nodiscard]] hal::byte channels() const;
+
+  /**
+   * @return hal::hertz - frequency of the clock the timestamps are from
+   */
+  [[nodiscard]] hal::hertz timestamp_frequency() const;
+
+  /**
+   * @return std::size_t - number of complete blocks in the log. A partially
+   * written last block is ignored.
+   */
+  [[nodiscard]] std::size_t block_count() const;
+
+  /**
+   * @param p_index - block number from 0 to `block_count() - 1`
+   * @return sample_log_block - frames of the block
+   * @throws hal::argument_out_of_domain - if p_index is out of range
+   */
+  [[nodiscard]] sample_log_block block(std::size_t p_index) const;
+
+  /**
+   * @param p_timestamp - point in time to look for
+   * @return std::size_t - index of the last block whose first frame is at or
+   * before p_timestamp, 0 if there is none. Assumes the timestamps of the
+   * blocks increase, as they do when written by `sample_log_encoder`.
+   */
+  [[nodiscard]] std::size_t find(std::uint64_t p_timestamp) const;
+
+private:
+  std::span<hal::byte const> m_blocks;
+  std::size_t m_block_size;
+  std::uint32_t m_timestamp_frequency;
+  hal::byte m_channels;
+};
+}  // namespace hal::expander
@@ -0,0 +1,181 @@
+// Copyright 2024 Khalil Estell
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <span>
+
+#include <libhal/functional.hpp>
+#include <libhal/steady_clock.hpp>
+#include <libhal/units.hpp>
+
+#include <libhal-expander/pca9685.hpp>
+#include <libhal-expander/snapshot_buffer.hpp>
+#include <libhal-expander/tla2528.hpp>
+
+namespace hal::expander {
+/**
+ * @brief Fixed rate loop from tla2528 sensor scans to pca9685 outputs
+ *
+ * Each cycle scans the selected tla2528 channels as raw 12-bit codes, runs a
+ * fixed point control kernel over the whole frame, and commits the kernel's
+ * outputs to consecutive pca9685 channels as raw 12-bit ticks in a single
+ * burst. No floating point is involved.
+ *
+ * The cycle is split in two stages, `sense()` and `actuate()`, which hand
+ * frames over through a snapshot_buffer. When both devices share a bus, call
+ * `run_cycle()`. When they are on different buses, the stages may run on
+ * different threads, for example as jobs of a multi_bus_engine, so the next
+ * scan overlaps the current commit. `actuate()` always commits the newest
+ * frame, and frames replaced before they could be committed are counted as
+ * dropped.
+ *
+ * The sense-to-actuate latency of a cycle is the time from the start of its
+ * scan to the end of its commit. Jitter is the change in latency from the
+ * previously committed cycle.
+ *
+ * USAGE:
+ *
+ *    hal::expander::sense_actuate_pipeline pipeline(
+ *      tla2528, pca9685, clock,
+ *      [](std::span<std::uint16_t const, 8> p_codes,
+ *         std::span<std::uint16_t> p_ticks) {
+ *        for (std::size_t i = 0; i < p_ticks.size(); i++) {
+ *          p_ticks[i] = p_codes[i];
+ *        }
+ *      },
+ *      { .input_channels = 0x0F, .output_count = 4 });
+ *
+ *    while (true) {
+ *      pipeline.run_cycle();
+ *      hal::delay(clock, 1ms);
+ *    }
+ */
+class sense_actuate_pipeline
+{
+public:
+  /**
+   * @brief Control kernel computing pca9685 ticks from tla2528 codes
+   *
+   * The first parameter holds the latest code of every scanned channel,
+   * indexed by pin number. The second receives the OFF tick, from 0 to 4095,
+   * of every output channel starting at `settings::first_output`.
+   */
+  using kernel = void(std::span<std::uint16_t const, 8> p_codes,
+                      std::span<std::uint16_t> p_ticks);
+
+  /**
+   * @brief Channel selection of the pipeline
+   *
+   */
+  struct settings
+  {
+    /// Bit field of tla2528 pins to scan, bit 0 is pin 0
+    hal::byte input_channels = 0xFF;
+    /// pca9685 channel receiving the kernel's first output
+    hal::byte first_output = 0;
+    /// Number of consecutive pca9685 channels written each cycle
+    hal::byte output_count = 16;
+  };
+
+  /**
+   * @brief Latency statistics over every committed cycle
+   *
+   */
+  struct statistics
+  {
+    /// Number of frames committed to the pca9685
+    std::uint32_t cycles = 0;
+    /// Number of frames replaced by a newer frame before being committed
+    std::uint32_t dropped = 0;
+    hal::time_duration last_latency{};
+    hal::time_duration min_latency{};
+    hal::time_duration max_latency{};
+    hal::time_duration last_jitter{};
+    hal::time_duration max_jitter{};
+  };
+
+  /**
+   * @param p_tla2528 - device to scan. Must outlive this object.
+   * @param p_pca9685 - device to drive. Must outlive this object.
+   * @param p_clock - clock to timestamp frames with. Must outlive this object.
+   * @param p_kernel - control kernel run on every scanned frame
+   * @param p_settings - channel selection
+   * @throws hal::argument_out_of_domain - if the outputs extend beyond
+   * pca9685 channel 15
+   */
+  sense_actuate_pipeline(tla2528& p_tla2528,
+                         pca9685& p_pca9685,
+                         hal::steady_clock& p_clock,
+                         hal::callback<kernel> p_kernel,
+                         settings const& p_settings);
+
+  /**
+   * @brief Scan the inputs, run the kernel and publish the output frame
+   *
+   * Must only be called from one thread at a time.
+   */
+  void sense();
+
+  /**
+   * @brief Commit the newest published frame to the pca9685
+   *
+   * Does nothing if no new frame was published since the last commit. Must
+   * only be called from one thread at a time.
+   *
+   * @return true - if a frame was committed
+   */
+  bool actuate();
+
+  /**
+   * @brief Run `sense()` followed by `actuate()`
+   *
+   */
+  void run_cycle();
+
+  /**
+   * @return statistics const& - latency statistics, updated by `actuate()`
+   */
+  [[nodiscard]] statistics const& stats() const;
+
+  /**
+   * @brief Clear the latency statistics
+   *
+   */
+  void reset_statistics();
+
+private:
+  struct frame
+  {
+    std::array<std::uint16_t, pca9685::max_channel_count> ticks;
+    std::uint64_t sense_start;
+    std::uint32_t sequence;
+  };
+
+  hal::time_duration to_duration(std::uint64_t p_ticks);
+
+  tla2528* m_tla2528;
+  pca9685* m_pca9685;
+  hal::steady_clock* m_clock;
+  hal::callback<kernel> m_kernel;
+  settings m_settings;
+  std::array<std::uint16_t, 8> m_codes{};
+  std::uint32_t m_sequence = 0;
+  snapshot_buffer<frame> m_frames{};
+  std::uint32_t m_committed = 0;
+  statistics m_statistics{};
+};
+}  // namespace hal::expander
@@ -0,0 +1,315 @@
+// Copyright 2024 Khalil Estell
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include <libhal/functional.hpp>
+#include <libhal/i2c.hpp>
+#include <libhal/steady_clock.hpp>
+#include <libhal/units.hpp>
+
+namespace hal::expander {
+/**
+ * @brief Steady clock whose time only moves when the simulation moves it
+ *
+ * Ticks are nanoseconds. Time advances when `advance()` is called, such as by
+ * `simulated_i2c` for the duration of each transfer, and by a small fixed
+ * amount on every read of the uptime. The latter stands in for the time the
+ * caller spends running and lets busy wait loops, such as `hal::delay()` and
+ * timeouts, make progress.
+ */
+class simulated_clock : public hal::steady_clock
+{
+public:
+  /**
+   * @param p_read_cost - time that passes on each read of the uptime
+   */
+  explicit simulated_clock(
+    hal::time_duration p_read_cost = hal::time_duration(100));
+
+  /**
+   * @brief Move time forward
+   *
+   * @param p_duration - amount of time to pass
+   */
+  void advance(hal::time_duration p_duration);
+
+  /**
+   * @return hal::time_duration - time since the clock was created without
+   * advancing it.
+   */
+  [[nodiscard]] hal::time_duration now() const;
+
+private:
+  hal::hertz driver_frequency() override;
+  std::uint64_t driver_uptime() override;
+
+  std::uint64_t m_ticks = 0;
+  std::uint64_t m_read_cost;
+};
+
+/**
+ * @brief A device attached to a simulated_i2c bus
+ *
+ */
+class simulated_device
+{
+public:
+  /**
+   * @brief Receive the bytes of a write addressed to the device
+   *
+   * @param p_data - bytes written, may be empty for an address probe
+   */
+  void write(std::span<hal::byte const> p_data)
+  {
+    driver_write(p_data);
+  }
+
+  /**
+   * @brief Supply the bytes of a read addressed to the device
+   *
+   * @param p_data - storage for the bytes read
+   */
+  void read(std::span<hal::byte> p_data)
+  {
+    driver_read(p_data);
+  }
+
+  virtual ~simulated_device() = default;
+
+private:
+  virtual void driver_write(std::span<hal::byte const> p_data) = 0;
+  virtual void driver_read(std::span<hal::byte> p_data) = 0;
+};
+
+/**
+ * @brief hal::i2c bus with simulated devices and transfer timing
+ *
+ * Each transaction is routed to the device attached at its address and
+ * advances the clock by the time the transfer would take on a real bus, 9
+ * bit times per byte including the address bytes. A transaction to an
+ * address without a device throws `hal::no_such_device` like a NACK.
+ *
+ * USAGE:
+ *
+ *    hal::expander::simulated_clock clock;
+ *    hal::expander::simulated_i2c i2c(clock);
+ *    hal::expander::simulated_pca9685 device;
+ *    i2c.attach(0b100'0000, device);
+ *    hal::expander::pca9685 pca9685(i2c, 0b100'0000);
+ */
+class simulated_i2c : public hal::i2c
+{
+public:
+  /**
+   * @param p_clock - clock to advance for each transfer. Must outlive this
+   * object.
+   */
+  explicit simulated_i2c(simulated_clock& p_clock);
+
+  /**
+   * @brief Attach a device to the bus
+   *
+   * @param p_address - 7-bit address the device responds to
+   * @param p_device - device to attach. Must outlive this object.
+   */
+  void attach(hal::byte p_address, simulated_device& p_device);
+
+  /**
+   * @return std::uint32_t - number of transactions made on the bus
+   */
+  [[nodiscard]] std::uint32_t transaction_count() const;
+
+private:
+  struct attachment
+  {
+    hal::byte address;
+    simulated_device* device;
+  };
+
+  void driver_configure(settings const& p_settings) override;
+  void driver_transaction(
+    hal::byte p_address,
+    std::span<hal::byte const> p_data_out,
+    std::span<hal::byte> p_data_in,
+    hal::function_ref<hal::timeout_function> p_timeout) override;
+
+  simulated_clock* m_clock;
+  std::vector<attachment> m_devices{};
+  hal::hertz m_clock_rate = 100'000.0f;
+  std::uint32_t m_transaction_count = 0;
+};
+
+/**
+ * @brief Register level model of a pca9685
+ *
+ * Models the register file, register pointer and MODE1 auto increment. The
+ * channel registers reach the outputs at the STOP condition, or with MODE2 OCH
+ * set, at the acknowledge of the last of a channel's 4 registers to be
+ * loaded.
+ */
+class simulated_pca9685 : public simulated_device
+{
+public:
+  simulated_pca9685();
+
+  /**
+   * @param p_address - register address
+   * @return hal::byte - value of the register
+   */
+  [[nodiscard]] hal::byte register_value(hal::byte p_address) const;
+
+  /**
+   * @param p_channel - pwm channel from 0 to 15
+   * @return std::uint16_t - counter value at which the channel output turns
+   * off
+   */
+  [[nodiscard]] std::uint16_t off_ticks(hal::byte p_channel) const;
+
+  /**
+   * @param p_channel - pwm channel from 0 to 15
+   * @return std::uint16_t - counter value at which the channel output turns
+   * off, as last latched onto the output
+   */
+  [[nodiscard]] std::uint16_t output_off_ticks(hal::byte p_channel) const;
+
+private:
+  void driver_write(std::span<hal::byte const> p_data) override;
+  void driver_read(std::span<hal::byte> p_data) override;
+  void advance_pointer();
+  void latch(std::size_t p_channel);
+
+  static constexpr std::size_t channel_count = 16;
+
+  std::array<hal::byte, 256> m_registers{};
+  // LEDn registers as seen by the outputs
+  std::array<hal::byte, channel_count * 4> m_outputs{};
+  // Bit field per channel of the LEDn registers loaded since the last latch
+  std::array<hal::byte, channel_count> m_loaded{};
+  hal::byte m_pointer = 0;
+};
+
+/**
+ * @brief Register level model of a tla2528
+ *
+ * Models the op code protocol, the register file, manual mode conversions
+ * of the selected channel, and the digital input and output registers. Input
+ * levels and conversion results are set by the test or benchmark.
+ */
+class simulated_tla2528 : public simulated_device
+{
+public:
+  simulated_tla2528();
+
+  /**
+   * @brief Set the conversion result of an analog input
+   *
+   * @param p_channel - channel from 0 to 7
+   * @param p_code - 12-bit conversion result
+   */
+  void set_analog_input(hal::byte p_channel, std::uint16_t p_code);
+
+  /**
+   * @brief Add noise to every conversion of an analog input
+   *
+   * Each conversion is the input's code plus a uniformly distributed offset
+   * from -p_amplitude to +p_amplitude codes, drawn from a fixed seed. With
+   * oversampling enabled in OSR_CFG, that many conversions are averaged into
+   * each result.
+   *
+   * @param p_channel - channel from 0 to 7
+   * @param p_amplitude - largest offset in codes, 0 for a noiseless input
+   */
+  void set_analog_noise(hal::byte p_channel, std::uint16_t p_amplitude);
+
+  /**
+   * @brief Set the levels of the digital inputs
+   *
+   * @param p_levels - bit field of pin levels, bit 0 is pin 0
+   */
+  void set_digital_inputs(hal::byte p_levels);
+
+  /**
+   * @param p_address - register address
+   * @return hal::byte - value of the register
+   */
+  [[nodiscard]] hal::byte register_value(hal::byte p_address) const;
+
+  /**
+   * @return std::uint32_t - number of conversions read from the device
+   */
+  [[nodiscard]] std::uint32_t conversion_count() const;
+
+private:
+  enum class read_source : hal::byte
+  {
+    conversion,
+    single_register,
+    continuous_registers,
+  };
+
+  void driver_write(std::span<hal::byte const> p_data) override;
+  void driver_read(std::span<hal::byte> p_data) override;
+  void write_register(hal::byte p_address, hal::byte p_value);
+  hal::byte read_register(hal::byte p_address) const;
+  std::uint16_t convert(hal::byte p_channel);
+
+  std::array<hal::byte, 256> m_registers{};
+  std::array<std::uint16_t, 8> m_analog_inputs{};
+  std::array<std::uint16_t, 8> m_analog_noise{};
+  std::uint32_t m_noise_state = 0x1234'5678;
+  hal::byte m_digital_inputs = 0;
+  hal::byte m_pointer = 0;
+  read_source m_read_source = read_source::conversion;
+  std::uint32_t m_conversion_count = 0;
+};
+
+/**
+ * @brief Latency distribution of a repeated operation
+ *
+ */
+struct latency_report
+{
+  /// Number of times the operation was run
+  std::uint32_t samples = 0;
+  /// Number of runs that ended with an exception
+  std::uint32_t failures = 0;
+  hal::time_duration p50{};
+  hal::time_duration p99{};
+  hal::time_duration max{};
+};
+
+/**
+ * @brief Run an operation repeatedly and report its simulated latency
+ *
+ * Latency is measured on the simulated clock, so it includes the simulated
+ * bus transfer time, timeouts, and retry backoff delays but not the host's
+ * own execution time. Runs that throw are counted as failures and their
+ * latency is still recorded.
+ *
+ * @param p_clock - clock the operation's bus and drivers use
+ * @param p_iterations - number of times to run the operation
+ * @param p_operation - operation to measure
+ * @return latency_report - latency percentiles over every run
+ */
+latency_report measure_latency(simulated_clock& p_clock,
+                               std::uint32_t p_iterations,
+                               hal::callback<void()> const& p_operation);
+}  // namespace hal::expander
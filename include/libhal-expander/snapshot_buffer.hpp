@@ -0,0 +1,128 @@
+// Copyright 2024 Khalil Estell
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+namespace hal::expander {
+/**
+ * @brief Lock-free, double buffered snapshot of a value
+ *
+ * One producer publishes complete values, such as a frame of tla2528 readings,
+ * and any number of consumers read the latest complete value without locks
+ * and without ever observing a partially written value.
+ *
+ * The producer always writes into the buffer that readers are not directed
+ * to, then flips a sequence counter to make it current. A reader copies the
+ * current buffer and checks the sequence counter afterwards. The copy is only
+ * retried if the producer published twice during the copy, which is rare
+ * unless the reader is much slower than the producer.
+ *
+ * Values are copied in and out byte by byte with relaxed atomic loads and
+ * stores, so a copy that overlaps a publish is not a data race, and its
+ * result is simply discarded. Only atomic loads and stores are used, so this
+ * works on cores without atomic read-modify-write instructions, and between
+ * an interrupt and the main loop.
+ *
+ * @tparam T - trivially copyable value type
+ */
+template<class T>
+class snapshot_buffer
+{
+public:
+  static_assert(std::is_trivially_copyable_v<T>,
+                "snapshot_buffer values are copied while being published, so "
+                "they must be trivially copyable");
+
+  /**
+   * @brief Make a new value current
+   *
+   * Must only be called from one thread of execution at a time.
+   *
+   * @param p_value - value to publish
+   */
+  void publish(T const& p_value)
+  {
+    auto const sequence = m_sequence.load(std::memory_order_relaxed);
+    // An odd sequence marks that the buffer readers are not directed to is
+    // being written.
+    m_sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    store(m_buffers[index(sequence + 2)], p_value);
+    m_sequence.store(sequence + 2, std::memory_order_release);
+  }
+
+  /**
+   * @return T - copy of the most recently published value, or a T with every
+   * byte zero if nothing has been published yet.
+   */
+  [[nodiscard]] T read() const
+  {
+    while (true) {
+      auto const before = m_sequence.load(std::memory_order_acquire);
+      T copy = load(m_buffers[index(before)]);
+      std::atomic_thread_fence(std::memory_order_acquire);
+      auto const after = m_sequence.load(std::memory_order_relaxed);
+      // The buffer that was copied is only rewritten by the publish that
+      // begins after the next one completes.
+      if (after - before <= 2 - (before & 1U)) {
+        return copy;
+      }
+    }
+  }
+
+  /**
+   * @return std::uint32_t - number of values published so far
+   */
+  [[nodiscard]] std::uint32_t version() const
+  {
+    return m_sequence.load(std::memory_order_acquire) / 2;
+  }
+
+private:
+  static constexpr std::size_t index(std::uint32_t p_sequence)
+  {
+    return (p_sequence / 2) % 2;
+  }
+
+  using bytes = std::array<unsigned char, sizeof(T)>;
+
+  static void store(bytes& p_buffer, T const& p_value)
+  {
+    auto const source = std::bit_cast<bytes>(p_value);
+    for (std::size_t i = 0; i < source.size(); i++) {
+      std::atomic_ref(p_buffer[i]).store(source[i], std::memory_order_relaxed);
+    }
+  }
+
+  static T load(bytes& p_buffer)
+  {
+    bytes copy;
+    for (std::size_t i = 0; i < copy.size(); i++) {
+      copy[i] = std::atomic_ref(p_buffer[i]).load(std::memory_order_relaxed);
+    }
+    return std::bit_cast<T>(copy);
+  }
+
+  // Only accessed through std::atomic_ref, which needs non-const objects
+  mutable std::array<bytes, 2> m_buffers{};
+  std::atomic<std::uint32_t> m_sequence{ 0 };
+};
+}  // namespace hal::expander
@@ -0,0 +1,159 @@
+// Copyright 2024 Khalil Estell
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+#include <libhal/functional.hpp>
+#include <libhal/i2c.hpp>
+#include <libhal/units.hpp>
+
+namespace hal::expander {
+/**
+ * @brief tca9548 and pca9548 driver: 8 port i2c multiplexer
+ *
+ * Devices with the same address, such as several pca9685 boards, can share a
+ * bus by each sitting behind their own port of the multiplexer. Each port is
+ * presented as its own `hal::i2c`, which selects the port before forwarding a
+ * transaction. The driver remembers which port is selected and only writes the
+ * multiplexer's control register when the port changes, so any number of
+ * transactions to devices behind one port cost a single select.
+ *
+ * To keep selects to one per port per cycle, run the work of each port
+ * together, for example with `run_grouped_by_port()`.
+ *
+ * USAGE:
+ *
+ *    hal::expander::tca9548 mux(i2c);
+ *    auto port0 = mux.get_port<0>();
+ *    auto port1 = mux.get_port<1>();
+ *    hal::expander::pca9685 left(port0, 0b100'0000);
+ *    hal::expander::pca9685 right(port1, 0b100'0000);
+ */
+class tca9548
+{
+public:
+  /// Number of downstream ports
+  static constexpr std::size_t port_count = 8;
+
+  /**
+   * @brief The i2c bus behind one port of the multiplexer
+   *
+   */
+  class port : public hal::i2c
+  {
+  private:
+    port(tca9548* p_tca9548, hal::byte p_port);
+
+    void driver_configure(settings const& p_settings) override;
+    void driver_transaction(
+      hal::byte p_address,
+      std::span<hal::byte const> p_data_out,
+      std::span<hal::byte> p_data_in,
+      hal::function_ref<hal::timeout_function> p_timeout) override;
+
+    tca9548* m_tca9548;
+    hal::byte m_port;
+
+    friend class tca9548;
+  };
+
+  /**
+   * @param p_i2c - upstream i2c bus the multiplexer is connected to. Must
+   * outlive this object.
+   * @param p_address - address of the multiplexer, from 0x70 to 0x77
+   * depending on the A2 to A0 pins.
+   */
+  explicit tca9548(hal::i2c& p_i2c, hal::byte p_address = default_address);
+
+  /**
+   * @brief Get the i2c bus of a port
+   *
+   * The port references this driver, which must outlive it.
+   *
+   * @tparam port_number - port from 0 to 7
+   * @return port - implementation of hal::i2c for the port
+   */
+  template<hal::byte port_number>
+  port get_port()
+  {
+    static_assert(port_number < port_count, "The TCA9548 only has 8 ports!");
+    return port(this, port_number);
+  }
+
+  /**
+   * @brief Connect a port to the upstream bus
+   *
+   * Does nothing if the port is already selected.
+   *
+   * @param p_port - port from 0 to 7
+   * @param p_timeout - timeout for the select
+   * @throws hal::argument_out_of_domain - if p_port out of range (>7)
+   * @throws any exception thrown by the upstream i2c's transaction
+   */
+  void select(hal::byte p_port,
+              hal::function_ref<hal::timeout_function> p_timeout =
+                hal::never_timeout());
+
+  /**
+   * @brief Forget the selected port so the next transaction selects again
+   *
+   * Needed if the multiplexer may have been changed behind the driver's back,
+   * such as by a reset or another bus master.
+   */
+  void invalidate();
+
+  /**
+   * @return std::uint32_t - number of control register writes made
+   */
+  [[nodiscard]] std::uint32_t select_count() const;
+
+private:
+  static constexpr hal::byte default_address = 0x70;
+  static constexpr hal::byte unknown_port = 0xFF;
+
+  hal::i2c* m_i2c;
+  hal::byte m_address;
+  hal::byte m_selected = unknown_port;
+  std::uint32_t m_select_count = 0;
+};
+
+/**
+ * @brief Work that communicates through one port of a multiplexer
+ *
+ */
+struct tca9548_job
+{
+  /// port the job's devices are behind
+  hal::byte port;
+  /// work to run, such as a tla2528 scan or a pca9685 update
+  hal::callback<void()> job;
+};
+
+/**
+ * @brief Run jobs with the jobs of each port together
+ *
+ * Jobs are reordered by port, keeping the order of jobs that share a port, and
+ * then run. With a cached select this costs one select per port used. Jobs
+ * are sorted in place, so running the same span again does not reorder it.
+ *
+ * @param p_jobs - jobs to run
+ * @throws any exception thrown by a job, after which the remaining jobs are
+ * not run
+ */
+void run_grouped_by_port(std::span<tca9548_job> p_jobs);
+}  // namespace hal::expander
@@ -0,0 +1,334 @@
+// Copyright 2024 Khalil Estell
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+#include <libhal/error.hpp>
+#include <libhal/steady_clock.hpp>
+#include <libhal/units.hpp>
+
+#include <libhal-expander/tla2528.hpp>
+
+namespace hal::expander {
+/**
+ * @brief Condition on one pin that ends the pre-trigger phase of a capture
+ *
+ */
+struct tla2528_trigger
+{
+  enum class condition : hal::byte
+  {
+    /// The code crosses the threshold going up: previous below, current at
+    /// or above
+    rising_edge,
+    /// The code crosses the threshold going down: previous above, current at
+    /// or below
+    falling_edge,
+    /// The code is at or above the threshold
+    above,
+    /// The code is at or below the threshold
+    below,
+    /// The code rose by at least the threshold since the previous sample
+    rising_slope,
+    /// The code fell by at least the threshold since the previous sample
+    falling_slope,
+  };
+
+  /// Pin to watch, from 0 to 7. It must be one of the captured pins.
+  hal::byte pin = 0;
+  condition when = condition::rising_edge;
+  /// Level in codes, or change in codes per sample for the slope conditions
+  std::uint16_t threshold = 2048;
+
+  /**
+   * @param p_previous - code of the previous sample
+   * @param p_current - code of the current sample
+   * @return true - if the condition is met
+   */
+  [[nodiscard]] constexpr bool met(std::uint16_t p_previous,
+                                   std::uint16_t p_current) const
+  {
+    std::int32_t const change = p_current - p_previous;
+    switch (when) {
+      case condition::rising_edge:
+        return p_previous < threshold && p_current >= threshold;
+      case condition::falling_edge:
+        return p_previous > threshold && p_current <= threshold;
+      case condition::above:
+        return p_current >= threshold;
+      case condition::below:
+        return p_current <= threshold;
+      case condition::rising_slope:
+        return change >= threshold;
+      case condition::falling_slope:
+        return -change >= threshold;
+    }
+    return false;
+  }
+};
+
+/**
+ * @brief One scan of a capture
+ *
+ */
+struct tla2528_capture_sample
+{
+  /// Uptime of the clock, in ticks, when the scan started
+  std::uint64_t timestamp = 0;
+  /// Conversion result of each pin by pin number. Pins that are not captured
+  /// are 0.
+  std::array<std::uint16_t, 8> codes{};
+};
+
+/**
+ * @brief Oscilloscope style triggered capture of tla2528 pins
+ *
+ * Once armed, every call to `sample()` scans the captured pins into a ring
+ * buffer and checks the trigger on the new sample with integer comparisons.
+ * The trigger is only checked once the ring holds the requested number of
+ * pre-trigger samples. After the trigger, the requested number of
+ * post-trigger samples are taken, the first of which is the sample that met
+ * the trigger, and the capture is complete. The ring is then reordered in
+ * place so that `samples()` is a single contiguous span, oldest first, with
+ * the trigger sample at `trigger_index()`.
+ *
+ * The buffer is part of the object, so the memory used is fixed at compile
+ * time.
+ *
+ * USAGE:
+ *
+ *    hal::expander::tla2528_capture<256> capture(adc, clock, {
+ *      .pins = 0b0000'0011,
+ *      .trigger = { .pin = 0, .when = tla2528_trigger::condition::rising_edge,
+ *                   .threshold = 3000 },
+ *      .pre_trigger = 64,
+ *      .post_trigger = 192,
+ *    });
+ *    capture.arm();
+ *    while (!capture.sample()) {
+ *      // pace the samples, such as with a timer
+ *    }
+ *    export_samples(capture.samples());
+ *
+ * @tparam capacity - largest number of samples in one capture
+ */
+template<std::size_t capacity>
+class tla2528_capture
+{
+public:
+  static_assert(capacity > 0, "A capture must hold at least one sample");
+
+  struct settings
+  {
+    /// Bit field of the pins to capture, bit 0 is pin 0. Their pin mode must
+    /// be set to adc.
+    hal::byte pins = 0b0000'0001;
+    tla2528_trigger trigger{};
+    /// Samples kept from before the trigger
+    std::size_t pre_trigger = capacity / 2;
+    /// Samples taken from the trigger onwards, at least 1
+    std::size_t post_trigger = capacity - capacity / 2;
+  };
+
+  enum class state : hal::byte
+  {
+    /// Not sampling, the previous capture, if any, was discarded
+    idle,
+    /// Sampling and waiting for the trigger
+    armed,
+    /// Taking the post-trigger samples
+    triggered,
+    /// The capture is ready to be read
+    complete,
+  };
+
+  /**
+   * @param p_tla2528 - device to sample. Must outlive this object.
+   * @param p_clock - clock the samples are timestamped with. Must outlive
+   * this object.
+   * @param p_settings - what to capture
+   * @throws hal::argument_out_of_domain - if the samples do not fit in the
+   * capacity, there are no post-trigger samples, or the trigger pin is not
+   * captured
+   */
+  tla2528_capture(tla2528& p_tla2528,
+                  hal::steady_clock& p_clock,
+                  settings const& p_settings)
+    : m_tla2528(&p_tla2528)
+    , m_clock(&p_clock)
+  {
+    configure(p_settings);
+  }
+
+  /**
+   * @brief Change what is captured, the capture returns to idle
+   *
+   * @param p_settings - what to capture
+   * @throws hal::argument_out_of_domain - see constructor
+   */
+  void configure(settings const& p_settings)
+  {
+    auto const& trigger = p_settings.trigger;
+    if (p_settings.post_trigger == 0 || p_settings.post_trigger > capacity ||
+        p_settings.pre_trigger > capacity - p_settings.post_trigger ||
+        trigger.pin > 7 ||
+        !(p_settings.pins & (1U << trigger.pin))) {
+      throw hal::argument_out_of_domain(this);
+    }
+    m_settings = p_settings;
+    m_state = state::idle;
+    m_force = false;
+  }
+
+  /**
+   * @brief Discard the previous capture and start sampling for a new one
+   *
+   */
+  void arm()
+  {
+    m_head = 0;
+    m_stored = 0;
+    m_remaining = m_settings.post_trigger;
+    m_state = state::armed;
+    m_force = false;
+  }
+
+  /**
+   * @brief Trigger on the next sample regardless of the condition
+   *
+   * Useful to capture the current signal when the condition never occurs.
+   * Fewer pre-trigger samples are kept if fewer were taken since arming. The
+   * request is dropped by the next `arm()` or `configure()`.
+   */
+  void force_trigger()
+  {
+    m_force = true;
+  }
+
+  /**
+   * @brief Scan the captured pins and advance the capture
+   *
+   * Does nothing if the capture is idle or complete.
+   *
+   * @return true - if the capture is complete
+   */
+  bool sample()
+  {
+    if (m_state == state::idle || m_state == state::complete) {
+      return m_state == state::complete;
+    }
+
+    auto& slot = m_ring[m_head];
+    auto const previous = m_ring[previous_index()].codes[trigger_pin()];
+    slot.timestamp = m_clock->uptime();
+    slot.codes.fill(0);
+    m_tla2528->scan(m_settings.pins, slot.codes);
+    m_head = (m_head + 1) % length();
+    if (m_stored < length()) {
+      m_stored++;
+    }
+
+    if (m_state == state::armed) {
+      bool const primed = m_stored > m_settings.pre_trigger;
+      bool const has_previous = m_stored > 1;
+      if (m_force ||
+          (primed && has_previous &&
+           m_settings.trigger.met(previous, slot.codes[trigger_pin()]))) {
+        m_force = false;
+        m_state = state::triggered;
+      }
+    }
+
+    if (m_state == state::triggered) {
+      m_remaining--;
+      if (m_remaining == 0) {
+        finish();
+      }
+    }
+    return m_state == state::complete;
+  }
+
+  /**
+   * @return state - progress of the capture
+   */
+  [[nodiscard]] state current_state() const
+  {
+    return m_state;
+  }
+
+  /**
+   * @return std::span<tla2528_capture_sample const> - the captured samples,
+   * oldest first, or an empty span if the capture is not complete
+   */
+  [[nodiscard]] std::span<tla2528_capture_sample const> samples() const
+  {
+    if (m_state != state::complete) {
+      return {};
+    }
+    return std::span(m_ring).first(m_stored);
+  }
+
+  /**
+   * @return std::size_t - index in `samples()` of the sample that met the
+   * trigger
+   */
+  [[nodiscard]] std::size_t trigger_index() const
+  {
+    return m_stored - m_settings.post_trigger;
+  }
+
+private:
+  std::size_t length() const
+  {
+    return m_settings.pre_trigger + m_settings.post_trigger;
+  }
+
+  std::size_t previous_index() const
+  {
+    return (m_head + length() - 1) % length();
+  }
+
+  hal::byte trigger_pin() const
+  {
+    return m_settings.trigger.pin;
+  }
+
+  void finish()
+  {
+    // Once the ring has wrapped, the oldest sample is the one about to be
+    // overwritten
+    if (m_stored == length()) {
+      std::rotate(m_ring.begin(), m_ring.begin() + m_head,
+                  m_ring.begin() + length());
+    }
+    m_state = state::complete;
+  }
+
+  std::array<tla2528_capture_sample, capacity> m_ring{};
+  tla2528* m_tla2528;
+  hal::steady_clock* m_clock;
+  settings m_settings{};
+  std::size_t m_head = 0;
+  std::size_t m_stored = 0;
+  std::size_t m_remaining = 0;
+  state m_state = state::idle;
+  bool m_force = false;
+};
+}  // namespace hal::expander
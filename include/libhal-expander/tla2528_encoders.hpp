@@ -0,0 +1,145 @@
+// Copyright 2024 Khalil Estell
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+#include <libhal/units.hpp>
+
+#include <libhal-expander/tla2528.hpp>
+
+namespace hal::expander {
+/**
+ * @brief Digital input pins carrying the A and B signals of an encoder
+ *
+ */
+struct encoder_pins
+{
+  hal::byte a;
+  hal::byte b;
+};
+
+/**
+ * @brief Quadrature decoder for up to 4 encoders on tla2528 input pins
+ *
+ * All encoders are sampled together with a single read of the device's
+ * digital inputs. Each sample is decoded through a state transition table
+ * without branches: every edge of A or B moves the position by one count,
+ * so a detent of a typical encoder is 4 counts. A sample in which both A and
+ * B changed cannot be decoded, as the direction is unknown, and is counted as
+ * an error instead. Errors mean the encoder moved faster than it is sampled.
+ *
+ * USAGE:
+ *
+ *    std::array<hal::expander::encoder_pins, 2> pins{ { { 0, 1 }, { 2, 3 } } };
+ *    auto knobs = hal::expander::make_encoders(tla2528, pins);
+ *    while (true) {
+ *      knobs.sample();
+ *      volume = knobs.position(0) / 4;
+ *    }
+ */
+class tla2528_encoders
+{
+public:
+  /// Most encoders a single tla2528 can decode
+  static constexpr std::size_t max_encoders = 4;
+
+  tla2528_encoders(tla2528_encoders const&) = delete;
+  tla2528_encoders& operator=(tla2528_encoders const&) = delete;
+  tla2528_encoders(tla2528_encoders&&) = delete;
+  tla2528_encoders& operator=(tla2528_encoders&&) = delete;
+  ~tla2528_encoders();
+
+  friend tla2528_encoders make_encoders(
+    tla2528& p_tla2528,
+    std::span<encoder_pins const> p_pins);
+
+  /**
+   * @brief Read the input pins and decode every encoder
+   *
+   */
+  void sample();
+
+  /**
+   * @brief Decode every encoder from an input bus value read elsewhere
+   *
+   * For applications that already read the digital inputs for other pins.
+   *
+   * @param p_input_bus - digital input levels as returned by
+   * `tla2528::get_input_bus()`
+   */
+  void decode(hal::byte p_input_bus);
+
+  /**
+   * @param p_encoder - index of the encoder in the pins given at creation
+   * @return std::int32_t - position in counts, wrapping on overflow
+   */
+  [[nodiscard]] std::int32_t position(std::size_t p_encoder) const;
+
+  /**
+   * @param p_encoder - index of the encoder in the pins given at creation
+   * @return std::uint32_t - number of samples that could not be decoded
+   */
+  [[nodiscard]] std::uint32_t errors(std::size_t p_encoder) const;
+
+  /**
+   * @brief Set the position of an encoder and clear its error count
+   *
+   * @param p_encoder - index of the encoder in the pins given at creation
+   * @param p_position - new position in counts
+   */
+  void reset(std::size_t p_encoder, std::int32_t p_position = 0);
+
+  /**
+   * @return std::size_t - number of encoders decoded
+   */
+  [[nodiscard]] std::size_t count() const;
+
+private:
+  struct encoder_state
+  {
+    encoder_pins pins{};
+    hal::byte state = 0;
+    std::uint32_t position = 0;
+    std::uint32_t errors = 0;
+  };
+
+  tla2528_encoders(tla2528& p_tla2528, std::span<encoder_pins const> p_pins);
+  hal::byte channel_mask() const;
+
+  tla2528* m_tla2528;
+  std::array<encoder_state, max_encoders> m_encoders{};
+  std::size_t m_count = 0;
+};
+
+/**
+ * @brief create a quadrature decoder using the tla2528 driver
+ *
+ * Every pin is set to a digital input and the initial state of each encoder
+ * is read.
+ *
+ * @param p_tla2528 tla2528 the encoders are connected to
+ * @param p_pins A and B pins of each encoder
+ * @throws hal::argument_out_of_domain - if more than 4 encoders are given, a
+ * pin is out of range (>7) or a pin is used twice.
+ * @throws hal::resource_unavailable_try_again - if an adapter has already been
+ * made for one of the pins
+ */
+tla2528_encoders make_encoders(tla2528& p_tla2528,
+                               std::span<encoder_pins const> p_pins);
+}  // namespace hal::expander
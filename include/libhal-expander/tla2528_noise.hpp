@@ -0,0 +1,115 @@
+// Copyright 2024 Khalil Estell
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+#include <libhal/units.hpp>
+
+#include <libhal-expander/tla2528.hpp>
+
+namespace hal::expander {
+/// Number of oversampling ratios of the tla2528, x1 through x128
+inline constexpr std::size_t tla2528_oversampling_count = 8;
+
+/**
+ * @brief Noise of one pin measured at one oversampling ratio
+ *
+ */
+struct tla2528_noise_stats
+{
+  /// Mean of the samples in thousandths of a code
+  std::uint32_t mean_millicodes = 0;
+  /// Standard deviation of the samples in thousandths of a code
+  std::uint32_t std_dev_millicodes = 0;
+  /// Difference between the largest and smallest sample in codes
+  std::uint16_t peak_to_peak = 0;
+  /// Resolution left after noise: 12 minus the bits the noise spans beyond
+  /// ideal quantization noise (1/sqrt(12) codes). At most 12 plus one bit per
+  /// doubling of the ratio, up to the 16 bits of an oversampled result.
+  float effective_bits = 0.0f;
+};
+
+/**
+ * @brief Settings of `characterize_noise()`
+ *
+ */
+struct tla2528_noise_settings
+{
+  /// Bit field of the pins to measure, bit 0 is pin 0. Their pin mode must be
+  /// set to adc and their inputs held steady during the measurement.
+  hal::byte pins = 0xFF;
+  /// Samples taken per pin at each ratio, from 2 to 1024
+  std::uint16_t samples = 64;
+  /// Largest acceptable standard deviation of each pin, in thousandths of a
+  /// code
+  std::array<std::uint32_t, 8> max_std_dev_millicodes{
+    1000, 1000, 1000, 1000, 1000, 1000, 1000, 1000,
+  };
+  /// Leave the device at the chosen ratio rather than the ratio it had before
+  bool apply = true;
+};
+
+/**
+ * @brief Result of `characterize_noise()`
+ *
+ */
+struct tla2528_noise_profile
+{
+  /// Measurements indexed by ratio then pin. Entries of pins that were not
+  /// measured are 0.
+  std::array<std::array<tla2528_noise_stats, 8>, tla2528_oversampling_count>
+    stats{};
+  /// Smallest ratio that meets the target of each measured pin, x128 if none
+  /// does. Entries of pins that were not measured are x1.
+  std::array<tla2528_oversampling, 8> pin_ratio{};
+  /// Bit field of the measured pins that no ratio meets the target of
+  hal::byte unmet = 0;
+  /// The ratio for the device, the largest ratio any measured pin needs. The
+  /// device averages every pin with the same ratio.
+  tla2528_oversampling ratio = tla2528_oversampling::x1;
+};
+
+/**
+ * @brief Pick the oversampling ratio with the highest sample rate that meets
+ * a noise target
+ *
+ * Samples every selected pin at every ratio with `tla2528::scan_frames()` and
+ * computes the noise statistics of each with integer sums, so it is suitable
+ * for running on the target at startup or commissioning. The raw frames keep
+ * the fraction of a code of oversampled averages, so noise below one code is
+ * resolved down to a sixteenth of a code. If a scan throws, the device's
+ * original ratio is restored before the error is rethrown.
+ *
+ * USAGE:
+ *
+ *    auto const profile = hal::expander::characterize_noise(adc, {
+ *      .pins = 0b0000'0011,
+ *      .samples = 256,
+ *      .max_std_dev_millicodes = { 500, 2000 },
+ *    });
+ *    // adc now averages with profile.ratio
+ *
+ * @param p_tla2528 - device to measure
+ * @param p_settings - pins, sample count and noise targets
+ * @return tla2528_noise_profile - measurements and the chosen ratios
+ * @throws hal::argument_out_of_domain - if the sample count is out of range
+ * @throws any exception thrown by the device's transactions
+ */
+[[nodiscard]] tla2528_noise_profile characterize_noise(
+  tla2528& p_tla2528,
+  tla2528_noise_settings const& p_settings = {});
+}  // namespace hal::expander
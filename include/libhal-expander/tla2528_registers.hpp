@@ -0,0 +1,246 @@
+// Copyright 2024 Khalil Estell
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+#include <libhal-util/bit.hpp>
+#include <libhal/units.hpp>
+
+#include <libhal-expander/register_map.hpp>
+
+namespace hal::expander {
+/**
+ * @brief Services a tla2528 pin can provide
+ *
+ */
+enum class tla2528_pin_mode : hal::byte
+{
+  adc,
+  input_pin,
+  output_pin_open_drain,
+  output_pin_push_pull
+};
+
+/**
+ * @brief Number of conversions averaged into each tla2528 result
+ *
+ */
+enum class tla2528_oversampling : hal::byte
+{
+  x1,
+  x2,
+  x4,
+  x8,
+  x16,
+  x32,
+  x64,
+  x128,
+};
+
+/**
+ * @brief tla2528 register map and encoding shared by `tla2528` and
+ * `basic_tla2528`
+ *
+ */
+namespace tla2528_registers {
+enum op_codes : hal::byte
+{
+  single_register_read = 0b0001'0000,
+  single_register_write = 0b0000'1000,
+  set_bit = 0b0001'1000,
+  clear_bit = 0b0010'0000,
+  // Continuously reads data from a group of registers. Provide the first
+  // address to read from, if it runs out of valid addresses to read, it
+  // returns zeros. (See Figure 30 on datasheet)
+  continuous_register_read = 0b0011'0000,
+  // Continuously writes data to a group of registers. Provide the first
+  // address to write to.The data sent will automatically write the data to
+  // the next register in ascending order. (See Figure 32 on datasheet)
+  continuous_register_write = 0b0010'1000
+};
+
+/// Shadow of SYSTEM_STATUS (0x00) through AUTO_SEQ_CH_SEL (0x12)
+using image = register_shadow<0x00, 0x13>;
+
+using system_status = register_id<0x0>;
+using general_cfg = register_id<0x1>;
+using data_cfg = register_id<0x2>;
+using osr_cfg = register_id<0x3>;
+using opmode_cfg = register_id<0x4>;
+using pin_cfg = register_id<0x5>;
+using gpio_cfg = register_id<0x7>;
+using gpo_drive_cfg = register_id<0x9>;
+using gpo_value = register_id<0xB>;
+using gpi_value = register_id<0xD>;
+using sequence_cfg = register_id<0x10>;
+using channel_sel = register_id<0x11>;
+using auto_seq_ch_sel = register_id<0x12>;
+
+using manual_channel_id =
+  register_field<channel_sel, hal::bit_mask::from<3, 0>()>;
+using oversampling_ratio =
+  register_field<osr_cfg, hal::bit_mask::from<2, 0>()>;
+
+// PIN_CFG through GPO_DRIVE_CFG, including the reserved bytes between them
+constexpr std::size_t pin_config_width =
+  gpo_drive_cfg::address - pin_cfg::address + 1;
+
+// A new write costs the device address, op code, and register address bytes,
+// so re-sending up to two known bytes is never worse.
+constexpr std::size_t max_burst_gap = 2;
+
+/// Number of pins on the device
+constexpr hal::byte channel_count = 8;
+
+/**
+ * @brief Set the PIN_CFG, GPIO_CFG and GPO_DRIVE_CFG bits of one pin
+ *
+ * @param p_registers - register image holding known pin configuration
+ * registers to update
+ * @param p_mode - desired pin mode
+ * @param p_channel - pin to configure, from 0 to 7
+ */
+constexpr void insert_pin_mode(image& p_registers,
+                               tla2528_pin_mode p_mode,
+                               hal::byte p_channel)
+{
+  hal::byte pin_cfg_reg = p_registers.get<pin_cfg>();
+  hal::byte gpio_cfg_reg = p_registers.get<gpio_cfg>();
+  hal::byte gpo_drive_cfg_reg = p_registers.get<gpo_drive_cfg>();
+
+  hal::bit_mask channel_mask = hal::bit_mask::from(p_channel);
+  if (p_mode == tla2528_pin_mode::output_pin_push_pull ||
+      p_mode == tla2528_pin_mode::output_pin_open_drain) {
+    hal::bit_modify(pin_cfg_reg).set(channel_mask);
+    hal::bit_modify(gpio_cfg_reg).set(channel_mask);
+    if (p_mode == tla2528_pin_mode::output_pin_push_pull) {
+      hal::bit_modify(gpo_drive_cfg_reg).set(channel_mask);
+    } else {
+      hal::bit_modify(gpo_drive_cfg_reg).clear(channel_mask);
+    }
+  } else if (p_mode == tla2528_pin_mode::adc) {
+    hal::bit_modify(pin_cfg_reg).clear(channel_mask);
+  } else {  // must be tla2528_pin_mode::input_pin
+    hal::bit_modify(pin_cfg_reg).set(channel_mask);
+    hal::bit_modify(gpio_cfg_reg).clear(channel_mask);
+  }
+
+  p_registers.set<pin_cfg>(pin_cfg_reg);
+  p_registers.set<gpio_cfg>(gpio_cfg_reg);
+  p_registers.set<gpo_drive_cfg>(gpo_drive_cfg_reg);
+}
+
+/**
+ * @brief Extract the raw 16-bit frame of a manual mode read
+ *
+ * The upper 12 bits hold the code. With oversampling enabled, the lower 4 bits
+ * hold the fraction of a code of the average, in sixteenths of a code.
+ * Without oversampling they are 0.
+ *
+ * @param p_data - the two bytes read from the device
+ * @return std::uint16_t - conversion result in sixteenths of a code
+ */
+constexpr std::uint16_t adc_frame(std::array<hal::byte, 2> const& p_data)
+{
+  return static_cast<std::uint16_t>(p_data[0] << 8 | p_data[1]);
+}
+
+/**
+ * @brief Extract the 12-bit conversion result of a manual mode read
+ *
+ * The 12 bit number is stored in the first 12 bits of the 2 bytes read (See
+ * Figure 25 on datasheet). With oversampling enabled, the frame holds a 16-bit
+ * average instead, whose last 4 bits are a fraction of a code. The average is
+ * rounded to the nearest 12-bit code, which leaves results without
+ * oversampling unchanged.
+ *
+ * @param p_data - the two bytes read from the device
+ * @return std::uint16_t - conversion result from 0 to 4095
+ */
+constexpr std::uint16_t adc_code(std::array<hal::byte, 2> const& p_data)
+{
+  constexpr std::uint32_t max_code = 4095;
+  std::uint32_t const frame = adc_frame(p_data);
+  return static_cast<std::uint16_t>(std::min((frame + 8) >> 4, max_code));
+}
+
+/// Codes in the converter's full scale, one LSB is the reference / 4096
+constexpr std::uint32_t full_scale_codes = 4096;
+
+/**
+ * @brief Convert a conversion result to microvolts with integer math
+ *
+ * The voltage is `p_code` / `p_reference_code` of the reference voltage,
+ * rounded to the nearest microvolt. With the default reference code, the
+ * reference is AVDD. With a measured reference code, the reference is the
+ * voltage of the input that produced it.
+ *
+ * @param p_code - conversion result from 0 to 4095
+ * @param p_reference_microvolts - reference voltage in microvolts
+ * @param p_reference_code - code the reference voltage reads as, not 0
+ * @return std::uint32_t - voltage in microvolts
+ */
+constexpr std::uint32_t code_to_microvolts(
+  std::uint16_t p_code,
+  std::uint32_t p_reference_microvolts,
+  std::uint32_t p_reference_code = full_scale_codes)
+{
+  // code * reference needs more than 32 bits for references above ~1 V
+  auto const product = std::uint64_t{ p_code } * p_reference_microvolts;
+  return static_cast<std::uint32_t>((product + p_reference_code / 2) /
+                                    p_reference_code);
+}
+
+/**
+ * @brief Write a register burst into a transaction buffer
+ *
+ * @param p_buffer - buffer large enough for the op code, register address and
+ * data
+ * @param p_register - address of the first register in the burst
+ * @param p_data - register values of the burst
+ * @return std::span<hal::byte const> - the bytes to write to the device
+ */
+constexpr std::span<hal::byte const> burst(
+  std::array<hal::byte, image::size + 2>& p_buffer,
+  hal::byte p_register,
+  std::span<hal::byte const> p_data)
+{
+  p_buffer[0] = p_data.size() == 1 ? op_codes::single_register_write
+                                   : op_codes::continuous_register_write;
+  p_buffer[1] = p_register;
+  std::copy(p_data.begin(), p_data.end(), p_buffer.begin() + 2);
+  return std::span(p_buffer).first(p_data.size() + 2);
+}
+}  // namespace tla2528_registers
+
+/**
+ * @brief State of an initialized tla2528 known ahead of time
+ *
+ * Produced by `initial_state()` from a board description, so that a tla2528
+ * driver can be constructed for a device initialized by a board init script
+ * without any bus traffic.
+ */
+struct tla2528_state
+{
+  hal::byte address = 0;
+  /// Register values of the device after initialization, marked known
+  tla2528_registers::image registers{};
+};
+}  // namespace hal::expander
@@ -0,0 +1,309 @@
+// Copyright 2024 Khalil Estell
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include <libhal/steady_clock.hpp>
+#include <libhal/units.hpp>
+
+/**
+ * LIBHAL_EXPANDER_TRACING=1 enables tracepoints. Set it with the conan option
+ * `tracing` or the CMake option of the same name, both of which add it to the
+ * public compile definitions of the library target so that every translation
+ * unit sees the same value. When it is 0, every tracepoint compiles to
+ * nothing.
+ */
+#if !defined(LIBHAL_EXPANDER_TRACING)
+#define LIBHAL_EXPANDER_TRACING 0
+#endif
+
+namespace hal::expander {
+/// true if tracepoints were enabled at compile time
+inline constexpr bool tracing_enabled = LIBHAL_EXPANDER_TRACING != 0;
+
+/**
+ * @brief Driver operations that emit tracepoints
+ *
+ */
+enum class trace_op : hal::byte
+{
+  pca9685_configure,
+  pca9685_frequency,
+  pca9685_duty_cycle,
+  tla2528_set_pin_mode,
+  tla2528_set_output,
+  tla2528_get_output,
+  tla2528_get_input,
+  tla2528_adc_reading,
+  pca9685_channel_ticks,
+  tla2528_scan,
+  pca9685_channel_edges,
+  tla2528_oversampling,
+  pca9685_deferred_flush,
+  /// Number of operations, not an operation
+  count,
+};
+
+/**
+ * @brief Points within an operation where a tracepoint is emitted
+ *
+ * Every operation emits `entry` followed by zero or more `bus_begin` and
+ * `bus_end` pairs, one around each i2c transaction, and then `exit`. Between
+ * them, `compute_begin` and `compute_end` pairs surround the computation of
+ * register values, such as float duty cycle math, and the building of
+ * transaction buffers. `exit` is also emitted when the operation throws, in
+ * which case the last `bus_begin` may have no matching `bus_end`. Operations
+ * may nest, such as `pca9685_frequency` which reconfigures the device.
+ */
+enum class trace_phase : hal::byte
+{
+  entry,
+  bus_begin,
+  bus_end,
+  exit,
+  compute_begin,
+  compute_end,
+};
+
+/**
+ * @brief Destination of driver tracepoints
+ *
+ * Implementations should be fast as they run inline with the driver, for
+ * example by reading a cycle counter and storing it in a ring buffer.
+ */
+class trace_sink
+{
+public:
+  /**
+   * @brief Record a tracepoint
+   *
+   * @param p_op - operation emitting the tracepoint
+   * @param p_phase - point within the operation
+   */
+  void record(trace_op p_op, trace_phase p_phase)
+  {
+    driver_record(p_op, p_phase);
+  }
+
+  virtual ~trace_sink() = default;
+
+private:
+  virtual void driver_record(trace_op p_op, trace_phase p_phase) = 0;
+};
+
+/**
+ * @brief Set the sink every driver's tracepoints are sent to
+ *
+ * Has no effect on drivers unless tracing is enabled at compile time.
+ *
+ * @param p_sink - sink to send tracepoints to, or nullptr to discard them.
+ * Must outlive its use as the sink.
+ */
+void set_trace_sink(trace_sink* p_sink);
+
+/**
+ * @return trace_sink* - the current sink, nullptr if there is none
+ */
+[[nodiscard]] trace_sink* get_trace_sink();
+
+/**
+ * @brief Emit a tracepoint to the current sink
+ *
+ * Compiles to nothing if tracing is disabled.
+ *
+ * @param p_op - operation emitting the tracepoint
+ * @param p_phase - point within the operation
+ */
+inline void tracepoint([[maybe_unused]] trace_op p_op,
+                       [[maybe_unused]] trace_phase p_phase)
+{
+  if constexpr (tracing_enabled) {
+    if (auto* sink = get_trace_sink(); sink != nullptr) {
+      sink->record(p_op, p_phase);
+    }
+  }
+}
+
+/**
+ * @brief Emits the entry and exit tracepoints of an operation
+ *
+ * Place at the top of the operation. `exit` is emitted when the scope ends,
+ * including by an exception.
+ */
+class trace_scope
+{
+public:
+  /**
+   * @param p_op - operation being traced
+   */
+  explicit trace_scope(trace_op p_op)
+    : m_op(p_op)
+  {
+    tracepoint(m_op, trace_phase::entry);
+  }
+
+  trace_scope(trace_scope const&) = delete;
+  trace_scope& operator=(trace_scope const&) = delete;
+
+  ~trace_scope()
+  {
+    tracepoint(m_op, trace_phase::exit);
+  }
+
+private:
+  trace_op m_op;
+};
+
+/**
+ * @brief Convert steady clock ticks to nanoseconds exactly
+ *
+ * Whole seconds and the remaining ticks are converted separately with integer
+ * math, so the result neither overflows nor loses precision for long
+ * latencies.
+ *
+ * @param p_ticks - ticks of the clock
+ * @param p_frequency - frequency of the clock, values below 1 Hz are treated
+ * as 1 Hz
+ * @return std::uint64_t - the ticks in nanoseconds, rounded down
+ */
+[[nodiscard]] std::uint64_t ticks_to_nanoseconds(std::uint64_t p_ticks,
+                                                 hal::hertz p_frequency);
+
+/**
+ * @brief Nearest rank of a percentile
+ *
+ * Computed in integer math from the fraction in parts per million, so that
+ * 0.99f of 100 samples is exactly rank 99 and large counts do not lose
+ * precision.
+ *
+ * @param p_count - number of samples
+ * @param p_fraction - fraction of the samples, from 0.0f to 1.0f, such as
+ * 0.99f for the 99th percentile. Values outside are clamped.
+ * @return std::uint64_t - rank from 1 to p_count of the sample at the
+ * percentile in ascending order. 0 if p_count is 0.
+ */
+[[nodiscard]] std::uint64_t percentile_rank(std::uint64_t p_count,
+                                            float p_fraction);
+
+/**
+ * @brief Histogram of latencies with power of two nanosecond buckets
+ *
+ */
+struct latency_histogram
+{
+  /// Bucket 0 counts latencies of 0 ns. Bucket N counts latencies from
+  /// 2^(N-1) ns up to, but not including, 2^N ns. The last bucket also counts
+  /// everything larger.
+  std::array<std::uint32_t, 40> buckets{};
+  /// Number of latencies recorded
+  std::uint32_t count = 0;
+  /// Largest latency recorded in nanoseconds
+  std::uint64_t max = 0;
+
+  /**
+   * @brief Add a latency to the histogram
+   *
+   * @param p_nanoseconds - latency to add
+   */
+  void add(std::uint64_t p_nanoseconds);
+
+  /**
+   * @param p_fraction - fraction of recorded latencies, from 0.0f to 1.0f,
+   * such as 0.99f for the 99th percentile
+   * @return std::uint64_t - upper bound in nanoseconds of the bucket holding
+   * the requested percentile, capped at `max`. 0 if nothing was recorded.
+   */
+  [[nodiscard]] std::uint64_t percentile(float p_fraction) const;
+};
+
+/**
+ * @brief Sink that aggregates per-operation latency histograms
+ *
+ * For each operation, records the time from entry to exit, the time spent
+ * between bus_begin and bus_end and the time spent between compute_begin and
+ * compute_end, each summed over a call. Whatever remains of the total is
+ * driver overhead such as shadow register bookkeeping.
+ *
+ * Intended for hosts and for targets with memory to spare, as each operation
+ * holds three histograms.
+ *
+ * USAGE:
+ *
+ *    hal::expander::trace_histogram histogram(clock);
+ *    hal::expander::set_trace_sink(&histogram);
+ *    pwm0.duty_cycle(0.5f);
+ *    auto p99 =
+ *      histogram.total(hal::expander::trace_op::pca9685_duty_cycle)
+ *        .percentile(0.99f);
+ */
+class trace_histogram : public trace_sink
+{
+public:
+  /**
+   * @param p_clock - clock to timestamp tracepoints with. Must outlive this
+   * object.
+   */
+  explicit trace_histogram(hal::steady_clock& p_clock);
+
+  /**
+   * @param p_op - operation to query
+   * @return latency_histogram const& - latencies from entry to exit
+   */
+  [[nodiscard]] latency_histogram const& total(trace_op p_op) const;
+
+  /**
+   * @param p_op - operation to query
+   * @return latency_histogram const& - time spent on the bus per call
+   */
+  [[nodiscard]] latency_histogram const& bus(trace_op p_op) const;
+
+  /**
+   * @param p_op - operation to query
+   * @return latency_histogram const& - time spent computing register values
+   * and building transaction buffers per call
+   */
+  [[nodiscard]] latency_histogram const& compute(trace_op p_op) const;
+
+  /**
+   * @brief Clear every histogram
+   *
+   */
+  void reset();
+
+private:
+  static constexpr auto op_count = static_cast<std::size_t>(trace_op::count);
+
+  struct operation
+  {
+    latency_histogram total{};
+    latency_histogram bus{};
+    latency_histogram compute{};
+    std::uint64_t entry_time = 0;
+    std::uint64_t bus_begin_time = 0;
+    std::uint64_t bus_ticks = 0;
+    std::uint64_t compute_begin_time = 0;
+    std::uint64_t compute_ticks = 0;
+  };
+
+  void driver_record(trace_op p_op, trace_phase p_phase) override;
+  std::uint64_t nanoseconds(std::uint64_t p_ticks) const;
+
+  hal::steady_clock* m_clock;
+  std::array<operation, op_count> m_operations{};
+};
+}  // namespace hal::expander
@@ -0,0 +1,97 @@
+#include <libhal-expander/autotune.hpp>
+
+#include <array>
+
+namespace hal::expander {
+struct autotune_access
+{
+  static std::uint64_t time_pca9685(hal::steady_clock& p_clock,
+                                    pca9685& p_pca9685,
+                                    std::uint16_t p_iterations)
+  {
+    using namespace pca9685_registers;
+    // ON_L and OFF_L of channel 0 and OFF_L of channels 2 and 8. The runs of
+    // unchanged registers between them are 1, 7 and 23 bytes long, so each
+    // candidate burst gap bridges a different number of them.
+    std::array<hal::byte, 4> const workload{
+      channel_address(0),
+      static_cast<hal::byte>(channel_address(0) + 2),
+      static_cast<hal::byte>(channel_address(2) + 2),
+      static_cast<hal::byte>(channel_address(8) + 2),
+    };
+
+    auto const start = p_clock.uptime();
+    for (std::uint16_t i = 0; i < p_iterations; i++) {
+      // Rewrite the current values, which costs the same bus time as a change
+      // but leaves the outputs alone. Unknown registers are skipped.
+      for (auto const address : workload) {
+        p_pca9685.m_registers.mark_dirty(address);
+      }
+      p_pca9685.flush(trace_op::pca9685_channel_ticks);
+    }
+    return p_clock.uptime() - start;
+  }
+
+  static std::uint64_t time_tla2528(hal::steady_clock& p_clock,
+                                    tla2528& p_tla2528,
+                                    hal::byte p_channels,
+                                    std::uint16_t p_iterations)
+  {
+    std::array<std::uint16_t, 8> codes{};
+    auto const start = p_clock.uptime();
+    for (std::uint16_t i = 0; i < p_iterations; i++) {
+      p_tla2528.scan(p_channels, codes);
+    }
+    return p_clock.uptime() - start;
+  }
+};
+
+expander_policy autotune(hal::steady_clock& p_clock,
+                         pca9685* p_pca9685,
+                         tla2528* p_tla2528,
+                         autotune_settings const& p_settings)
+{
+  expander_policy policy{};
+
+  if (p_pca9685) {
+    // From bridging only the registers between a channel's edges up to
+    // rewriting whole frames. A gap of 0 is not a candidate, as bridging one or
+    // two bytes is never more bytes than starting a new transaction.
+    constexpr std::array<hal::byte, 3> burst_gaps{ 2, 8, 64 };
+    auto best = UINT64_MAX;
+    for (auto const gap : burst_gaps) {
+      p_pca9685->set_policy({ .pca9685_burst_gap = gap });
+      auto const elapsed = autotune_access::time_pca9685(
+        p_clock, *p_pca9685, p_settings.iterations);
+      if (elapsed < best) {
+        best = elapsed;
+        policy.pca9685_burst_gap = gap;
+      }
+    }
+    p_pca9685->set_policy(policy);
+  }
+
+  if (p_tla2528) {
+    constexpr std::array<tla2528_scan_mode, 2> modes{
+      tla2528_scan_mode::combined,
+      tla2528_scan_mode::split,
+    };
+    auto best = UINT64_MAX;
+    for (auto const mode : modes) {
+      p_tla2528->set_policy({ .tla2528_scan = mode });
+      auto const elapsed = autotune_access::time_tla2528(
+        p_clock,
+        *p_tla2528,
+        p_settings.tla2528_channels,
+        p_settings.iterations);
+      if (elapsed < best) {
+        best = elapsed;
+        policy.tla2528_scan = mode;
+      }
+    }
+    p_tla2528->set_policy(policy);
+  }
+
+  return policy;
+}
+}  // namespace hal::expander
@@ -0,0 +1,15 @@
+#include <libhal-expander/board.hpp>
+
+#include <libhal-util/i2c.hpp>
+
+namespace hal::expander {
+void run_init_script(hal::i2c& p_i2c, std::span<hal::byte const> p_script)
+{
+  while (p_script.size() >= 2) {
+    auto const address = p_script[0];
+    auto const length = p_script[1];
+    hal::write(p_i2c, address, p_script.subspan(2, length));
+    p_script = p_script.subspan(2 + length);
+  }
+}
+}  // namespace hal::expander
@@ -0,0 +1,521 @@
+#include <libhal-expander/bulk_conversion.hpp>
+
+#include <array>
+#include <cstddef>
+
+#include <libhal/error.hpp>
+
+#include <libhal-expander/pca9685_registers.hpp>
+#include <libhal-expander/tla2528_registers.hpp>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define LIBHAL_EXPANDER_BULK_X86 1
+#include <immintrin.h>
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#define LIBHAL_EXPANDER_BULK_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace hal::expander {
+namespace {
+// The vector kernels store each channel's 4 register bytes as one 32-bit lane
+// holding `ticks << 16`, which relies on little endian byte order. Every host
+// with a vector backend here is little endian.
+constexpr std::size_t register_bytes = 4;
+constexpr float full_scale_ticks = 4095.0f;
+constexpr float full_scale_code = tla2528_registers::full_scale_codes;
+// x / 1000 == (x * millis_multiplier) >> millis_shift for every 32-bit x
+constexpr std::uint32_t millis_multiplier = 0x10624DD3;
+constexpr int millis_shift = 38;
+
+// ---------------------------------------------------------------------------
+// Scalar
+// ---------------------------------------------------------------------------
+
+float clamp_duty_cycle(float p_duty_cycle)
+{
+  // Written to match the NaN behavior of the vector max and min instructions
+  auto const positive = p_duty_cycle > 0.0f ? p_duty_cycle : 0.0f;
+  return positive < 1.0f ? positive : 1.0f;
+}
+
+void scalar_duty_cycles(std::span<float const> p_duty_cycles,
+                        hal::byte* p_registers)
+{
+  for (auto const duty_cycle : p_duty_cycles) {
+    auto const registers = pca9685_registers::duty_cycle_registers(
+      clamp_duty_cycle(duty_cycle));
+    for (auto const value : registers) {
+      *p_registers++ = value;
+    }
+  }
+}
+
+void scalar_fractions(std::span<std::uint16_t const> p_codes, float* p_out)
+{
+  for (auto const code : p_codes) {
+    *p_out++ = static_cast<float>(code) / full_scale_code;
+  }
+}
+
+void scalar_microvolts(std::span<std::uint16_t const> p_codes,
+                       std::uint32_t p_reference,
+                       std::uint32_t* p_out)
+{
+  for (auto const code : p_codes) {
+    *p_out++ = tla2528_registers::code_to_microvolts(code, p_reference);
+  }
+}
+
+std::uint32_t microvolts_to_millivolts(std::uint32_t p_microvolts)
+{
+  return (p_microvolts + 500) / 1000;
+}
+
+void scalar_millivolts(std::span<std::uint16_t const> p_codes,
+                       std::uint32_t p_reference,
+                       std::uint32_t* p_out)
+{
+  for (auto const code : p_codes) {
+    *p_out++ = microvolts_to_millivolts(
+      tla2528_registers::code_to_microvolts(code, p_reference));
+  }
+}
+
+#if defined(LIBHAL_EXPANDER_BULK_X86)
+// ---------------------------------------------------------------------------
+// SSE2
+// ---------------------------------------------------------------------------
+
+__m128i sse2_ticks(__m128 p_duty_cycles)
+{
+  // max and min return their second operand for NaN, so NaN becomes 0
+  auto const clamped = _mm_min_ps(_mm_max_ps(p_duty_cycles, _mm_setzero_ps()),
+                                  _mm_set1_ps(1.0f));
+  auto const exact = _mm_mul_ps(clamped, _mm_set1_ps(full_scale_ticks));
+  // Round half away from zero like std::round. The values are positive, so
+  // truncation is floor, and the fraction is computed without error.
+  auto const whole = _mm_cvttps_epi32(exact);
+  auto const fraction = _mm_sub_ps(exact, _mm_cvtepi32_ps(whole));
+  auto const round_up = _mm_cmpge_ps(fraction, _mm_set1_ps(0.5f));
+  // A true comparison is all ones, which is -1
+  return _mm_sub_epi32(whole, _mm_castps_si128(round_up));
+}
+
+// (p_values * p_multiplier + p_addend) >> p_shift per 32-bit lane, computed
+// with 64-bit products and truncated to 32 bits
+__m128i sse2_scale(__m128i p_values,
+                   std::uint32_t p_multiplier,
+                   std::uint32_t p_addend,
+                   int p_shift)
+{
+  auto const multiplier = _mm_set1_epi32(static_cast<int>(p_multiplier));
+  auto const addend = _mm_set1_epi64x(p_addend);
+  auto const count = _mm_cvtsi32_si128(p_shift);
+  auto const even = _mm_srl_epi64(
+    _mm_add_epi64(_mm_mul_epu32(p_values, multiplier), addend), count);
+  auto const odd = _mm_srl_epi64(
+    _mm_add_epi64(_mm_mul_epu32(_mm_srli_epi64(p_values, 32), multiplier),
+                  addend),
+    count);
+  auto const low_mask = _mm_set1_epi64x(0xFFFF'FFFF);
+  return _mm_or_si128(_mm_and_si128(even, low_mask), _mm_slli_epi64(odd, 32));
+}
+
+__m128i sse2_load_codes(std::uint16_t const* p_codes)
+{
+  auto const codes =
+    _mm_loadl_epi64(reinterpret_cast<__m128i const*>(p_codes));
+  return _mm_unpacklo_epi16(codes, _mm_setzero_si128());
+}
+
+std::size_t sse2_duty_cycles(std::span<float const> p_duty_cycles,
+                             hal::byte* p_registers)
+{
+  std::size_t i = 0;
+  for (; i + 4 <= p_duty_cycles.size(); i += 4) {
+    auto const ticks = sse2_ticks(_mm_loadu_ps(&p_duty_cycles[i]));
+    _mm_storeu_si128(
+      reinterpret_cast<__m128i*>(p_registers + i * register_bytes),
+      _mm_slli_epi32(ticks, 16));
+  }
+  return i;
+}
+
+std::size_t sse2_fractions(std::span<std::uint16_t const> p_codes,
+                           float* p_out)
+{
+  std::size_t i = 0;
+  for (; i + 4 <= p_codes.size(); i += 4) {
+    auto const codes = _mm_cvtepi32_ps(sse2_load_codes(&p_codes[i]));
+    _mm_storeu_ps(p_out + i,
+                  _mm_div_ps(codes, _mm_set1_ps(full_scale_code)));
+  }
+  return i;
+}
+
+std::size_t sse2_volts(std::span<std::uint16_t const> p_codes,
+                       std::uint32_t p_reference,
+                       std::uint32_t* p_out,
+                       bool p_millivolts)
+{
+  using tla2528_registers::full_scale_codes;
+  constexpr int code_shift = 12;
+  static_assert(full_scale_codes == 1U << code_shift);
+
+  std::size_t i = 0;
+  for (; i + 4 <= p_codes.size(); i += 4) {
+    auto volts = sse2_scale(sse2_load_codes(&p_codes[i]),
+                            p_reference,
+                            full_scale_codes / 2,
+                            code_shift);
+    if (p_millivolts) {
+      volts = _mm_add_epi32(volts, _mm_set1_epi32(500));
+      volts = sse2_scale(volts, millis_multiplier, 0, millis_shift);
+    }
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(p_out + i), volts);
+  }
+  return i;
+}
+
+// ---------------------------------------------------------------------------
+// AVX2
+// ---------------------------------------------------------------------------
+
+#define LIBHAL_EXPANDER_AVX2 __attribute__((target("avx2")))
+
+LIBHAL_EXPANDER_AVX2 __m256i avx2_scale(__m256i p_values,
+                                        std::uint32_t p_multiplier,
+                                        std::uint32_t p_addend,
+                                        int p_shift)
+{
+  auto const multiplier = _mm256_set1_epi32(static_cast<int>(p_multiplier));
+  auto const addend = _mm256_set1_epi64x(p_addend);
+  auto const count = _mm_cvtsi32_si128(p_shift);
+  auto const even = _mm256_srl_epi64(
+    _mm256_add_epi64(_mm256_mul_epu32(p_values, multiplier), addend), count);
+  auto const odd = _mm256_srl_epi64(
+    _mm256_add_epi64(
+      _mm256_mul_epu32(_mm256_srli_epi64(p_values, 32), multiplier), addend),
+    count);
+  return _mm256_blend_epi32(even, _mm256_slli_epi64(odd, 32), 0b1010'1010);
+}
+
+LIBHAL_EXPANDER_AVX2 __m256i avx2_load_codes(std::uint16_t const* p_codes)
+{
+  return _mm256_cvtepu16_epi32(
+    _mm_loadu_si128(reinterpret_cast<__m128i const*>(p_codes)));
+}
+
+LIBHAL_EXPANDER_AVX2 std::size_t avx2_duty_cycles(
+  std::span<float const> p_duty_cycles,
+  hal::byte* p_registers)
+{
+  std::size_t i = 0;
+  for (; i + 8 <= p_duty_cycles.size(); i += 8) {
+    // Same steps as sse2_ticks()
+    auto const clamped = _mm256_min_ps(
+      _mm256_max_ps(_mm256_loadu_ps(&p_duty_cycles[i]), _mm256_setzero_ps()),
+      _mm256_set1_ps(1.0f));
+    auto const exact = _mm256_mul_ps(clamped, _mm256_set1_ps(full_scale_ticks));
+    auto const whole = _mm256_cvttps_epi32(exact);
+    auto const fraction = _mm256_sub_ps(exact, _mm256_cvtepi32_ps(whole));
+    auto const round_up =
+      _mm256_cmp_ps(fraction, _mm256_set1_ps(0.5f), _CMP_GE_OQ);
+    auto const ticks = _mm256_sub_epi32(whole, _mm256_castps_si256(round_up));
+    _mm256_storeu_si256(
+      reinterpret_cast<__m256i*>(p_registers + i * register_bytes),
+      _mm256_slli_epi32(ticks, 16));
+  }
+  return i;
+}
+
+LIBHAL_EXPANDER_AVX2 std::size_t avx2_fractions(
+  std::span<std::uint16_t const> p_codes,
+  float* p_out)
+{
+  std::size_t i = 0;
+  for (; i + 8 <= p_codes.size(); i += 8) {
+    auto const codes = _mm256_cvtepi32_ps(avx2_load_codes(&p_codes[i]));
+    _mm256_storeu_ps(p_out + i,
+                     _mm256_div_ps(codes, _mm256_set1_ps(full_scale_code)));
+  }
+  return i;
+}
+
+LIBHAL_EXPANDER_AVX2 std::size_t avx2_volts(
+  std::span<std::uint16_t const> p_codes,
+  std::uint32_t p_reference,
+  std::uint32_t* p_out,
+  bool p_millivolts)
+{
+  using tla2528_registers::full_scale_codes;
+  constexpr int code_shift = 12;
+
+  std::size_t i = 0;
+  for (; i + 8 <= p_codes.size(); i += 8) {
+    auto volts = avx2_scale(avx2_load_codes(&p_codes[i]),
+                            p_reference,
+                            full_scale_codes / 2,
+                            code_shift);
+    if (p_millivolts) {
+      volts = _mm256_add_epi32(volts, _mm256_set1_epi32(500));
+      volts = avx2_scale(volts, millis_multiplier, 0, millis_shift);
+    }
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(p_out + i), volts);
+  }
+  return i;
+}
+
+#undef LIBHAL_EXPANDER_AVX2
+
+bool avx2_supported()
+{
+  static bool const supported = __builtin_cpu_supports("avx2");
+  return supported;
+}
+#endif
+
+#if defined(LIBHAL_EXPANDER_BULK_NEON)
+// ---------------------------------------------------------------------------
+// NEON
+// ---------------------------------------------------------------------------
+
+// (p_values * p_multiplier + p_addend) >> p_shift per 32-bit lane, computed
+// with 64-bit products and truncated to 32 bits
+uint32x4_t neon_scale(uint32x4_t p_values,
+                      std::uint32_t p_multiplier,
+                      std::uint32_t p_addend,
+                      int p_shift)
+{
+  auto const multiplier = vdup_n_u32(p_multiplier);
+  auto const addend = vdupq_n_u64(p_addend);
+  auto const count = vdupq_n_s64(-p_shift);
+  auto const low = vshlq_u64(
+    vaddq_u64(vmull_u32(vget_low_u32(p_values), multiplier), addend), count);
+  auto const high = vshlq_u64(
+    vaddq_u64(vmull_u32(vget_high_u32(p_values), multiplier), addend), count);
+  return vcombine_u32(vmovn_u64(low), vmovn_u64(high));
+}
+
+std::size_t neon_duty_cycles(std::span<float const> p_duty_cycles,
+                             hal::byte* p_registers)
+{
+  std::size_t i = 0;
+  for (; i + 4 <= p_duty_cycles.size(); i += 4) {
+    auto const duty_cycles = vld1q_f32(&p_duty_cycles[i]);
+    // NaN compares false, so it takes the second operand just like the SSE
+    // max and min instructions
+    auto const zero = vdupq_n_f32(0.0f);
+    auto const one = vdupq_n_f32(1.0f);
+    auto const positive =
+      vbslq_f32(vcgtq_f32(duty_cycles, zero), duty_cycles, zero);
+    auto const clamped = vbslq_f32(vcltq_f32(positive, one), positive, one);
+    auto const exact = vmulq_f32(clamped, vdupq_n_f32(full_scale_ticks));
+    auto const whole = vcvtq_u32_f32(exact);
+    auto const fraction = vsubq_f32(exact, vcvtq_f32_u32(whole));
+    // A true comparison is all ones, which is -1
+    auto const round_up = vcgeq_f32(fraction, vdupq_n_f32(0.5f));
+    auto const ticks = vsubq_u32(whole, round_up);
+    vst1q_u8(p_registers + i * register_bytes,
+             vreinterpretq_u8_u32(vshlq_n_u32(ticks, 16)));
+  }
+  return i;
+}
+
+std::size_t neon_fractions(std::span<std::uint16_t const> p_codes,
+                           float* p_out)
+{
+  std::size_t i = 0;
+  for (; i + 4 <= p_codes.size(); i += 4) {
+    auto const codes = vcvtq_f32_u32(vmovl_u16(vld1_u16(&p_codes[i])));
+    vst1q_f32(p_out + i, vdivq_f32(codes, vdupq_n_f32(full_scale_code)));
+  }
+  return i;
+}
+
+std::size_t neon_volts(std::span<std::uint16_t const> p_codes,
+                       std::uint32_t p_reference,
+                       std::uint32_t* p_out,
+                       bool p_millivolts)
+{
+  using tla2528_registers::full_scale_codes;
+  constexpr int code_shift = 12;
+
+  std::size_t i = 0;
+  for (; i + 4 <= p_codes.size(); i += 4) {
+    auto volts = neon_scale(vmovl_u16(vld1_u16(&p_codes[i])),
+                            p_reference,
+                            full_scale_codes / 2,
+                            code_shift);
+    if (p_millivolts) {
+      volts = vaddq_u32(volts, vdupq_n_u32(500));
+      volts = neon_scale(volts, millis_multiplier, 0, millis_shift);
+    }
+    vst1q_u32(p_out + i, volts);
+  }
+  return i;
+}
+#endif
+
+// ---------------------------------------------------------------------------
+// Dispatch
+// ---------------------------------------------------------------------------
+
+bulk_backend resolve(bulk_backend p_backend)
+{
+  if (p_backend == bulk_backend::automatic) {
+#if defined(LIBHAL_EXPANDER_BULK_X86)
+    return avx2_supported() ? bulk_backend::avx2 : bulk_backend::sse2;
+#elif defined(LIBHAL_EXPANDER_BULK_NEON)
+    return bulk_backend::neon;
+#else
+    return bulk_backend::scalar;
+#endif
+  }
+  if (!bulk_backend_supported(p_backend)) {
+    throw hal::operation_not_supported(nullptr);
+  }
+  return p_backend;
+}
+
+void check_output(std::size_t p_input, std::size_t p_output)
+{
+  if (p_output < p_input) {
+    throw hal::argument_out_of_domain(nullptr);
+  }
+}
+
+/// Number of leading values converted by the vector backend. The caller
+/// converts the rest with the scalar kernel.
+std::size_t vector_duty_cycles([[maybe_unused]] bulk_backend p_backend,
+                               std::span<float const> p_duty_cycles,
+                               hal::byte* p_registers)
+{
+  switch (p_backend) {
+#if defined(LIBHAL_EXPANDER_BULK_X86)
+    case bulk_backend::sse2:
+      return sse2_duty_cycles(p_duty_cycles, p_registers);
+    case bulk_backend::avx2:
+      return avx2_duty_cycles(p_duty_cycles, p_registers);
+#elif defined(LIBHAL_EXPANDER_BULK_NEON)
+    case bulk_backend::neon:
+      return neon_duty_cycles(p_duty_cycles, p_registers);
+#endif
+    default:
+      return 0;
+  }
+}
+
+std::size_t vector_fractions([[maybe_unused]] bulk_backend p_backend,
+                             std::span<std::uint16_t const> p_codes,
+                             float* p_out)
+{
+  switch (p_backend) {
+#if defined(LIBHAL_EXPANDER_BULK_X86)
+    case bulk_backend::sse2:
+      return sse2_fractions(p_codes, p_out);
+    case bulk_backend::avx2:
+      return avx2_fractions(p_codes, p_out);
+#elif defined(LIBHAL_EXPANDER_BULK_NEON)
+    case bulk_backend::neon:
+      return neon_fractions(p_codes, p_out);
+#endif
+    default:
+      return 0;
+  }
+}
+
+std::size_t vector_volts([[maybe_unused]] bulk_backend p_backend,
+                         std::span<std::uint16_t const> p_codes,
+                         std::uint32_t p_reference,
+                         std::uint32_t* p_out,
+                         bool p_millivolts)
+{
+  switch (p_backend) {
+#if defined(LIBHAL_EXPANDER_BULK_X86)
+    case bulk_backend::sse2:
+      return sse2_volts(p_codes, p_reference, p_out, p_millivolts);
+    case bulk_backend::avx2:
+      return avx2_volts(p_codes, p_reference, p_out, p_millivolts);
+#elif defined(LIBHAL_EXPANDER_BULK_NEON)
+    case bulk_backend::neon:
+      return neon_volts(p_codes, p_reference, p_out, p_millivolts);
+#endif
+    default:
+      return 0;
+  }
+}
+}  // namespace
+
+bool bulk_backend_supported(bulk_backend p_backend)
+{
+  switch (p_backend) {
+    case bulk_backend::automatic:
+    case bulk_backend::scalar:
+      return true;
+#if defined(LIBHAL_EXPANDER_BULK_X86)
+    case bulk_backend::sse2:
+      return true;
+    case bulk_backend::avx2:
+      return avx2_supported();
+#elif defined(LIBHAL_EXPANDER_BULK_NEON)
+    case bulk_backend::neon:
+      return true;
+#endif
+    default:
+      return false;
+  }
+}
+
+void duty_cycles_to_registers(std::span<float const> p_duty_cycles,
+                              std::span<hal::byte> p_registers,
+                              bulk_backend p_backend)
+{
+  check_output(p_duty_cycles.size() * register_bytes, p_registers.size());
+  auto const done = vector_duty_cycles(
+    resolve(p_backend), p_duty_cycles, p_registers.data());
+  scalar_duty_cycles(p_duty_cycles.subspan(done),
+                     p_registers.data() + done * register_bytes);
+}
+
+void codes_to_fractions(std::span<std::uint16_t const> p_codes,
+                        std::span<float> p_fractions,
+                        bulk_backend p_backend)
+{
+  check_output(p_codes.size(), p_fractions.size());
+  auto const done =
+    vector_fractions(resolve(p_backend), p_codes, p_fractions.data());
+  scalar_fractions(p_codes.subspan(done), p_fractions.data() + done);
+}
+
+void codes_to_microvolts(std::span<std::uint16_t const> p_codes,
+                         std::uint32_t p_reference_microvolts,
+                         std::span<std::uint32_t> p_microvolts,
+                         bulk_backend p_backend)
+{
+  check_output(p_codes.size(), p_microvolts.size());
+  auto const done = vector_volts(resolve(p_backend),
+                                 p_codes,
+                                 p_reference_microvolts,
+                                 p_microvolts.data(),
+                                 false);
+  scalar_microvolts(
+    p_codes.subspan(done), p_reference_microvolts, p_microvolts.data() + done);
+}
+
+void codes_to_millivolts(std::span<std::uint16_t const> p_codes,
+                         std::uint32_t p_reference_microvolts,
+                         std::span<std::uint32_t> p_millivolts,
+                         bulk_backend p_backend)
+{
+  check_output(p_codes.size(), p_millivolts.size());
+  auto const done = vector_volts(resolve(p_backend),
+                                 p_codes,
+                                 p_reference_microvolts,
+                                 p_millivolts.data(),
+                                 true);
+  scalar_millivolts(
+    p_codes.subspan(done), p_reference_microvolts, p_millivolts.data() + done);
+}
+}  // namespace hal::expander
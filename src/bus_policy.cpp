@@ -0,0 +1,82 @@
+#include <libhal-expander/bus_policy.hpp>
+
+#include <algorithm>
+
+#include <libhal-util/steady_clock.hpp>
+#include <libhal/error.hpp>
+
+#include <libhal-expander/tracepoint.hpp>
+
+namespace hal::expander {
+bus_guard::bus_guard(hal::steady_clock& p_clock, bus_policy const& p_policy)
+  : m_clock(&p_clock)
+  , m_policy(p_policy)
+{
+}
+
+void bus_guard::record_latency(std::uint64_t p_start)
+{
+  m_max_observed_ticks =
+    std::max(m_max_observed_ticks, m_clock->uptime() - p_start);
+}
+
+bool bus_guard::out_of_retries(std::uint32_t p_attempt, std::uint64_t p_start)
+{
+  if (p_attempt < m_policy.retries) {
+    return false;
+  }
+  record_latency(p_start);
+  m_failure_count++;
+  return true;
+}
+
+void bus_guard::back_off(std::uint32_t p_attempt)
+{
+  m_retry_count++;
+  hal::delay(*m_clock, m_policy.backoff_delay(p_attempt));
+}
+
+bus_policy const& bus_guard::policy() const
+{
+  return m_policy;
+}
+
+bool bus_guard::bounded() const
+{
+  return m_clock != nullptr;
+}
+
+hal::time_duration bus_guard::worst_case_latency() const
+{
+  if (m_clock == nullptr) {
+    return hal::time_duration::max();
+  }
+  return m_policy.worst_case_latency();
+}
+
+hal::time_duration bus_guard::max_observed_latency() const
+{
+  if (m_clock == nullptr) {
+    return hal::time_duration::zero();
+  }
+  return hal::time_duration(static_cast<hal::time_duration::rep>(
+    ticks_to_nanoseconds(m_max_observed_ticks, m_clock->frequency())));
+}
+
+std::uint32_t bus_guard::retry_count() const
+{
+  return m_retry_count;
+}
+
+std::uint32_t bus_guard::failure_count() const
+{
+  return m_failure_count;
+}
+
+void bus_guard::reset_statistics()
+{
+  m_max_observed_ticks = 0;
+  m_retry_count = 0;
+  m_failure_count = 0;
+}
+}  // namespace hal::expander
@@ -0,0 +1,45 @@
+#include <libhal-expander/bus_session.hpp>
+
+#include <utility>
+
+namespace hal::expander {
+bus_session::bus_session(i2c_sequencer* p_sequencer,
+                         hal::callback<void()> p_on_failure)
+  : m_sequencer(p_sequencer)
+  , m_on_failure(std::move(p_on_failure))
+{
+  if (m_sequencer) {
+    m_sequencer->begin_sequence();
+  }
+}
+
+bus_session::~bus_session()
+{
+  try {
+    commit();
+  } catch (...) {
+    // Errors can only be reported through commit(), and a destructor that
+    // throws during stack unwinding would terminate the program.
+  }
+}
+
+void bus_session::commit()
+{
+  // Cleared first so that a sequence that fails to send is not ended again
+  if (auto* sequencer = std::exchange(m_sequencer, nullptr)) {
+    try {
+      sequencer->end_sequence();
+    } catch (...) {
+      if (m_on_failure) {
+        m_on_failure();
+      }
+      throw;
+    }
+  }
+}
+
+bool bus_session::chained() const
+{
+  return m_sequencer != nullptr;
+}
+}  // namespace hal::expander
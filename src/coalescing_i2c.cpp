@@ -0,0 +1,121 @@
+#include <libhal-expander/coalescing_i2c.hpp>
+
+#include <algorithm>
+
+#include <libhal-util/i2c.hpp>
+
+namespace hal::expander {
+coalescing_i2c::coalescing_i2c(
+  hal::i2c& p_i2c,
+  std::span<hal::byte> p_buffer,
+  std::span<hal::byte const> p_auto_increment_devices)
+  : m_i2c(&p_i2c)
+  , m_buffer(p_buffer)
+  , m_auto_increment_devices(p_auto_increment_devices)
+{
+}
+
+void coalescing_i2c::begin_batch()
+{
+  m_depth++;
+}
+
+void coalescing_i2c::end_batch(
+  hal::function_ref<hal::timeout_function> p_timeout)
+{
+  if (m_depth == 0) {
+    return;
+  }
+  m_depth--;
+  if (m_depth == 0) {
+    flush(p_timeout);
+  }
+}
+
+void coalescing_i2c::flush(hal::function_ref<hal::timeout_function> p_timeout)
+{
+  if (m_pending == 0) {
+    return;
+  }
+  auto const burst = m_buffer.first(m_pending);
+  // Drop the held burst before sending it so a failed write is reported once
+  // rather than replayed by every following call.
+  m_pending = 0;
+  hal::write(*m_i2c, m_pending_device, burst, p_timeout);
+}
+
+bool coalescing_i2c::batching() const
+{
+  return m_depth > 0;
+}
+
+std::size_t coalescing_i2c::pending() const
+{
+  return m_pending;
+}
+
+void coalescing_i2c::driver_configure(settings const& p_settings)
+{
+  flush();
+  m_i2c->configure(p_settings);
+}
+
+bool coalescing_i2c::auto_increments(hal::byte p_address) const
+{
+  return std::ranges::find(m_auto_increment_devices, p_address) !=
+         m_auto_increment_devices.end();
+}
+
+bool coalescing_i2c::try_append(hal::byte p_address,
+                                std::span<hal::byte const> p_data_out)
+{
+  if (m_pending == 0 || p_address != m_pending_device) {
+    return false;
+  }
+
+  // The held burst's register address plus the number of data bytes held is
+  // the register the device will write next.
+  auto const next_register = m_buffer[0] + (m_pending - 1);
+  auto const data = p_data_out.subspan(1);
+  bool const contiguous = p_data_out[0] == next_register;
+  bool const fits = m_pending + data.size() <= m_buffer.size();
+  if (!contiguous || !fits) {
+    return false;
+  }
+
+  std::ranges::copy(data, m_buffer.begin() + m_pending);
+  m_pending += data.size();
+  return true;
+}
+
+void coalescing_i2c::driver_transaction(
+  hal::byte p_address,
+  std::span<hal::byte const> p_data_out,
+  std::span<hal::byte> p_data_in,
+  hal::function_ref<hal::timeout_function> p_timeout)
+{
+  bool const mergeable = batching() && p_data_in.empty() &&
+                         p_data_out.size() >= 2 && auto_increments(p_address);
+
+  if (!mergeable) {
+    flush(p_timeout);
+    m_i2c->transaction(p_address, p_data_out, p_data_in, p_timeout);
+    return;
+  }
+
+  if (try_append(p_address, p_data_out)) {
+    return;
+  }
+
+  flush(p_timeout);
+
+  if (p_data_out.size() > m_buffer.size()) {
+    m_i2c->transaction(p_address, p_data_out, p_data_in, p_timeout);
+    return;
+  }
+
+  std::ranges::copy(p_data_out, m_buffer.begin());
+  m_pending = p_data_out.size();
+  m_pending_device = p_address;
+}
+}  // namespace hal::expander
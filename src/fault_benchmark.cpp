@@ -0,0 +1,64 @@
+#include <libhal-expander/fault_benchmark.hpp>
+
+#include <array>
+
+#include <libhal-expander/pca9685.hpp>
+#include <libhal-expander/tla2528.hpp>
+
+namespace hal::expander {
+fault_benchmark_report benchmark_under_faults(
+  fault_benchmark_settings const& p_settings)
+{
+  constexpr hal::byte pca9685_address = 0b100'0000;
+  constexpr std::size_t fault_kinds = 5;
+
+  simulated_clock clock;
+  simulated_i2c bus(clock);
+  simulated_pca9685 pwm_device;
+  simulated_tla2528 adc_device;
+  bus.attach(pca9685_address, pwm_device);
+  bus.attach(tla2528::default_address, adc_device);
+  for (hal::byte pin = 0; pin < 8; pin++) {
+    adc_device.set_analog_input(pin, static_cast<std::uint16_t>(pin * 512));
+  }
+
+  fault_injector i2c(bus, clock, p_settings.seed);
+  pca9685 pwm(i2c, pca9685_address);
+  tla2528 adc(i2c);
+  for (hal::byte pin = 0; pin < 8; pin++) {
+    adc.set_pin_mode(tla2528::pin_mode::adc, pin);
+  }
+  pwm.set_bus_policy(clock, p_settings.policy);
+  adc.set_bus_policy(clock, p_settings.policy);
+  i2c.randomize(p_settings.faults);
+
+  fault_benchmark_report report{};
+  // Each run alternates between two values, so every run writes
+  std::uint32_t run = 0;
+
+  report.pca9685_duty_cycle =
+    measure_latency(clock, p_settings.iterations, [&]() {
+      pwm.duty_cycle(0, run++ % 2 == 0 ? 0.25f : 0.75f);
+    });
+
+  std::array<std::uint16_t, pca9685::max_channel_count> ticks{};
+  report.pca9685_channel_ticks =
+    measure_latency(clock, p_settings.iterations, [&]() {
+      ticks.fill(run++ % 2 == 0 ? 1024 : 3072);
+      pwm.set_channel_ticks(ticks);
+    });
+
+  report.tla2528_adc_reading = measure_latency(
+    clock, p_settings.iterations, [&]() { (void)adc.get_adc_reading(0); });
+
+  std::array<std::uint16_t, 8> codes{};
+  report.tla2528_scan = measure_latency(
+    clock, p_settings.iterations, [&]() { adc.scan(0xFF, codes); });
+
+  report.retries = pwm.bus().retry_count() + adc.bus().retry_count();
+  for (std::size_t kind = 0; kind < fault_kinds; kind++) {
+    report.injected[kind] = i2c.injected(static_cast<i2c_fault>(kind));
+  }
+  return report;
+}
+}  // namespace hal::expander
@@ -0,0 +1,130 @@
+#include <libhal-expander/fault_injector.hpp>
+
+#include <libhal/error.hpp>
+
+namespace hal::expander {
+fault_injector::fault_injector(hal::i2c& p_bus,
+                               simulated_clock& p_clock,
+                               std::uint32_t p_seed)
+  : m_bus(&p_bus)
+  , m_clock(&p_clock)
+  , m_state(p_seed == 0 ? 1 : p_seed)
+{
+}
+
+void fault_injector::randomize(fault_rates const& p_rates)
+{
+  m_rates = p_rates;
+}
+
+void fault_injector::script(std::span<fault const> p_faults)
+{
+  m_script.assign(p_faults.begin(), p_faults.end());
+  m_script_position = 0;
+}
+
+void fault_injector::clear()
+{
+  m_rates = {};
+  m_script.clear();
+  m_script_position = 0;
+  m_injected = {};
+  m_transaction_count = 0;
+}
+
+std::uint32_t fault_injector::injected(i2c_fault p_kind) const
+{
+  return m_injected[static_cast<std::size_t>(p_kind)];
+}
+
+std::uint32_t fault_injector::transaction_count() const
+{
+  return m_transaction_count;
+}
+
+void fault_injector::driver_configure(settings const& p_settings)
+{
+  m_bus->configure(p_settings);
+}
+
+void fault_injector::driver_transaction(
+  hal::byte p_address,
+  std::span<hal::byte const> p_data_out,
+  std::span<hal::byte> p_data_in,
+  hal::function_ref<hal::timeout_function> p_timeout)
+{
+  m_transaction_count++;
+  auto const injecting = next_fault();
+  m_injected[static_cast<std::size_t>(injecting.kind)]++;
+
+  switch (injecting.kind) {
+    case i2c_fault::nack:
+      throw hal::no_such_device(p_address, this);
+    case i2c_fault::arbitration_lost:
+      throw hal::resource_unavailable_try_again(this);
+    case i2c_fault::stretch: {
+      auto const release = m_clock->now() + injecting.stretch;
+      while (m_clock->now() < release) {
+        p_timeout();
+        m_clock->advance(hal::time_duration(1'000));
+      }
+      break;
+    }
+    default:
+      break;
+  }
+
+  m_bus->transaction(p_address, p_data_out, p_data_in, p_timeout);
+
+  if (injecting.kind == i2c_fault::corrupt_read && !p_data_in.empty()) {
+    auto const bit = random() % (p_data_in.size() * 8);
+    p_data_in[bit / 8] ^= static_cast<hal::byte>(1U << (bit % 8));
+  }
+}
+
+fault fault_injector::next_fault()
+{
+  if (m_script_position < m_script.size()) {
+    return m_script[m_script_position++];
+  }
+
+  auto const roll = random_fraction();
+  auto threshold = m_rates.nack;
+  if (roll < threshold) {
+    return { .kind = i2c_fault::nack };
+  }
+  threshold += m_rates.arbitration_lost;
+  if (roll < threshold) {
+    return { .kind = i2c_fault::arbitration_lost };
+  }
+  threshold += m_rates.stretch;
+  if (roll < threshold) {
+    auto const max_stretch = static_cast<float>(m_rates.max_stretch.count());
+    return {
+      .kind = i2c_fault::stretch,
+      .stretch = hal::time_duration(static_cast<hal::time_duration::rep>(
+        random_fraction() * max_stretch)),
+    };
+  }
+  threshold += m_rates.corrupt_read;
+  if (roll < threshold) {
+    return { .kind = i2c_fault::corrupt_read };
+  }
+  return {};
+}
+
+std::uint32_t fault_injector::random()
+{
+  // xorshift32, small and reproducible across standard libraries
+  m_state ^= m_state << 13;
+  m_state ^= m_state >> 17;
+  m_state ^= m_state << 5;
+  return m_state;
+}
+
+float fault_injector::random_fraction()
+{
+  // 24 random bits fit exactly in a float's mantissa
+  return static_cast<float>(random() >> 8) / 16'777'216.0f;
+}
+}  // namespace hal::expander
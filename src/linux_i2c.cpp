@@ -0,0 +1,270 @@
+#include <libhal-expander/linux_i2c.hpp>
+
+#include <algorithm>
+#include <cerrno>
+#include <utility>
+
+#include <libhal/error.hpp>
+
+#if defined(__linux__)
+#include <fcntl.h>
+#include <linux/i2c-dev.h>
+#include <linux/i2c.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+#endif
+
+namespace hal::expander {
+#if defined(__linux__)
+linux_i2c_dev_file::linux_i2c_dev_file(char const* p_path)
+  : m_file_descriptor(::open(p_path, O_RDWR | O_CLOEXEC))
+{
+  if (m_file_descriptor < 0) {
+    throw hal::no_such_device(0, this);
+  }
+}
+
+linux_i2c_dev_file::linux_i2c_dev_file(linux_i2c_dev_file&& p_other) noexcept
+  : m_file_descriptor(std::exchange(p_other.m_file_descriptor, -1))
+{
+}
+
+linux_i2c_dev_file& linux_i2c_dev_file::operator=(
+  linux_i2c_dev_file&& p_other) noexcept
+{
+  if (this != &p_other) {
+    if (m_file_descriptor >= 0) {
+      ::close(m_file_descriptor);
+    }
+    m_file_descriptor = std::exchange(p_other.m_file_descriptor, -1);
+  }
+  return *this;
+}
+
+linux_i2c_dev_file::~linux_i2c_dev_file()
+{
+  if (m_file_descriptor >= 0) {
+    ::close(m_file_descriptor);
+  }
+}
+
+int linux_i2c_dev_file::driver_rdwr(
+  std::span<i2c_dev_message const> p_messages)
+{
+  std::array<i2c_msg, linux_i2c::max_messages> messages{};
+  auto const count = std::min(p_messages.size(), messages.size());
+
+  for (std::size_t i = 0; i < count; i++) {
+    messages[i].addr = p_messages[i].address;
+    messages[i].flags = p_messages[i].read ? I2C_M_RD : 0;
+    messages[i].len = static_cast<__u16>(p_messages[i].data.size());
+    messages[i].buf = p_messages[i].data.data();
+  }
+
+  i2c_rdwr_ioctl_data request{
+    .msgs = messages.data(),
+    .nmsgs = static_cast<__u32>(count),
+  };
+
+  if (::ioctl(m_file_descriptor, I2C_RDWR, &request) < 0) {
+    return errno;
+  }
+  return 0;
+}
+#endif
+
+linux_i2c::linux_i2c(i2c_dev_file& p_file, std::span<hal::byte> p_batch_buffer)
+  : m_file(&p_file)
+  , m_batch_buffer(p_batch_buffer)
+{
+}
+
+void linux_i2c::begin_batch()
+{
+  m_depth++;
+}
+
+void linux_i2c::end_batch()
+{
+  if (m_depth == 0) {
+    return;
+  }
+  m_depth--;
+  if (m_depth == 0) {
+    submit();
+  }
+}
+
+void linux_i2c::queue_read(hal::byte p_address,
+                           std::span<hal::byte const> p_data_out,
+                           std::span<hal::byte> p_data_in)
+{
+  reserve(p_data_out.empty() ? 1 : 2, 0);
+  if (!p_data_out.empty()) {
+    append_write(p_address, p_data_out);
+  }
+  append_read(p_address, p_data_in);
+}
+
+void linux_i2c::submit()
+{
+  if (m_message_count == 0) {
+    return;
+  }
+
+  auto const messages = std::span(m_messages).first(m_message_count);
+  auto const error = m_file->rdwr(messages);
+
+  m_message_count = 0;
+  m_buffer_used = 0;
+  m_syscall_count++;
+
+  if (error != 0) {
+    throw_on_error(error, messages);
+  }
+}
+
+std::size_t linux_i2c::queued() const
+{
+  return m_message_count;
+}
+
+std::uint32_t linux_i2c::syscall_count() const
+{
+  return m_syscall_count;
+}
+
+void linux_i2c::driver_configure(settings const&)
+{
+  // The bus clock rate of an i2c-dev adapter is fixed by the kernel driver and
+  // device tree and cannot be changed from user space.
+}
+
+void linux_i2c::driver_transaction(
+  hal::byte p_address,
+  std::span<hal::byte const> p_data_out,
+  std::span<hal::byte> p_data_in,
+  hal::function_ref<hal::timeout_function> p_timeout)
+{
+  p_timeout();
+
+  bool const queue_write = m_depth > 0 && p_data_in.empty() &&
+                           !p_data_out.empty() &&
+                           p_data_out.size() <= m_batch_buffer.size();
+
+  if (queue_write) {
+    reserve(1, p_data_out.size());
+    auto const copy = m_batch_buffer.subspan(m_buffer_used, p_data_out.size());
+    std::ranges::copy(p_data_out, copy.begin());
+    m_buffer_used += copy.size();
+    append_write(p_address, copy);
+    return;
+  }
+
+  // The caller's buffers can be referenced directly as the queue is submitted
+  // before this function returns.
+  bool const has_write = !p_data_out.empty() || p_data_in.empty();
+  reserve(std::size_t{ has_write } + std::size_t{ !p_data_in.empty() }, 0);
+  if (has_write) {
+    append_write(p_address, p_data_out);
+  }
+  if (!p_data_in.empty()) {
+    append_read(p_address, p_data_in);
+  }
+  submit();
+}
+
+void linux_i2c::driver_begin_sequence()
+{
+  begin_batch();
+}
+
+void linux_i2c::driver_end_sequence()
+{
+  end_batch();
+}
+
+void linux_i2c::append_write(hal::byte p_address,
+                             std::span<hal::byte const> p_data_out)
+{
+  // i2c_msg has a single non-const buffer pointer for both directions. The
+  // kernel never writes into the buffer of a write message.
+  m_messages[m_message_count++] = {
+    .address = p_address,
+    .read = false,
+    .data = { const_cast<hal::byte*>(p_data_out.data()), p_data_out.size() },
+  };
+}
+
+void linux_i2c::append_read(hal::byte p_address,
+                            std::span<hal::byte> p_data_in)
+{
+  m_messages[m_message_count++] = {
+    .address = p_address,
+    .read = true,
+    .data = p_data_in,
+  };
+}
+
+void linux_i2c::reserve(std::size_t p_messages, std::size_t p_bytes)
+{
+  bool const messages_full = m_message_count + p_messages > max_messages;
+  bool const buffer_full = m_buffer_used + p_bytes > m_batch_buffer.size();
+  if (messages_full || buffer_full) {
+    submit();
+  }
+}
+
+hal::byte linux_i2c::unresponsive_address(
+  std::span<i2c_dev_message const> p_messages)
+{
+  auto const first = p_messages[0].address;
+  auto const same_device = [first](i2c_dev_message const& p_message) {
+    return p_message.address == first;
+  };
+  if (std::ranges::all_of(p_messages, same_device)) {
+    return first;
+  }
+
+  // The kernel does not report which message of a combined transaction was
+  // not acknowledged, so each device is probed in bus order with a zero
+  // length write, the same probe `i2cdetect -q` uses.
+  for (std::size_t i = 0; i < p_messages.size(); i++) {
+    auto const address = p_messages[i].address;
+    auto const probed = std::ranges::any_of(
+      p_messages.first(i),
+      [address](i2c_dev_message const& p_message) {
+        return p_message.address == address;
+      });
+    if (probed) {
+      continue;
+    }
+    std::array<i2c_dev_message, 1> const probe{ {
+      { .address = address, .read = false, .data = {} },
+    } };
+    m_syscall_count++;
+    if (m_file->rdwr(probe) != 0) {
+      return address;
+    }
+  }
+  return first;
+}
+
+void linux_i2c::throw_on_error(int p_error,
+                               std::span<i2c_dev_message const> p_messages)
+{
+  switch (p_error) {
+    case ENXIO:
+#if defined(EREMOTEIO)
+    case EREMOTEIO:
+#endif
+      throw hal::no_such_device(unresponsive_address(p_messages), this);
+    case ETIMEDOUT:
+      throw hal::timed_out(this);
+    case EAGAIN:
+      throw hal::resource_unavailable_try_again(this);
+    default:
+      throw hal::io_error(this);
+  }
+}
+}  // namespace hal::expander
@@ -0,0 +1,161 @@
+#include <libhal-expander/multi_bus_engine.hpp>
+
+#if defined(__linux__)
+
+#include <chrono>
+#include <utility>
+
+#include <pthread.h>
+#include <sched.h>
+
+#include <libhal/error.hpp>
+
+namespace hal::expander {
+multi_bus_engine::~multi_bus_engine()
+{
+  stop();
+}
+
+void multi_bus_engine::configure_bus(hal::i2c& p_bus,
+                                     worker_settings const& p_settings)
+{
+  if (m_running) {
+    throw hal::operation_not_permitted(this);
+  }
+  if (p_settings.cpu >= CPU_SETSIZE) {
+    throw hal::argument_out_of_domain(this);
+  }
+  find_or_add(p_bus).settings = p_settings;
+}
+
+void multi_bus_engine::add_job(hal::i2c& p_bus, hal::callback<void()> p_job)
+{
+  if (m_running) {
+    throw hal::operation_not_permitted(this);
+  }
+  find_or_add(p_bus).jobs.push_back(std::move(p_job));
+}
+
+void multi_bus_engine::start()
+{
+  if (m_running) {
+    return;
+  }
+
+  for (auto& worker : m_workers) {
+    // A bus without jobs has nothing to run, and jobs cannot be added while
+    // running.
+    if (worker->jobs.empty()) {
+      continue;
+    }
+    worker->thread = std::jthread(
+      [&self = *worker](std::stop_token p_stop) { run(p_stop, self); });
+  }
+  m_running = true;
+}
+
+void multi_bus_engine::stop()
+{
+  for (auto& worker : m_workers) {
+    worker->thread.request_stop();
+  }
+  for (auto& worker : m_workers) {
+    if (worker->thread.joinable()) {
+      worker->thread.join();
+    }
+  }
+  m_running = false;
+}
+
+bool multi_bus_engine::running() const
+{
+  return m_running;
+}
+
+std::size_t multi_bus_engine::bus_count() const
+{
+  return m_workers.size();
+}
+
+std::uint64_t multi_bus_engine::cycles(hal::i2c const& p_bus) const
+{
+  auto const* worker = find(p_bus);
+  return worker ? worker->cycles.load(std::memory_order_relaxed) : 0;
+}
+
+std::uint64_t multi_bus_engine::errors(hal::i2c const& p_bus) const
+{
+  auto const* worker = find(p_bus);
+  return worker ? worker->errors.load(std::memory_order_relaxed) : 0;
+}
+
+multi_bus_engine::bus_worker& multi_bus_engine::find_or_add(hal::i2c& p_bus)
+{
+  for (auto& worker : m_workers) {
+    if (worker->bus == &p_bus) {
+      return *worker;
+    }
+  }
+  auto& added = m_workers.emplace_back(std::make_unique<bus_worker>());
+  added->bus = &p_bus;
+  return *added;
+}
+
+multi_bus_engine::bus_worker const* multi_bus_engine::find(
+  hal::i2c const& p_bus) const
+{
+  for (auto const& worker : m_workers) {
+    if (worker->bus == &p_bus) {
+      return worker.get();
+    }
+  }
+  return nullptr;
+}
+
+void multi_bus_engine::run(std::stop_token p_stop, bus_worker& p_worker)
+{
+  if (p_worker.settings.cpu >= 0) {
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    CPU_SET(p_worker.settings.cpu, &cpus);
+    // The worker pins itself so that no job runs before it is pinned.
+    // Pinning is a throughput optimization, so a worker that cannot be pinned
+    // still runs unpinned.
+    pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+  }
+
+  using clock = std::chrono::steady_clock;
+  auto next_cycle = clock::now();
+
+  while (!p_stop.stop_requested()) {
+    for (auto& job : p_worker.jobs) {
+      if (p_stop.stop_requested()) {
+        return;
+      }
+      try {
+        job();
+      } catch (...) {
+        p_worker.errors.fetch_add(1, std::memory_order_relaxed);
+      }
+    }
+    p_worker.cycles.fetch_add(1, std::memory_order_relaxed);
+
+    if (p_worker.settings.period > hal::time_duration::zero()) {
+      auto const period = p_worker.settings.period;
+      auto const now = clock::now();
+      next_cycle += period;
+      // After an overrun, the schedule restarts from now rather than running
+      // the missed cycles back to back.
+      if (next_cycle < now) {
+        next_cycle = now + period;
+      }
+      std::unique_lock lock(p_worker.sleep_lock);
+      p_worker.wake.wait_until(lock, p_stop, next_cycle, []() {
+        return false;
+      });
+    }
+  }
+}
+}  // namespace hal::expander
+
+#endif
@@ -0,0 +1,82 @@
+#include <libhal-expander/pca9685_color_group.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+#include <libhal/error.hpp>
+
+namespace hal::expander {
+gamma_table make_gamma_table(float p_gamma)
+{
+  gamma_table table{};
+  for (std::size_t i = 0; i < table.size(); i++) {
+    auto const normalized = static_cast<float>(i) / 255.0f;
+    table[i] = static_cast<std::uint16_t>(
+      std::round(std::pow(normalized, p_gamma) * 4095.0f));
+  }
+  return table;
+}
+
+pca9685_color_group::pca9685_color_group(pca9685& p_pca9685,
+                                         hal::byte p_first_channel,
+                                         hal::byte p_channel_count,
+                                         settings const& p_settings)
+  : m_pca9685(&p_pca9685)
+  , m_first_channel(p_first_channel)
+  , m_channel_count(p_channel_count)
+  , m_settings(p_settings)
+{
+  bool const valid_count = p_channel_count == 3 || p_channel_count == 4;
+  if (!valid_count ||
+      p_first_channel + p_channel_count > pca9685::max_channel_count) {
+    hal::safe_throw(hal::argument_out_of_domain(this));
+  }
+}
+
+void pca9685_color_group::set(rgb_color const& p_color)
+{
+  std::array<std::uint8_t, 4> components{
+    p_color.red, p_color.green, p_color.blue, p_color.white
+  };
+
+  if (m_channel_count == 4 && m_settings.extract_white) {
+    auto const shared =
+      std::min({ p_color.red, p_color.green, p_color.blue });
+    components[0] -= shared;
+    components[1] -= shared;
+    components[2] -= shared;
+    components[3] = std::max(components[3], shared);
+  }
+
+  std::array<std::uint16_t, 4> off_ticks{};
+  for (std::size_t i = 0; i < m_channel_count; i++) {
+    off_ticks[i] = ticks(components[i], i);
+  }
+  m_pca9685->set_channel_ticks(std::span(off_ticks).first(m_channel_count),
+                               m_first_channel);
+}
+
+void pca9685_color_group::set(hsv_color const& p_color)
+{
+  set(to_rgb(p_color));
+}
+
+void pca9685_color_group::configure(settings const& p_settings)
+{
+  m_settings = p_settings;
+}
+
+std::uint16_t pca9685_color_group::ticks(std::uint8_t p_component,
+                                         std::size_t p_channel) const
+{
+  // Round to nearest when scaling by the white balance
+  std::uint32_t const balance = m_settings.white_balance[p_channel];
+  auto const balanced =
+    static_cast<std::uint8_t>((p_component * balance + 127) / 255);
+
+  if (m_settings.gamma != nullptr) {
+    return (*m_settings.gamma)[balanced];
+  }
+  return static_cast<std::uint16_t>((balanced * 4095U + 127) / 255);
+}
+}  // namespace hal::expander
@@ -0,0 +1,53 @@
+#include <libhal-expander/pca9685_complementary_pair.hpp>
+
+#include <cmath>
+
+#include <libhal/error.hpp>
+
+namespace hal::expander {
+pca9685_complementary_pair::pca9685_complementary_pair(
+  pca9685& p_pca9685,
+  hal::byte p_high_side_channel,
+  std::uint16_t p_dead_time)
+  : m_pca9685(&p_pca9685)
+  , m_high_side_channel(p_high_side_channel)
+  , m_dead_time(p_dead_time)
+{
+  if (p_high_side_channel + 2U > pca9685::max_channel_count) {
+    hal::safe_throw(hal::argument_out_of_domain(this));
+  }
+  m_pca9685->write_together(m_high_side_channel, 2);
+}
+
+void pca9685_complementary_pair::dead_time(std::uint16_t p_dead_time)
+{
+  m_dead_time = p_dead_time;
+}
+
+void pca9685_complementary_pair::dead_time(hal::time_duration p_dead_time,
+                                           hal::hertz p_frequency)
+{
+  m_dead_time = dead_time_ticks(p_dead_time, p_frequency);
+}
+
+std::uint16_t pca9685_complementary_pair::dead_time() const
+{
+  return m_dead_time;
+}
+
+void pca9685_complementary_pair::duty_cycle(float p_duty_cycle)
+{
+  if (!(p_duty_cycle >= 0.0f && p_duty_cycle <= 1.0f)) {
+    hal::safe_throw(hal::argument_out_of_domain(this));
+  }
+  auto const cycle = static_cast<float>(pca9685_registers::cycle_ticks);
+  high_side_ticks(
+    static_cast<std::uint16_t>(std::round(cycle * p_duty_cycle)));
+}
+
+void pca9685_complementary_pair::high_side_ticks(std::uint16_t p_high_ticks)
+{
+  auto const edges = complementary_edges(p_high_ticks, m_dead_time);
+  m_pca9685->set_channel_edges(edges, m_high_side_channel);
+}
+}  // namespace hal::expander
@@ -0,0 +1,290 @@
+#include <libhal-expander/sample_log.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <utility>
+
+#include <libhal/error.hpp>
+
+namespace hal::expander {
+namespace {
+namespace format = sample_log_format;
+
+constexpr std::size_t sequence_offset = 0;
+constexpr std::size_t frame_count_offset = 4;
+constexpr std::size_t first_timestamp_offset = 6;
+
+template<std::size_t bytes>
+void store_le(hal::byte* p_destination, std::uint64_t p_value)
+{
+  for (std::size_t i = 0; i < bytes; i++) {
+    p_destination[i] = static_cast<hal::byte>(p_value >> (i * 8));
+  }
+}
+
+template<std::size_t bytes>
+std::uint64_t load_le(hal::byte const* p_source)
+{
+  std::uint64_t value = 0;
+  for (std::size_t i = 0; i < bytes; i++) {
+    value |= std::uint64_t{ p_source[i] } << (i * 8);
+  }
+  return value;
+}
+
+hal::byte* put_varint(hal::byte* p_destination, std::uint64_t p_value)
+{
+  while (p_value >= 0x80) {
+    *p_destination++ = static_cast<hal::byte>(p_value | 0x80);
+    p_value >>= 7;
+  }
+  *p_destination++ = static_cast<hal::byte>(p_value);
+  return p_destination;
+}
+
+std::uint64_t get_varint(hal::byte const*& p_cursor, hal::byte const* p_end)
+{
+  std::uint64_t value = 0;
+  for (unsigned shift = 0; shift < 64; shift += 7) {
+    if (p_cursor == p_end) {
+      throw hal::io_error(nullptr);
+    }
+    auto const data = *p_cursor++;
+    value |= std::uint64_t{ data & 0x7FU } << shift;
+    if ((data & 0x80) == 0) {
+      return value;
+    }
+  }
+  // More than 10 bytes is not a varint this format produces
+  throw hal::io_error(nullptr);
+}
+
+std::uint32_t zigzag(std::int32_t p_delta)
+{
+  return (static_cast<std::uint32_t>(p_delta) << 1) ^
+         static_cast<std::uint32_t>(p_delta >> 31);
+}
+
+std::int32_t unzigzag(std::uint64_t p_value)
+{
+  auto const value = static_cast<std::uint32_t>(p_value);
+  return static_cast<std::int32_t>((value >> 1) ^ (0U - (value & 1U)));
+}
+
+bool logged(hal::byte p_channels, std::size_t p_pin)
+{
+  return (p_channels >> p_pin) & 1U;
+}
+}  // namespace
+
+sample_log_encoder::sample_log_encoder(hal::byte p_channels,
+                                       hal::hertz p_timestamp_frequency,
+                                       std::span<hal::byte> p_block,
+                                       sink p_sink)
+  : m_block(p_block)
+  , m_sink(std::move(p_sink))
+  , m_channels(p_channels)
+{
+  if (m_block.size() < format::min_block_size ||
+      m_block.size() > std::numeric_limits<std::uint16_t>::max()) {
+    throw hal::argument_out_of_domain(this);
+  }
+
+  std::array<hal::byte, format::header_size> header{};
+  std::ranges::copy(format::magic, header.begin());
+  header[4] = format::version;
+  header[5] = m_channels;
+  store_le<2>(&header[6], m_block.size());
+  store_le<4>(&header[8],
+              static_cast<std::uint32_t>(std::lround(p_timestamp_frequency)));
+  m_sink(header);
+}
+
+void sample_log_encoder::append(std::uint64_t p_timestamp,
+                                std::span<std::uint16_t const, 8> p_codes)
+{
+  bool const first_frame = m_frames == 0 && m_sequence == 0;
+  if (!first_frame && p_timestamp < m_timestamp) {
+    throw hal::argument_out_of_domain(this);
+  }
+
+  std::array<hal::byte, format::max_frame_size> frame{};
+  if (m_frames == 0) {
+    start_block(p_timestamp);
+  }
+  auto size = encode(p_timestamp, p_codes, frame);
+
+  if (m_used + size > m_block.size()) {
+    flush();
+    // The first frame of a block is encoded from the block's initial state
+    start_block(p_timestamp);
+    size = encode(p_timestamp, p_codes, frame);
+  }
+
+  std::copy_n(frame.begin(), size, m_block.begin() + m_used);
+  m_used += size;
+  m_frames++;
+  m_timestamp = p_timestamp;
+  for (std::size_t pin = 0; pin < m_codes.size(); pin++) {
+    if (logged(m_channels, pin)) {
+      m_codes[pin] = p_codes[pin];
+    }
+  }
+}
+
+void sample_log_encoder::flush()
+{
+  if (m_frames == 0) {
+    return;
+  }
+  store_le<4>(&m_block[sequence_offset], m_sequence);
+  store_le<2>(&m_block[frame_count_offset], m_frames);
+  std::fill(m_block.begin() + m_used, m_block.end(), hal::byte{ 0 });
+  m_sink(m_block);
+
+  m_sequence++;
+  m_frames = 0;
+}
+
+std::uint32_t sample_log_encoder::blocks_written() const
+{
+  return m_sequence;
+}
+
+std::size_t sample_log_encoder::pending_frames() const
+{
+  return m_frames;
+}
+
+std::size_t sample_log_encoder::encode(
+  std::uint64_t p_timestamp,
+  std::span<std::uint16_t const, 8> p_codes,
+  std::span<hal::byte, format::max_frame_size> p_frame) const
+{
+  auto* cursor = put_varint(p_frame.data(), p_timestamp - m_timestamp);
+  for (std::size_t pin = 0; pin < m_codes.size(); pin++) {
+    if (logged(m_channels, pin)) {
+      auto const delta = static_cast<std::int32_t>(p_codes[pin]) - m_codes[pin];
+      cursor = put_varint(cursor, zigzag(delta));
+    }
+  }
+  return static_cast<std::size_t>(cursor - p_frame.data());
+}
+
+void sample_log_encoder::start_block(std::uint64_t p_timestamp)
+{
+  store_le<8>(&m_block[first_timestamp_offset], p_timestamp);
+  m_used = format::block_header_size;
+  m_timestamp = p_timestamp;
+  m_codes.fill(0);
+}
+
+sample_log_block::iterator::iterator(sample_log_block const& p_block)
+  : m_cursor(p_block.m_bytes.data() + format::block_header_size)
+  , m_end(p_block.m_bytes.data() + p_block.m_bytes.size())
+  , m_remaining(p_block.size())
+  , m_channels(p_block.m_channels)
+{
+  m_frame.timestamp = p_block.first_timestamp();
+  if (m_remaining > 0) {
+    decode();
+  }
+}
+
+void sample_log_block::iterator::decode()
+{
+  m_frame.timestamp += get_varint(m_cursor, m_end);
+  for (std::size_t pin = 0; pin < m_frame.codes.size(); pin++) {
+    if (logged(m_channels, pin)) {
+      auto const delta = unzigzag(get_varint(m_cursor, m_end));
+      m_frame.codes[pin] =
+        static_cast<std::uint16_t>(m_frame.codes[pin] + delta);
+    }
+  }
+}
+
+sample_log_block::sample_log_block(std::span<hal::byte const> p_bytes,
+                                   hal::byte p_channels)
+  : m_bytes(p_bytes)
+  , m_channels(p_channels)
+{
+}
+
+std::uint32_t sample_log_block::sequence() const
+{
+  return static_cast<std::uint32_t>(load_le<4>(&m_bytes[sequence_offset]));
+}
+
+std::size_t sample_log_block::size() const
+{
+  return load_le<2>(&m_bytes[frame_count_offset]);
+}
+
+std::uint64_t sample_log_block::first_timestamp() const
+{
+  return load_le<8>(&m_bytes[first_timestamp_offset]);
+}
+
+sample_log_block::iterator sample_log_block::begin() const
+{
+  return iterator(*this);
+}
+
+sample_log_reader::sample_log_reader(std::span<hal::byte const> p_log)
+{
+  if (p_log.size() < format::header_size ||
+      !std::ranges::equal(p_log.first(format::magic.size()), format::magic) ||
+      p_log[4] != format::version) {
+    throw hal::io_error(this);
+  }
+
+  m_channels = p_log[5];
+  m_block_size = load_le<2>(&p_log[6]);
+  m_timestamp_frequency = static_cast<std::uint32_t>(load_le<4>(&p_log[8]));
+  if (m_block_size < format::min_block_size) {
+    throw hal::io_error(this);
+  }
+  m_blocks = p_log.subspan(format::header_size);
+}
+
+hal::byte sample_log_reader::channels() const
+{
+  return m_channels;
+}
+
+hal::hertz sample_log_reader::timestamp_frequency() const
+{
+  return static_cast<hal::hertz>(m_timestamp_frequency);
+}
+
+std::size_t sample_log_reader::block_count() const
+{
+  return m_blocks.size() / m_block_size;
+}
+
+sample_log_block sample_log_reader::block(std::size_t p_index) const
+{
+  if (p_index >= block_count()) {
+    throw hal::argument_out_of_domain(nullptr);
+  }
+  return { m_blocks.subspan(p_index * m_block_size, m_block_size),
+           m_channels };
+}
+
+std::size_t sample_log_reader::find(std::uint64_t p_timestamp) const
+{
+  // Index of the first block that starts after p_timestamp
+  std::size_t low = 0;
+  std::size_t high = block_count();
+  while (low < high) {
+    auto const middle = low + (high - low) / 2;
+    if (block(middle).first_timestamp() <= p_timestamp) {
+      low = middle + 1;
+    } else {
+      high = middle;
+    }
+  }
+  return low > 0 ? low - 1 : 0;
+}
+}  // namespace hal::expander
@@ -0,0 +1,92 @@
+#include <libhal-expander/sense_actuate_pipeline.hpp>
+
+#include <algorithm>
+#include <utility>
+
+#include <libhal/error.hpp>
+
+namespace hal::expander {
+sense_actuate_pipeline::sense_actuate_pipeline(
+  tla2528& p_tla2528,
+  pca9685& p_pca9685,
+  hal::steady_clock& p_clock,
+  hal::callback<kernel> p_kernel,
+  settings const& p_settings)
+  : m_tla2528(&p_tla2528)
+  , m_pca9685(&p_pca9685)
+  , m_clock(&p_clock)
+  , m_kernel(std::move(p_kernel))
+  , m_settings(p_settings)
+{
+  if (p_settings.first_output + p_settings.output_count >
+      pca9685::max_channel_count) {
+    throw hal::argument_out_of_domain(this);
+  }
+}
+
+void sense_actuate_pipeline::sense()
+{
+  frame next{};
+  next.sense_start = m_clock->uptime();
+  next.sequence = ++m_sequence;
+
+  m_tla2528->scan(m_settings.input_channels, m_codes);
+  m_kernel(m_codes, std::span(next.ticks).first(m_settings.output_count));
+  m_frames.publish(next);
+}
+
+bool sense_actuate_pipeline::actuate()
+{
+  auto const latest = m_frames.read();
+  if (latest.sequence == m_committed) {
+    return false;
+  }
+
+  m_pca9685->set_channel_ticks(
+    std::span(latest.ticks).first(m_settings.output_count),
+    m_settings.first_output);
+  auto const latency = to_duration(m_clock->uptime() - latest.sense_start);
+
+  // The first commit has no earlier frame to be dropped or to measure jitter
+  // against.
+  if (m_statistics.cycles == 0) {
+    m_statistics.min_latency = latency;
+  } else {
+    m_statistics.dropped += latest.sequence - m_committed - 1;
+    auto const jitter = latency > m_statistics.last_latency
+                          ? latency - m_statistics.last_latency
+                          : m_statistics.last_latency - latency;
+    m_statistics.last_jitter = jitter;
+    m_statistics.max_jitter = std::max(m_statistics.max_jitter, jitter);
+  }
+  m_statistics.cycles++;
+  m_statistics.last_latency = latency;
+  m_statistics.min_latency = std::min(m_statistics.min_latency, latency);
+  m_statistics.max_latency = std::max(m_statistics.max_latency, latency);
+  m_committed = latest.sequence;
+  return true;
+}
+
+void sense_actuate_pipeline::run_cycle()
+{
+  sense();
+  actuate();
+}
+
+sense_actuate_pipeline::statistics const& sense_actuate_pipeline::stats() const
+{
+  return m_statistics;
+}
+
+void sense_actuate_pipeline::reset_statistics()
+{
+  m_statistics = {};
+}
+
+hal::time_duration sense_actuate_pipeline::to_duration(std::uint64_t p_ticks)
+{
+  auto const nanoseconds_per_tick = 1e9f / m_clock->frequency();
+  return hal::time_duration(static_cast<hal::time_duration::rep>(
+    static_cast<float>(p_ticks) * nanoseconds_per_tick));
+}
+}  // namespace hal::expander
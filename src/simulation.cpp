@@ -0,0 +1,395 @@
+#include <libhal-expander/simulation.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+#include <libhal/error.hpp>
+
+#include <libhal-expander/tla2528_registers.hpp>
+#include <libhal-expander/tracepoint.hpp>
+
+namespace hal::expander {
+namespace {
+// 8 data bits plus the acknowledge bit
+constexpr std::size_t bits_per_byte = 9;
+
+// pca9685 power on values (Table 4 on datasheet)
+constexpr hal::byte pca9685_mode1_reset = 0x11;
+constexpr hal::byte pca9685_mode2_reset = 0x04;
+constexpr hal::byte pca9685_prescale_reset = 0x1E;
+constexpr hal::byte pca9685_full_off = 0x10;
+
+// LEDn_ON_L of channel 0 and LEDn_OFF_H of channel 0, the last byte of each
+// 4 byte channel
+constexpr hal::byte pca9685_led0_on_l = 0x06;
+constexpr hal::byte pca9685_led0_off_h = 0x09;
+constexpr hal::byte pca9685_all_led_off_h = 0xFD;
+constexpr hal::byte pca9685_prescale = 0xFE;
+constexpr hal::byte pca9685_auto_increment = 1 << 5;
+constexpr hal::byte pca9685_output_change_on_ack = 1 << 3;
+constexpr hal::byte pca9685_all_channel_registers = 0x0F;
+
+// GENERAL_CFG command bits clear themselves once executed
+constexpr hal::byte tla2528_reset_bit = 1 << 0;
+constexpr hal::byte tla2528_command_bits = 0x0F;
+}  // namespace
+
+simulated_clock::simulated_clock(hal::time_duration p_read_cost)
+  : m_read_cost(static_cast<std::uint64_t>(p_read_cost.count()))
+{
+}
+
+void simulated_clock::advance(hal::time_duration p_duration)
+{
+  m_ticks += static_cast<std::uint64_t>(p_duration.count());
+}
+
+hal::time_duration simulated_clock::now() const
+{
+  return hal::time_duration(static_cast<hal::time_duration::rep>(m_ticks));
+}
+
+hal::hertz simulated_clock::driver_frequency()
+{
+  return 1'000'000'000.0f;
+}
+
+std::uint64_t simulated_clock::driver_uptime()
+{
+  m_ticks += m_read_cost;
+  return m_ticks;
+}
+
+simulated_i2c::simulated_i2c(simulated_clock& p_clock)
+  : m_clock(&p_clock)
+{
+}
+
+void simulated_i2c::attach(hal::byte p_address, simulated_device& p_device)
+{
+  m_devices.push_back({ .address = p_address, .device = &p_device });
+}
+
+std::uint32_t simulated_i2c::transaction_count() const
+{
+  return m_transaction_count;
+}
+
+void simulated_i2c::driver_configure(settings const& p_settings)
+{
+  m_clock_rate = p_settings.clock_rate;
+}
+
+void simulated_i2c::driver_transaction(
+  hal::byte p_address,
+  std::span<hal::byte const> p_data_out,
+  std::span<hal::byte> p_data_in,
+  hal::function_ref<hal::timeout_function>)
+{
+  m_transaction_count++;
+
+  bool const has_write = !p_data_out.empty() || p_data_in.empty();
+  auto const frames = std::size_t{ has_write } + (p_data_in.empty() ? 0 : 1);
+  auto const bytes = frames + p_data_out.size() + p_data_in.size();
+  auto const seconds =
+    static_cast<float>(bytes * bits_per_byte) / m_clock_rate;
+  m_clock->advance(hal::time_duration(
+    static_cast<hal::time_duration::rep>(std::ceil(seconds * 1e9f))));
+
+  auto const match = std::ranges::find(
+    m_devices, p_address, [](attachment const& p) { return p.address; });
+  if (match == m_devices.end()) {
+    throw hal::no_such_device(p_address, this);
+  }
+
+  if (has_write) {
+    match->device->write(p_data_out);
+  }
+  if (!p_data_in.empty()) {
+    match->device->read(p_data_in);
+  }
+}
+
+simulated_pca9685::simulated_pca9685()
+{
+  m_registers[0x00] = pca9685_mode1_reset;
+  m_registers[0x01] = pca9685_mode2_reset;
+  for (std::size_t i = pca9685_led0_off_h; i <= pca9685_all_led_off_h;
+       i += 4) {
+    m_registers[i] = pca9685_full_off;
+  }
+  m_registers[pca9685_prescale] = pca9685_prescale_reset;
+  std::copy_n(m_registers.begin() + pca9685_led0_on_l,
+              m_outputs.size(),
+              m_outputs.begin());
+}
+
+hal::byte simulated_pca9685::register_value(hal::byte p_address) const
+{
+  return m_registers[p_address];
+}
+
+std::uint16_t simulated_pca9685::off_ticks(hal::byte p_channel) const
+{
+  auto const off_l = static_cast<std::size_t>(0x08 + (p_channel * 4));
+  return static_cast<std::uint16_t>((m_registers[off_l + 1] & 0x0F) << 8 |
+                                    m_registers[off_l]);
+}
+
+std::uint16_t simulated_pca9685::output_off_ticks(hal::byte p_channel) const
+{
+  auto const off_l = static_cast<std::size_t>(2 + (p_channel * 4));
+  return static_cast<std::uint16_t>((m_outputs[off_l + 1] & 0x0F) << 8 |
+                                    m_outputs[off_l]);
+}
+
+void simulated_pca9685::driver_write(std::span<hal::byte const> p_data)
+{
+  if (p_data.empty()) {
+    return;
+  }
+  m_pointer = p_data[0];
+  auto const change_on_ack =
+    (m_registers[0x01] & pca9685_output_change_on_ack) != 0;
+  for (auto const value : p_data.subspan(1)) {
+    m_registers[m_pointer] = value;
+    auto const offset = static_cast<std::size_t>(m_pointer - pca9685_led0_on_l);
+    if (m_pointer >= pca9685_led0_on_l && offset < m_outputs.size()) {
+      auto const channel = offset / 4;
+      m_loaded[channel] |= static_cast<hal::byte>(1U << (offset % 4));
+      if (change_on_ack && m_loaded[channel] == pca9685_all_channel_registers) {
+        latch(channel);
+      }
+    }
+    advance_pointer();
+  }
+
+  // Without OCH, every loaded channel changes at the STOP condition
+  if (!change_on_ack) {
+    for (std::size_t channel = 0; channel < channel_count; channel++) {
+      if (m_loaded[channel] != 0) {
+        latch(channel);
+      }
+    }
+  }
+}
+
+void simulated_pca9685::driver_read(std::span<hal::byte> p_data)
+{
+  for (auto& value : p_data) {
+    value = m_registers[m_pointer];
+    advance_pointer();
+  }
+}
+
+void simulated_pca9685::latch(std::size_t p_channel)
+{
+  auto const first = p_channel * 4;
+  std::copy_n(m_registers.begin() + pca9685_led0_on_l + first,
+              4,
+              m_outputs.begin() + first);
+  m_loaded[p_channel] = 0;
+}
+
+void simulated_pca9685::advance_pointer()
+{
+  if (m_registers[0x00] & pca9685_auto_increment) {
+    m_pointer++;
+  }
+}
+
+simulated_tla2528::simulated_tla2528() = default;
+
+void simulated_tla2528::set_analog_input(hal::byte p_channel,
+                                         std::uint16_t p_code)
+{
+  m_analog_inputs.at(p_channel) = p_code & 0xFFF;
+}
+
+void simulated_tla2528::set_analog_noise(hal::byte p_channel,
+                                         std::uint16_t p_amplitude)
+{
+  m_analog_noise.at(p_channel) = p_amplitude;
+}
+
+void simulated_tla2528::set_digital_inputs(hal::byte p_levels)
+{
+  m_digital_inputs = p_levels;
+}
+
+hal::byte simulated_tla2528::register_value(hal::byte p_address) const
+{
+  return read_register(p_address);
+}
+
+std::uint32_t simulated_tla2528::conversion_count() const
+{
+  return m_conversion_count;
+}
+
+void simulated_tla2528::driver_write(std::span<hal::byte const> p_data)
+{
+  using namespace tla2528_registers;
+
+  // A write without a register address does not complete a command, so the
+  // next read returns conversion data.
+  m_read_source = read_source::conversion;
+  if (p_data.size() < 2) {
+    return;
+  }
+
+  auto const address = p_data[1];
+  auto const values = p_data.subspan(2);
+  switch (p_data[0]) {
+    case op_codes::single_register_read:
+      m_pointer = address;
+      m_read_source = read_source::single_register;
+      break;
+    case op_codes::continuous_register_read:
+      m_pointer = address;
+      m_read_source = read_source::continuous_registers;
+      break;
+    case op_codes::single_register_write:
+      if (!values.empty()) {
+        write_register(address, values[0]);
+      }
+      break;
+    case op_codes::set_bit:
+      if (!values.empty()) {
+        write_register(address, m_registers[address] | values[0]);
+      }
+      break;
+    case op_codes::clear_bit:
+      if (!values.empty()) {
+        write_register(address, m_registers[address] & ~values[0]);
+      }
+      break;
+    case op_codes::continuous_register_write:
+      for (std::size_t i = 0; i < values.size(); i++) {
+        write_register(static_cast<hal::byte>(address + i), values[i]);
+      }
+      break;
+    default:
+      break;
+  }
+}
+
+void simulated_tla2528::driver_read(std::span<hal::byte> p_data)
+{
+  using namespace tla2528_registers;
+
+  switch (m_read_source) {
+    case read_source::single_register:
+      std::ranges::fill(p_data, read_register(m_pointer));
+      break;
+    case read_source::continuous_registers:
+      for (auto& value : p_data) {
+        value = read_register(m_pointer++);
+      }
+      break;
+    case read_source::conversion: {
+      auto const channel =
+        static_cast<hal::byte>(m_registers[channel_sel::address] & 0x07);
+      auto const frame = convert(channel);
+      for (std::size_t i = 0; i < p_data.size(); i++) {
+        p_data[i] = static_cast<hal::byte>(i % 2 == 0 ? frame >> 8 : frame);
+        if (i % 2 == 1) {
+          m_conversion_count++;
+        }
+      }
+      break;
+    }
+  }
+  m_read_source = read_source::conversion;
+}
+
+void simulated_tla2528::write_register(hal::byte p_address, hal::byte p_value)
+{
+  using namespace tla2528_registers;
+
+  if (p_address == general_cfg::address) {
+    if (p_value & tla2528_reset_bit) {
+      m_registers = {};
+      return;
+    }
+    p_value &= static_cast<hal::byte>(~tla2528_command_bits);
+  }
+  m_registers[p_address] = p_value;
+}
+
+hal::byte simulated_tla2528::read_register(hal::byte p_address) const
+{
+  using namespace tla2528_registers;
+
+  if (p_address == gpi_value::address) {
+    // Pins configured as digital outputs read back their output level
+    auto const digital = m_registers[pin_cfg::address];
+    auto const outputs = m_registers[gpio_cfg::address];
+    auto const levels = (m_digital_inputs & ~outputs) |
+                        (m_registers[gpo_value::address] & outputs);
+    return static_cast<hal::byte>(levels & digital);
+  }
+  return m_registers[p_address];
+}
+
+std::uint16_t simulated_tla2528::convert(hal::byte p_channel)
+{
+  using namespace tla2528_registers;
+
+  // Without averaging, the 12-bit result is left aligned in the 16-bit frame
+  // (Figure 25 on datasheet). With averaging, the frame is the 16-bit
+  // average, with 4 bits below the 12-bit code.
+  std::int32_t const amplitude = m_analog_noise[p_channel];
+  if (amplitude == 0) {
+    return static_cast<std::uint16_t>(m_analog_inputs[p_channel] << 4);
+  }
+
+  auto const ratio_bits = m_registers[osr_cfg::address] & 0x07;
+  std::int32_t sum = 0;
+  for (std::int32_t i = 0; i < (1 << ratio_bits); i++) {
+    // xorshift32
+    m_noise_state ^= m_noise_state << 13;
+    m_noise_state ^= m_noise_state >> 17;
+    m_noise_state ^= m_noise_state << 5;
+    auto const offset =
+      static_cast<std::int32_t>(m_noise_state % (2 * amplitude + 1)) -
+      amplitude;
+    sum += std::clamp(m_analog_inputs[p_channel] + offset, 0, 4095);
+  }
+  return static_cast<std::uint16_t>((sum << 4) >> ratio_bits);
+}
+
+latency_report measure_latency(simulated_clock& p_clock,
+                               std::uint32_t p_iterations,
+                               hal::callback<void()> const& p_operation)
+{
+  latency_report report{};
+  std::vector<hal::time_duration> latencies;
+  latencies.reserve(p_iterations);
+
+  for (std::uint32_t i = 0; i < p_iterations; i++) {
+    auto const start = p_clock.now();
+    try {
+      p_operation();
+    } catch (hal::exception const&) {
+      report.failures++;
+    }
+    latencies.push_back(p_clock.now() - start);
+  }
+
+  if (latencies.empty()) {
+    return report;
+  }
+
+  std::ranges::sort(latencies);
+  auto const rank = [&latencies](float p_fraction) {
+    return latencies[percentile_rank(latencies.size(), p_fraction) - 1];
+  };
+
+  report.samples = p_iterations;
+  report.p50 = rank(0.50f);
+  report.p99 = rank(0.99f);
+  report.max = latencies.back();
+  return report;
+}
+}  // namespace hal::expander
@@ -0,0 +1,74 @@
+#include <libhal-expander/tca9548.hpp>
+
+#include <algorithm>
+#include <array>
+
+#include <libhal/error.hpp>
+
+namespace hal::expander {
+tca9548::port::port(tca9548* p_tca9548, hal::byte p_port)
+  : m_tca9548(p_tca9548)
+  , m_port(p_port)
+{
+}
+
+void tca9548::port::driver_configure(settings const& p_settings)
+{
+  // Every port shares the upstream bus and its clock rate
+  m_tca9548->m_i2c->configure(p_settings);
+}
+
+void tca9548::port::driver_transaction(
+  hal::byte p_address,
+  std::span<hal::byte const> p_data_out,
+  std::span<hal::byte> p_data_in,
+  hal::function_ref<hal::timeout_function> p_timeout)
+{
+  m_tca9548->select(m_port, p_timeout);
+  m_tca9548->m_i2c->transaction(p_address, p_data_out, p_data_in, p_timeout);
+}
+
+tca9548::tca9548(hal::i2c& p_i2c, hal::byte p_address)
+  : m_i2c(&p_i2c)
+  , m_address(p_address)
+{
+}
+
+void tca9548::select(hal::byte p_port,
+                     hal::function_ref<hal::timeout_function> p_timeout)
+{
+  if (p_port >= port_count) {
+    throw hal::argument_out_of_domain(this);
+  }
+  if (m_selected == p_port) {
+    return;
+  }
+
+  // Until the write succeeds, the multiplexer's state is unknown
+  m_selected = unknown_port;
+  auto const control_value = static_cast<hal::byte>(1U << p_port);
+  std::array<hal::byte, 1> const control{ control_value };
+  m_select_count++;
+  m_i2c->transaction(m_address, control, {}, p_timeout);
+  m_selected = p_port;
+}
+
+void tca9548::invalidate()
+{
+  m_selected = unknown_port;
+}
+
+std::uint32_t tca9548::select_count() const
+{
+  return m_select_count;
+}
+
+void run_grouped_by_port(std::span<tca9548_job> p_jobs)
+{
+  std::ranges::stable_sort(
+    p_jobs, {}, [](tca9548_job const& p_job) { return p_job.port; });
+  for (auto& job : p_jobs) {
+    job.job();
+  }
+}
+}  // namespace hal::expander
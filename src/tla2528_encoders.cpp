@@ -0,0 +1,119 @@
+#include <libhal-expander/tla2528_encoders.hpp>
+
+#include <libhal-util/bit.hpp>
+#include <libhal/error.hpp>
+
+namespace hal::expander {
+namespace {
+// Index is the previous state in bits 3:2 and the new state in bits 1:0,
+// where a state is A in bit 1 and B in bit 0. With A leading B the states
+// follow 0b00, 0b10, 0b11, 0b01, which counts up.
+constexpr std::array<std::int8_t, 16> step{ 0,  -1, 1, 0,  1, 0,  0, -1,
+                                            -1, 0,  0, 1,  0, 1, -1, 0 };
+// Transitions in which both A and B changed
+constexpr std::array<std::uint8_t, 16> illegal{ 0, 0, 0, 1, 0, 0, 1, 0,
+                                                0, 1, 0, 0, 1, 0, 0, 0 };
+
+hal::byte pin_state(hal::byte p_input_bus, encoder_pins const& p_pins)
+{
+  auto const a = (p_input_bus >> p_pins.a) & 1U;
+  auto const b = (p_input_bus >> p_pins.b) & 1U;
+  return static_cast<hal::byte>((a << 1) | b);
+}
+}  // namespace
+
+tla2528_encoders make_encoders(tla2528& p_tla2528,
+                               std::span<encoder_pins const> p_pins)
+{
+  return { p_tla2528, p_pins };
+}
+
+tla2528_encoders::tla2528_encoders(tla2528& p_tla2528,
+                                   std::span<encoder_pins const> p_pins)
+  : m_tla2528(&p_tla2528)
+{
+  if (p_pins.size() > max_encoders) {
+    throw hal::argument_out_of_domain(this);
+  }
+
+  // Validate every pin before reserving any, so a failure leaves the other
+  // pins of the tla2528 untouched.
+  hal::byte used = 0;
+  for (auto const& pins : p_pins) {
+    for (auto const channel : { pins.a, pins.b }) {
+      m_tla2528->throw_if_invalid_channel(channel);
+      m_tla2528->throw_if_channel_occupied(channel);
+      if (hal::bit_extract(hal::bit_mask::from(channel), used)) {
+        throw hal::argument_out_of_domain(this);
+      }
+      hal::bit_modify(used).set(hal::bit_mask::from(channel));
+    }
+  }
+
+  for (auto const& pins : p_pins) {
+    m_tla2528->set_pin_mode(tla2528::pin_mode::input_pin, pins.a);
+    m_tla2528->set_pin_mode(tla2528::pin_mode::input_pin, pins.b);
+    m_encoders[m_count++].pins = pins;
+  }
+  m_tla2528->m_object_created |= used;
+
+  auto const input_bus = m_tla2528->get_input_bus();
+  for (std::size_t i = 0; i < m_count; i++) {
+    m_encoders[i].state = pin_state(input_bus, m_encoders[i].pins);
+  }
+}
+
+tla2528_encoders::~tla2528_encoders()
+{
+  m_tla2528->m_object_created &= static_cast<hal::byte>(~channel_mask());
+}
+
+void tla2528_encoders::sample()
+{
+  decode(m_tla2528->get_input_bus());
+}
+
+void tla2528_encoders::decode(hal::byte p_input_bus)
+{
+  for (std::size_t i = 0; i < m_count; i++) {
+    auto& encoder = m_encoders[i];
+    auto const state = pin_state(p_input_bus, encoder.pins);
+    auto const transition = (encoder.state << 2) | state;
+    // Unsigned arithmetic so the position wraps instead of overflowing
+    encoder.position += static_cast<std::uint32_t>(step[transition]);
+    encoder.errors += illegal[transition];
+    encoder.state = state;
+  }
+}
+
+std::int32_t tla2528_encoders::position(std::size_t p_encoder) const
+{
+  return static_cast<std::int32_t>(m_encoders[p_encoder].position);
+}
+
+std::uint32_t tla2528_encoders::errors(std::size_t p_encoder) const
+{
+  return m_encoders[p_encoder].errors;
+}
+
+void tla2528_encoders::reset(std::size_t p_encoder, std::int32_t p_position)
+{
+  m_encoders[p_encoder].position = static_cast<std::uint32_t>(p_position);
+  m_encoders[p_encoder].errors = 0;
+}
+
+std::size_t tla2528_encoders::count() const
+{
+  return m_count;
+}
+
+hal::byte tla2528_encoders::channel_mask() const
+{
+  hal::byte mask = 0;
+  for (std::size_t i = 0; i < m_count; i++) {
+    hal::bit_modify(mask).set(hal::bit_mask::from(m_encoders[i].pins.a));
+    hal::bit_modify(mask).set(hal::bit_mask::from(m_encoders[i].pins.b));
+  }
+  return mask;
+}
+}  // namespace hal::expander
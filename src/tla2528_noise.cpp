@@ -0,0 +1,155 @@
+#include <libhal-expander/tla2528_noise.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+
+#include <libhal/error.hpp>
+
+namespace hal::expander {
+namespace {
+constexpr std::uint16_t min_samples = 2;
+// Keeps the scaled variance sum below 2^64
+constexpr std::uint16_t max_samples = 1024;
+// Frames hold codes in sixteenths
+constexpr std::uint64_t frame_fraction = 16;
+constexpr std::size_t frame_fraction_bits = 4;
+
+// Sums of raw frames, so that oversampled averages keep their fraction of a
+// code
+struct accumulator
+{
+  std::uint64_t sum = 0;
+  std::uint64_t sum_of_squares = 0;
+  std::uint16_t minimum = std::numeric_limits<std::uint16_t>::max();
+  std::uint16_t maximum = 0;
+
+  void add(std::uint16_t p_frame)
+  {
+    sum += p_frame;
+    sum_of_squares += std::uint64_t{ p_frame } * p_frame;
+    minimum = std::min(minimum, p_frame);
+    maximum = std::max(maximum, p_frame);
+  }
+};
+
+std::uint64_t integer_sqrt(std::uint64_t p_value)
+{
+  std::uint64_t root = 0;
+  std::uint64_t bit = std::uint64_t{ 1 } << 62;
+  while (bit > p_value) {
+    bit >>= 2;
+  }
+  while (bit != 0) {
+    if (p_value >= root + bit) {
+      p_value -= root + bit;
+      root = (root >> 1) + bit;
+    } else {
+      root >>= 1;
+    }
+    bit >>= 2;
+  }
+  return root;
+}
+
+tla2528_noise_stats summarize(accumulator const& p_pin,
+                              std::uint64_t p_count,
+                              std::size_t p_ratio)
+{
+  // n^2 * variance = n * sum(x^2) - sum(x)^2, exact in integers
+  auto const scaled_variance =
+    p_count * p_pin.sum_of_squares - p_pin.sum * p_pin.sum;
+  // 1000 / 16 millicodes per frame step is sqrt(15625) / 2. The product stays
+  // below 2^64 for any frames within max_samples.
+  auto const std_dev_millicodes =
+    (integer_sqrt(scaled_variance * 15'625) + p_count) / (2 * p_count);
+
+  // Ideal quantization noise is 1/sqrt(12) codes, about 289 millicodes. Each
+  // doubling of the ratio adds a bit of fraction to the average, up to the 4
+  // fraction bits of the frame.
+  auto const noise_bits =
+    std::log2(static_cast<float>(std_dev_millicodes) * std::sqrt(12.0f) /
+              1000.0f);
+  auto const fraction_bits =
+    static_cast<float>(std::min(p_ratio, frame_fraction_bits));
+
+  auto const denominator = p_count * frame_fraction;
+  return {
+    .mean_millicodes = static_cast<std::uint32_t>(
+      (p_pin.sum * 1000 + denominator / 2) / denominator),
+    .std_dev_millicodes = static_cast<std::uint32_t>(std_dev_millicodes),
+    .peak_to_peak = static_cast<std::uint16_t>(
+      (p_pin.maximum - p_pin.minimum + frame_fraction / 2) / frame_fraction),
+    .effective_bits = 12.0f - std::max(noise_bits, -fraction_bits),
+  };
+}
+}  // namespace
+
+tla2528_noise_profile characterize_noise(
+  tla2528& p_tla2528,
+  tla2528_noise_settings const& p_settings)
+{
+  if (p_settings.samples < min_samples || p_settings.samples > max_samples) {
+    throw hal::argument_out_of_domain(nullptr);
+  }
+
+  auto const original_ratio = p_tla2528.get_oversampling();
+  tla2528_noise_profile profile{};
+
+  try {
+    for (std::size_t ratio = 0; ratio < tla2528_oversampling_count; ratio++) {
+      p_tla2528.set_oversampling(static_cast<tla2528_oversampling>(ratio));
+
+      std::array<accumulator, 8> pins{};
+      std::array<std::uint16_t, 8> frames{};
+      for (std::uint16_t sample = 0; sample < p_settings.samples; sample++) {
+        p_tla2528.scan_frames(p_settings.pins, frames);
+        for (std::size_t pin = 0; pin < pins.size(); pin++) {
+          if (p_settings.pins & (1U << pin)) {
+            pins[pin].add(frames[pin]);
+          }
+        }
+      }
+
+      for (std::size_t pin = 0; pin < pins.size(); pin++) {
+        if (p_settings.pins & (1U << pin)) {
+          profile.stats[ratio][pin] =
+            summarize(pins[pin], p_settings.samples, ratio);
+        }
+      }
+    }
+  } catch (...) {
+    try {
+      p_tla2528.set_oversampling(original_ratio);
+    } catch (...) {
+      // The measurement's error is the one worth reporting
+    }
+    throw;
+  }
+
+  for (std::size_t pin = 0; pin < profile.pin_ratio.size(); pin++) {
+    if (!(p_settings.pins & (1U << pin))) {
+      continue;
+    }
+    auto const target = p_settings.max_std_dev_millicodes[pin];
+    auto ratio = tla2528_oversampling_count - 1;
+    for (std::size_t candidate = 0; candidate < tla2528_oversampling_count;
+         candidate++) {
+      if (profile.stats[candidate][pin].std_dev_millicodes <= target) {
+        ratio = candidate;
+        break;
+      }
+    }
+    if (profile.stats[ratio][pin].std_dev_millicodes > target) {
+      profile.unmet |= static_cast<hal::byte>(1U << pin);
+    }
+    profile.pin_ratio[pin] = static_cast<tla2528_oversampling>(ratio);
+    profile.ratio = std::max(profile.ratio, profile.pin_ratio[pin]);
+  }
+
+  p_tla2528.set_oversampling(p_settings.apply ? profile.ratio
+                                              : original_ratio);
+  return profile;
+}
+}  // namespace hal::expander
@@ -0,0 +1,140 @@
+#include <libhal-expander/tracepoint.hpp>
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+namespace hal::expander {
+namespace {
+trace_sink* current_sink = nullptr;
+}  // namespace
+
+void set_trace_sink(trace_sink* p_sink)
+{
+  current_sink = p_sink;
+}
+
+trace_sink* get_trace_sink()
+{
+  return current_sink;
+}
+
+void latency_histogram::add(std::uint64_t p_nanoseconds)
+{
+  auto const bucket = std::min<std::size_t>(
+    static_cast<std::size_t>(std::bit_width(p_nanoseconds)),
+    buckets.size() - 1);
+  buckets[bucket]++;
+  count++;
+  max = std::max(max, p_nanoseconds);
+}
+
+std::uint64_t ticks_to_nanoseconds(std::uint64_t p_ticks,
+                                   hal::hertz p_frequency)
+{
+  constexpr std::uint64_t nanoseconds_per_second = 1'000'000'000;
+  auto const frequency =
+    std::max(static_cast<std::uint64_t>(p_frequency), std::uint64_t{ 1 });
+  auto const seconds = p_ticks / frequency;
+  auto const remainder = p_ticks % frequency;
+  return seconds * nanoseconds_per_second +
+         remainder * nanoseconds_per_second / frequency;
+}
+
+std::uint64_t percentile_rank(std::uint64_t p_count, float p_fraction)
+{
+  if (p_count == 0) {
+    return 0;
+  }
+  constexpr std::uint64_t ppm = 1'000'000;
+  auto const clamped = std::clamp(p_fraction, 0.0f, 1.0f);
+  auto const fraction_ppm = static_cast<std::uint64_t>(
+    std::llround(static_cast<double>(clamped) * ppm));
+  return std::max<std::uint64_t>(1, (p_count * fraction_ppm + ppm - 1) / ppm);
+}
+
+std::uint64_t latency_histogram::percentile(float p_fraction) const
+{
+  if (count == 0) {
+    return 0;
+  }
+
+  auto const target = percentile_rank(count, p_fraction);
+
+  std::uint64_t seen = 0;
+  for (std::size_t i = 0; i < buckets.size(); i++) {
+    seen += buckets[i];
+    if (seen >= target) {
+      auto const upper_bound = i == 0 ? 0 : (std::uint64_t{ 1 } << i) - 1;
+      return std::min(upper_bound, max);
+    }
+  }
+  return max;
+}
+
+trace_histogram::trace_histogram(hal::steady_clock& p_clock)
+  : m_clock(&p_clock)
+{
+}
+
+latency_histogram const& trace_histogram::total(trace_op p_op) const
+{
+  return m_operations[static_cast<std::size_t>(p_op)].total;
+}
+
+latency_histogram const& trace_histogram::bus(trace_op p_op) const
+{
+  return m_operations[static_cast<std::size_t>(p_op)].bus;
+}
+
+latency_histogram const& trace_histogram::compute(trace_op p_op) const
+{
+  return m_operations[static_cast<std::size_t>(p_op)].compute;
+}
+
+void trace_histogram::reset()
+{
+  m_operations = {};
+}
+
+void trace_histogram::driver_record(trace_op p_op, trace_phase p_phase)
+{
+  auto const index = static_cast<std::size_t>(p_op);
+  if (index >= m_operations.size()) {
+    return;
+  }
+
+  auto const now = m_clock->uptime();
+  auto& state = m_operations[index];
+
+  switch (p_phase) {
+    case trace_phase::entry:
+      state.entry_time = now;
+      state.bus_ticks = 0;
+      state.compute_ticks = 0;
+      break;
+    case trace_phase::bus_begin:
+      state.bus_begin_time = now;
+      break;
+    case trace_phase::bus_end:
+      state.bus_ticks += now - state.bus_begin_time;
+      break;
+    case trace_phase::exit:
+      state.total.add(nanoseconds(now - state.entry_time));
+      state.bus.add(nanoseconds(state.bus_ticks));
+      state.compute.add(nanoseconds(state.compute_ticks));
+      break;
+    case trace_phase::compute_begin:
+      state.compute_begin_time = now;
+      break;
+    case trace_phase::compute_end:
+      state.compute_ticks += now - state.compute_begin_time;
+      break;
+  }
+}
+
+std::uint64_t trace_histogram::nanoseconds(std::uint64_t p_ticks) const
+{
+  return ticks_to_nanoseconds(p_ticks, m_clock->frequency());
+}
+}  // namespace hal::expander
@@ -0,0 +1,179 @@
+// Copyright 2024 Khalil Estell
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <libhal-expander/autotune.hpp>
+#include <libhal-expander/simulation.hpp>
+
+#include <array>
+
+#include <boost/ut.hpp>
+
+#include "helpers.hpp"
+
+namespace hal::expander {
+namespace {
+// Adds a fixed cost to every transaction, like a bus implementation with a
+// slow start of each transfer
+struct overhead_i2c : public hal::i2c
+{
+  overhead_i2c(hal::i2c& p_i2c,
+               simulated_clock& p_clock,
+               hal::time_duration p_overhead)
+    : i2c(&p_i2c)
+    , clock(&p_clock)
+    , overhead(p_overhead)
+  {
+  }
+
+  void driver_configure(settings const&) override
+  {
+  }
+
+  void driver_transaction(
+    hal::byte p_address,
+    std::span<hal::byte const> p_data_out,
+    std::span<hal::byte> p_data_in,
+    hal::function_ref<hal::timeout_function> p_timeout) override
+  {
+    clock->advance(overhead);
+    i2c->transaction(p_address, p_data_out, p_data_in, p_timeout);
+  }
+
+  hal::i2c* i2c;
+  simulated_clock* clock;
+  hal::time_duration overhead;
+};
+}  // namespace
+
+boost::ut::suite test_autotune = []() {
+  using namespace boost::ut;
+  using namespace std::literals;
+
+  "expander_policy serializes"_test = []() {
+    // Setup
+    constexpr expander_policy policy{
+      .pca9685_burst_gap = 8,
+      .tla2528_scan = tla2528_scan_mode::split,
+    };
+
+    // Exercise
+    constexpr auto bytes = policy.serialize();
+    static_assert(expander_policy::deserialize(bytes) == policy);
+    auto corrupted = bytes;
+    corrupted[2] ^= 0x01;
+    auto wrong_size = std::span(bytes).first(4);
+    constexpr auto no_gap = expander_policy{ .pca9685_burst_gap = 1 };
+
+    // Verify
+    expect(not expander_policy::deserialize(corrupted).has_value());
+    expect(not expander_policy::deserialize(wrong_size).has_value());
+    expect(not expander_policy::deserialize(no_gap.serialize()).has_value());
+  };
+
+  "autotune() prefers fewer bytes on a bus without overhead"_test = []() {
+    // Setup
+    test::board_bench bench(0ns);
+    auto& [clock, i2c, pwm_device, adc_device] = bench;
+    pca9685 pwm(i2c, 0x40);
+    tla2528 adc(i2c);
+    std::array<std::uint16_t, 16> ticks{};
+    ticks.fill(1000);
+    pwm.set_channel_ticks(ticks);
+
+    // Exercise
+    auto const policy = autotune(clock, &pwm, &adc, { .iterations = 3 });
+
+    // Verify
+    expect(that % 2 == policy.pca9685_burst_gap);
+    expect(tla2528_scan_mode::combined == policy.tla2528_scan);
+    for (hal::byte channel = 0; channel < 16; channel++) {
+      expect(that % 1000 == pwm_device.off_ticks(channel));
+    }
+  };
+
+  "autotune() prefers bursts on a bus with overhead"_test = []() {
+    // Setup
+    test::pca9685_bench bench(0ns);
+    auto& [clock, simulated, device] = bench;
+    overhead_i2c i2c(simulated, clock, 1ms);
+    pca9685 pwm(i2c, 0x40);
+    // Unchanged registers can only be rewritten once their values are known
+    std::array<std::uint16_t, 16> const ticks{};
+    pwm.set_channel_ticks(ticks);
+
+    // Exercise
+    auto const policy = autotune(clock, &pwm, nullptr, {});
+
+    // Verify
+    expect(that % 8 == policy.pca9685_burst_gap);
+    expect(tla2528_scan_mode::combined == policy.tla2528_scan);
+  };
+
+  "autotune() prefers whole frames on a bus with large overhead"_test = []() {
+    // Setup
+    test::pca9685_bench bench(0ns);
+    auto& [clock, simulated, device] = bench;
+    overhead_i2c i2c(simulated, clock, 10ms);
+    pca9685 pwm(i2c, 0x40);
+    std::array<std::uint16_t, 16> const ticks{};
+    pwm.set_channel_ticks(ticks);
+
+    // Exercise
+    auto const policy = autotune(clock, &pwm, nullptr, {});
+
+    // Verify
+    expect(that % 64 == policy.pca9685_burst_gap);
+  };
+
+  "autotune() rewrites the current pca9685 values"_test = []() {
+    // Setup
+    test::recording_i2c i2c;
+    test::pca9685_bench bench;
+    pca9685 pwm(i2c, 0x40);
+    std::array<std::uint16_t, 16> ticks{};
+    ticks.fill(1000);
+    pwm.set_channel_ticks(ticks);
+    i2c.writes.clear();
+    // ON_L, ON_H, OFF_L and OFF_H of every channel, starting at 0x06
+    constexpr std::array<hal::byte, 4> channel{ 0x00, 0x00, 0xE8, 0x03 };
+
+    // Exercise
+    autotune(bench.clock, &pwm, nullptr, {});
+
+    // Verify
+    expect(that % 0U != i2c.writes.size());
+    for (auto const& write : i2c.writes) {
+      for (std::size_t i = 1; i < write.size(); i++) {
+        auto const address = write[0] + i - 1;
+        expect(that % channel[(address - 0x06) % 4] == write[i]);
+      }
+    }
+  };
+
+  "autotune() leaves unknown pca9685 registers alone"_test = []() {
+    // Setup
+    test::recording_i2c i2c;
+    test::pca9685_bench bench;
+    pca9685 pwm(i2c, 0x40);
+    i2c.writes.clear();
+
+    // Exercise
+    autotune(bench.clock, &pwm, nullptr, {});
+
+    // Verify
+    expect(that % 0U == i2c.writes.size());
+    expect(that % 0 == pwm.unconfirmed_channels());
+  };
+};
+}  // namespace hal::expander
@@ -0,0 +1,99 @@
+// Copyright 2024 Khalil Estell
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <libhal-expander/board.hpp>
+
+#include <libhal-expander/pca9685.hpp>
+#include <libhal-expander/simulation.hpp>
+#include <libhal-expander/tla2528.hpp>
+
+#include <boost/ut.hpp>
+
+#include "helpers.hpp"
+
+namespace hal::expander {
+namespace {
+constexpr pca9685_description leds{
+  .address = 0x40,
+  .frequency = 1000.0f,
+  .initial_channels = 0b0110,
+  .initial_ticks = { 0, 100, 200 },
+};
+
+constexpr tla2528_description sensors{
+  .address = 0x10,
+  .pin_modes = { tla2528_pin_mode::adc,
+                 tla2528_pin_mode::input_pin,
+                 tla2528_pin_mode::output_pin_push_pull,
+                 tla2528_pin_mode::output_pin_open_drain },
+  .initial_outputs = 0b1100,
+};
+
+constexpr auto board_init = make_init_script<leds, sensors>();
+
+static_assert(board_init.write_count() == 6);
+static_assert(board_init.size() ==
+              (2 + 2) + (2 + 2) + (2 + 3) + (2 + 9) + (2 + 7) + (2 + 3));
+}  // namespace
+
+boost::ut::suite test_board = []() {
+  using namespace boost::ut;
+  using namespace std::literals;
+
+  "run_init_script()"_test = []() {
+    // Setup
+    test::board_bench bench;
+    auto& [clock, i2c, pca9685_device, tla2528_device] = bench;
+
+    // Exercise
+    run_init_script(i2c, board_init.bytes());
+
+    // Verify
+    expect(that % 6U == i2c.transaction_count());
+    expect(that % 0x20 == pca9685_device.register_value(0x00));
+    expect(that % 0x05 == pca9685_device.register_value(0xFE));
+    expect(that % 0 == pca9685_device.off_ticks(0));
+    expect(that % 100 == pca9685_device.off_ticks(1));
+    expect(that % 200 == pca9685_device.off_ticks(2));
+    expect(that % 0b1110 == tla2528_device.register_value(0x05));
+    expect(that % 0b1100 == tla2528_device.register_value(0x07));
+    expect(that % 0b0100 == tla2528_device.register_value(0x09));
+    expect(that % 0b1100 == tla2528_device.register_value(0x0B));
+  };
+
+  "drivers constructed from initial_state()"_test = []() {
+    // Setup
+    test::board_bench bench;
+    auto& [clock, i2c, pca9685_device, tla2528_device] = bench;
+    run_init_script(i2c, board_init.bytes());
+    auto const init_transactions = i2c.transaction_count();
+
+    // Exercise
+    pca9685 pwm(i2c, initial_state(leds));
+    tla2528 gpio(i2c, initial_state(sensors));
+    auto const construction_transactions = i2c.transaction_count();
+    gpio.set_pin_mode(tla2528::pin_mode::input_pin, 1);
+    gpio.set_output_pin(2, true);
+    std::array<std::uint16_t, 2> const ticks{ 100, 300 };
+    pwm.set_channel_ticks(ticks, 1);
+
+    // Verify
+    expect(that % init_transactions == construction_transactions);
+    expect(that % init_transactions + 1 == i2c.transaction_count());
+    expect(that % 300 == pca9685_device.off_ticks(2));
+    // 1 kHz is a prescale of 5
+    expect(hal::time_duration(983'040) == pwm.pwm_period());
+  };
+};
+}  // namespace hal::expander
@@ -0,0 +1,258 @@
+// Copyright 2024 Khalil Estell
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <libhal-expander/bulk_conversion.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include <libhal/error.hpp>
+
+#include <libhal-expander/pca9685_registers.hpp>
+#include <libhal-expander/tla2528_registers.hpp>
+
+#include <boost/ut.hpp>
+
+namespace hal::expander {
+namespace {
+constexpr std::array all_backends{
+  bulk_backend::automatic, bulk_backend::scalar, bulk_backend::sse2,
+  bulk_backend::avx2,      bulk_backend::neon,
+};
+
+// Lengths that leave every possible tail after 4 and 8 lane blocks
+constexpr std::array<std::size_t, 6> tail_lengths{ 0, 1, 3, 7, 9, 15 };
+
+std::vector<std::uint16_t> every_code()
+{
+  std::vector<std::uint16_t> codes(4096);
+  for (std::size_t i = 0; i < codes.size(); i++) {
+    codes[i] = static_cast<std::uint16_t>(i);
+  }
+  return codes;
+}
+
+std::vector<float> duty_cycle_samples()
+{
+  std::vector<float> duty_cycles{
+    0.0f, -0.0f, 1.0f, -1.0f, 2.0f, 0.5f, 1e-9f,
+    std::numeric_limits<float>::infinity(),
+    -std::numeric_limits<float>::infinity(),
+  };
+  // Every tick and the exact half tick points between them
+  for (int tick = 0; tick <= 8190; tick++) {
+    duty_cycles.push_back(static_cast<float>(tick) / 8190.0f);
+  }
+  for (float value = 0.0f; value < 1.0f; value += 0.000731f) {
+    duty_cycles.push_back(value);
+    duty_cycles.push_back(std::nextafter(value, 0.0f));
+  }
+  return duty_cycles;
+}
+
+std::uint32_t driver_millivolts(std::uint16_t p_code, std::uint32_t p_ref)
+{
+  return (tla2528_registers::code_to_microvolts(p_code, p_ref) + 500) / 1000;
+}
+}  // namespace
+
+boost::ut::suite test_bulk_conversion = []() {
+  using namespace boost::ut;
+
+  "bulk_backend_supported()"_test = []() {
+    expect(bulk_backend_supported(bulk_backend::automatic));
+    expect(bulk_backend_supported(bulk_backend::scalar));
+#if defined(__x86_64__)
+    expect(bulk_backend_supported(bulk_backend::sse2));
+    expect(not bulk_backend_supported(bulk_backend::neon));
+#endif
+  };
+
+  "duty_cycles_to_registers() matches duty_cycle_registers()"_test = []() {
+    // Setup
+    auto const duty_cycles = duty_cycle_samples();
+    std::vector<hal::byte> expected;
+    for (auto const duty_cycle : duty_cycles) {
+      auto const clamped = std::clamp(duty_cycle, 0.0f, 1.0f);
+      for (auto const value :
+           pca9685_registers::duty_cycle_registers(clamped)) {
+        expected.push_back(value);
+      }
+    }
+
+    for (auto const backend : all_backends) {
+      if (!bulk_backend_supported(backend)) {
+        continue;
+      }
+      std::vector<hal::byte> registers(expected.size());
+
+      // Exercise
+      duty_cycles_to_registers(duty_cycles, registers, backend);
+
+      // Verify
+      expect(registers == expected) << static_cast<int>(backend);
+    }
+  };
+
+  "duty_cycles_to_registers() treats NaN as 0"_test = []() {
+    // Setup
+    std::array<float, 9> duty_cycles{};
+    duty_cycles.fill(std::numeric_limits<float>::quiet_NaN());
+
+    for (auto const backend : all_backends) {
+      if (!bulk_backend_supported(backend)) {
+        continue;
+      }
+      std::array<hal::byte, 9 * 4> registers{};
+      registers.fill(0xAA);
+
+      // Exercise
+      duty_cycles_to_registers(duty_cycles, registers, backend);
+
+      // Verify
+      expect(registers == std::array<hal::byte, 9 * 4>{})
+        << static_cast<int>(backend);
+    }
+  };
+
+  "codes_to_fractions() matches get_adc_reading()"_test = []() {
+    // Setup
+    auto const codes = every_code();
+    std::vector<float> expected;
+    for (auto const code : codes) {
+      expected.push_back(static_cast<float>(code) / 4096.0f);
+    }
+
+    for (auto const backend : all_backends) {
+      if (!bulk_backend_supported(backend)) {
+        continue;
+      }
+      std::vector<float> fractions(codes.size());
+
+      // Exercise
+      codes_to_fractions(codes, fractions, backend);
+
+      // Verify
+      expect(fractions == expected) << static_cast<int>(backend);
+    }
+  };
+
+  "codes_to_microvolts() and codes_to_millivolts() match the driver"_test =
+    []() {
+      // Setup
+      auto const codes = every_code();
+
+      // From a tiny reference to the largest that cannot overflow 32 bits
+      for (std::uint32_t const reference :
+           { 1U, 1'234U, 2'500'000U, 3'300'000U, 5'000'000U, 1'048'575'999U }) {
+        std::vector<std::uint32_t> expected_microvolts;
+        std::vector<std::uint32_t> expected_millivolts;
+        for (auto const code : codes) {
+          expected_microvolts.push_back(
+            tla2528_registers::code_to_microvolts(code, reference));
+          expected_millivolts.push_back(driver_millivolts(code, reference));
+        }
+
+        for (auto const backend : all_backends) {
+          if (!bulk_backend_supported(backend)) {
+            continue;
+          }
+          std::vector<std::uint32_t> microvolts(codes.size());
+          std::vector<std::uint32_t> millivolts(codes.size());
+
+          // Exercise
+          codes_to_microvolts(codes, reference, microvolts, backend);
+          codes_to_millivolts(codes, reference, millivolts, backend);
+
+          // Verify
+          expect(microvolts == expected_microvolts)
+            << reference << static_cast<int>(backend);
+          expect(millivolts == expected_millivolts)
+            << reference << static_cast<int>(backend);
+        }
+      }
+    };
+
+  "vector blocks and scalar tails agree at every length"_test = []() {
+    // Setup
+    std::array<std::uint16_t, 15> codes{};
+    std::array<float, 15> duty_cycles{};
+    for (std::size_t i = 0; i < codes.size(); i++) {
+      codes[i] = static_cast<std::uint16_t>(i * 273 + 1);
+      duty_cycles[i] = static_cast<float>(i) / 14.0f;
+    }
+
+    for (auto const length : tail_lengths) {
+      auto const code_input = std::span(codes).first(length);
+      auto const duty_input = std::span(duty_cycles).first(length);
+      std::array<std::uint32_t, 16> expected_millivolts{};
+      std::array<hal::byte, 16 * 4> expected_registers{};
+      codes_to_millivolts(
+        code_input, 3'300'000, expected_millivolts, bulk_backend::scalar);
+      duty_cycles_to_registers(
+        duty_input, expected_registers, bulk_backend::scalar);
+
+      for (auto const backend : all_backends) {
+        if (!bulk_backend_supported(backend)) {
+          continue;
+        }
+        std::array<std::uint32_t, 16> millivolts{};
+        std::array<hal::byte, 16 * 4> registers{};
+
+        // Exercise
+        codes_to_millivolts(code_input, 3'300'000, millivolts, backend);
+        duty_cycles_to_registers(duty_input, registers, backend);
+
+        // Verify
+        // Nothing is written past the converted values
+        expect(millivolts == expected_millivolts) << length;
+        expect(registers == expected_registers) << length;
+      }
+    }
+  };
+
+  "conversions reject short outputs and unsupported backends"_test = []() {
+    // Setup
+    std::array<std::uint16_t, 4> codes{};
+    std::array<float, 4> duty_cycles{};
+    std::array<std::uint32_t, 3> short_volts{};
+    std::array<float, 3> short_fractions{};
+    std::array<hal::byte, 15> short_registers{};
+    std::array<std::uint32_t, 4> volts{};
+
+    // Exercise + Verify
+    expect(throws<hal::argument_out_of_domain>(
+      [&]() { codes_to_microvolts(codes, 3'300'000, short_volts); }));
+    expect(throws<hal::argument_out_of_domain>(
+      [&]() { codes_to_millivolts(codes, 3'300'000, short_volts); }));
+    expect(throws<hal::argument_out_of_domain>(
+      [&]() { codes_to_fractions(codes, short_fractions); }));
+    expect(throws<hal::argument_out_of_domain>(
+      [&]() { duty_cycles_to_registers(duty_cycles, short_registers); }));
+
+    for (auto const backend : all_backends) {
+      if (bulk_backend_supported(backend)) {
+        continue;
+      }
+      expect(throws<hal::operation_not_supported>([&]() {
+        codes_to_microvolts(codes, 3'300'000, volts, backend);
+      }));
+    }
+  };
+};
+}  // namespace hal::expander
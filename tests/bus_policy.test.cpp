@@ -0,0 +1,199 @@
+// Copyright 2024 Khalil Estell
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <libhal-expander/bus_policy.hpp>
+
+#include <array>
+
+#include <libhal/error.hpp>
+#include <libhal/i2c.hpp>
+
+#include <boost/ut.hpp>
+
+namespace hal::expander {
+namespace {
+// 1 MHz clock that advances m_step us every time it is read
+struct ticking_clock : public hal::steady_clock
+{
+  hal::hertz driver_frequency() override
+  {
+    return 1'000'000.0f;
+  }
+
+  std::uint64_t driver_uptime() override
+  {
+    auto const uptime = m_uptime;
+    m_uptime += m_step;
+    return uptime;
+  }
+
+  std::uint64_t m_uptime = 0;
+  std::uint64_t m_step = 1;
+};
+
+struct flaky_i2c : public hal::i2c
+{
+  void driver_configure(settings const&) override
+  {
+  }
+
+  void driver_transaction(
+    hal::byte p_address,
+    std::span<hal::byte const>,
+    std::span<hal::byte>,
+    hal::function_ref<hal::timeout_function> p_timeout) override
+  {
+    attempts++;
+    if (hang) {
+      while (true) {
+        p_timeout();
+      }
+    }
+    if (failures > 0) {
+      failures--;
+      throw hal::no_such_device(p_address, this);
+    }
+  }
+
+  int attempts = 0;
+  int failures = 0;
+  bool hang = false;
+};
+}  // namespace
+
+boost::ut::suite test_bus_policy = []() {
+  using namespace boost::ut;
+  using namespace std::literals;
+
+  "bus_policy::worst_case_latency()"_test = []() {
+    // Setup
+    constexpr bus_policy policy{ .timeout = 2ms, .retries = 2, .backoff = 1ms };
+
+    // Exercise
+    constexpr auto latency = policy.worst_case_latency();
+
+    // Verify
+    // 3 attempts of 2ms plus backoffs of 1ms and 2ms
+    static_assert(latency == 9ms);
+  };
+
+  "bus_policy backoff stops doubling"_test = []() {
+    // Setup
+    constexpr bus_policy policy{ .timeout = 1ms,
+                                 .retries = 255,
+                                 .backoff = 1ms };
+
+    // Exercise
+    constexpr auto latency = policy.worst_case_latency();
+
+    // Verify
+    static_assert(policy.backoff_delay(3) == 8ms);
+    static_assert(policy.backoff_delay(16) == 65'536ms);
+    static_assert(policy.backoff_delay(200) == 65'536ms);
+    // 256 timeouts, backoffs of 1ms to 32768ms, then 239 backoffs of 65536ms
+    static_assert(latency == 256ms + 65'535ms + 239 * 65'536ms);
+  };
+
+  "bus_guard retries transient failures"_test = []() {
+    // Setup
+    ticking_clock clock;
+    flaky_i2c i2c;
+    i2c.failures = 2;
+    bus_guard guard(clock, { .timeout = 1ms, .retries = 2, .backoff = 10us });
+
+    // Exercise
+    guard.transaction(i2c, 0x10, std::array<hal::byte, 1>{ 0x00 });
+
+    // Verify
+    expect(that % 3 == i2c.attempts);
+    expect(that % 2U == guard.retry_count());
+    expect(that % 0U == guard.failure_count());
+    expect(guard.max_observed_latency() > 0ns);
+  };
+
+  "bus_guard::max_observed_latency() is exact for long latencies"_test = []() {
+    // Setup
+    // Each read of the uptime is ~33.5 s later, past where a float can count
+    // single microseconds.
+    ticking_clock clock;
+    clock.m_step = (1U << 25) + 1;
+    flaky_i2c i2c;
+    bus_guard guard(clock, { .timeout = 1ms, .retries = 0 });
+
+    // Exercise
+    guard.transaction(i2c, 0x10, std::array<hal::byte, 1>{ 0x00 });
+
+    // Verify
+    auto const step = std::chrono::microseconds(clock.m_step);
+    expect(guard.max_observed_latency() >= step);
+    expect(guard.max_observed_latency() % step == 0ns);
+  };
+
+  "bus_guard rethrows once retries are used up"_test = []() {
+    // Setup
+    ticking_clock clock;
+    flaky_i2c i2c;
+    i2c.failures = 5;
+    bus_guard guard(clock, { .timeout = 1ms, .retries = 1, .backoff = 10us });
+
+    // Exercise
+    bool const threw = throws<hal::no_such_device>([&]() {
+      guard.transaction(i2c, 0x10, std::array<hal::byte, 1>{ 0x00 });
+    });
+
+    // Verify
+    expect(threw);
+    expect(that % 2 == i2c.attempts);
+    expect(that % 1U == guard.failure_count());
+  };
+
+  "bus_guard bounds a hung bus"_test = []() {
+    // Setup
+    ticking_clock clock;
+    flaky_i2c i2c;
+    i2c.hang = true;
+    constexpr bus_policy policy{ .timeout = 100us,
+                                 .retries = 1,
+                                 .backoff = 50us };
+    bus_guard guard(clock, policy);
+
+    // Exercise
+    bool const threw = throws<hal::timed_out>([&]() {
+      guard.transaction(i2c, 0x10, std::array<hal::byte, 1>{ 0x00 });
+    });
+
+    // Verify
+    expect(threw);
+    expect(that % 2 == i2c.attempts);
+    expect(guard.max_observed_latency() <= guard.worst_case_latency() + 10us);
+  };
+
+  "bus_guard without a clock is unbounded"_test = []() {
+    // Setup
+    flaky_i2c i2c;
+    i2c.failures = 1;
+    bus_guard guard;
+
+    // Exercise
+    bool const threw = throws<hal::no_such_device>([&]() {
+      guard.transaction(i2c, 0x10, std::array<hal::byte, 1>{ 0x00 });
+    });
+
+    // Verify
+    expect(threw);
+    expect(not guard.bounded());
+    expect(guard.worst_case_latency() == hal::time_duration::max());
+  };
+};
+}  // namespace hal::expander
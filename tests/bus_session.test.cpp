@@ -0,0 +1,171 @@
+// Copyright 2024 Khalil Estell
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <libhal-expander/bus_session.hpp>
+#include <libhal-expander/linux_i2c.hpp>
+#include <libhal-expander/pca9685.hpp>
+#include <libhal-expander/tla2528.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <vector>
+
+#include <libhal/error.hpp>
+
+#include <boost/ut.hpp>
+
+namespace hal::expander {
+namespace {
+struct fake_dev_file : public i2c_dev_file
+{
+  int driver_rdwr(std::span<i2c_dev_message const> p_messages) override
+  {
+    auto& call = calls.emplace_back();
+    for (auto const& msg : p_messages) {
+      if (msg.read) {
+        std::ranges::fill(msg.data, hal::byte{ 0 });
+      }
+      call.push_back(msg.address);
+    }
+    return error;
+  }
+
+  std::vector<std::vector<hal::byte>> calls;
+  int error = 0;
+};
+
+struct counting_sequencer : public i2c_sequencer
+{
+  void driver_begin_sequence() override
+  {
+    begins++;
+  }
+
+  void driver_end_sequence() override
+  {
+    ends++;
+    if (fail) {
+      throw hal::io_error(this);
+    }
+  }
+
+  int begins = 0;
+  int ends = 0;
+  bool fail = false;
+};
+}  // namespace
+
+boost::ut::suite test_bus_session = []() {
+  using namespace boost::ut;
+
+  "bus_session chains several devices into one ioctl"_test = []() {
+    // Setup
+    fake_dev_file file;
+    std::array<hal::byte, 64> batch_buffer{};
+    linux_i2c i2c(file, batch_buffer);
+    pca9685 pwm(i2c, 0x40);
+    tla2528 gpio(i2c);
+    auto pwm0 = pwm.get_pwm_channel<0>();
+    file.calls.clear();
+
+    // Exercise
+    bus_session session(&i2c);
+    auto const chained = session.chained();
+    pwm0.duty_cycle(0.25f);
+    gpio.get_input_bus();
+    session.commit();
+
+    // Verify
+    expect(chained);
+    expect(not session.chained());
+    expect(that % 1U == file.calls.size());
+    // pca9685 write, then the tla2528 command write and read
+    expect(std::vector<hal::byte>{ 0x40, 0x10, 0x10 } == file.calls[0]);
+  };
+
+  "bus_session failure handler resends pca9685 writes"_test = []() {
+    // Setup
+    fake_dev_file file;
+    std::array<hal::byte, 64> batch_buffer{};
+    linux_i2c i2c(file, batch_buffer);
+    pca9685 pwm(i2c, 0x40);
+    auto pwm0 = pwm.get_pwm_channel<0>();
+    int failures = 0;
+    {
+      bus_session session(&i2c, [&]() {
+        failures++;
+        pwm.resync();
+      });
+      pwm0.duty_cycle(0.25f);
+      file.error = ENXIO;
+      expect(throws<hal::no_such_device>([&]() { session.commit(); }));
+    }
+    file.error = 0;
+    file.calls.clear();
+
+    // Exercise
+    pwm0.duty_cycle(0.25f);
+
+    // Verify
+    expect(that % 1 == failures);
+    // MODE1 and MODE2, then channel 0
+    expect(that % 2U == file.calls.size());
+    expect(not pwm.updates_pending());
+  };
+
+  "bus_session without a sequencer"_test = []() {
+    // Setup
+    fake_dev_file file;
+    linux_i2c i2c(file);
+    pca9685 pwm(i2c, 0x40);
+    auto pwm0 = pwm.get_pwm_channel<0>();
+    auto pwm1 = pwm.get_pwm_channel<1>();
+    file.calls.clear();
+
+    // Exercise
+    bus_session session(nullptr);
+    pwm0.duty_cycle(0.25f);
+    pwm1.duty_cycle(0.25f);
+    session.commit();
+
+    // Verify
+    expect(not session.chained());
+    expect(that % 2U == file.calls.size());
+  };
+
+  "bus_session ends once and reports errors through commit()"_test = []() {
+    // Setup
+    counting_sequencer sequencer;
+
+    // Exercise
+    {
+      bus_session outer(&sequencer);
+      bus_session inner(&sequencer);
+      inner.commit();
+      inner.commit();
+    }
+    sequencer.fail = true;
+    bus_session failing(&sequencer);
+
+    // Verify
+    expect(that % 3 == sequencer.begins);
+    expect(that % 2 == sequencer.ends);
+    expect(throws<hal::io_error>([&]() { failing.commit(); }));
+    expect(that % 3 == sequencer.ends);
+    expect(nothrow([&]() { failing.commit(); }));
+    expect(nothrow([&]() { bus_session discarded(&sequencer); }));
+  };
+};
+}  // namespace hal::expander
@@ -0,0 +1,118 @@
+// Copyright 2024 Khalil Estell
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <libhal-expander/coalescing_i2c.hpp>
+
+#include <array>
+#include <vector>
+
+#include <libhal-util/i2c.hpp>
+
+#include <boost/ut.hpp>
+
+#include "helpers.hpp"
+
+namespace hal::expander {
+namespace {
+using test::recording_i2c;
+
+constexpr hal::byte device = 0x40;
+constexpr hal::byte other_device = 0x41;
+}  // namespace
+
+boost::ut::suite test_coalescing_i2c = []() {
+  using namespace boost::ut;
+  using namespace std::literals;
+
+  "coalescing_i2c forwards outside of a batch"_test = []() {
+    // Setup
+    recording_i2c i2c;
+    std::array<hal::byte, 16> buffer{};
+    std::array<hal::byte, 1> devices{ device };
+    coalescing_i2c coalesced(i2c, buffer, devices);
+
+    // Exercise
+    hal::write(coalesced, device, std::array<hal::byte, 3>{ 0x06, 1, 2 });
+    hal::write(coalesced, device, std::array<hal::byte, 3>{ 0x08, 3, 4 });
+
+    // Verify
+    expect(that % 2U == i2c.writes.size());
+  };
+
+  "coalescing_i2c merges contiguous writes"_test = []() {
+    // Setup
+    recording_i2c i2c;
+    std::array<hal::byte, 16> buffer{};
+    std::array<hal::byte, 1> devices{ device };
+    coalescing_i2c coalesced(i2c, buffer, devices);
+
+    // Exercise
+    coalesced.begin_batch();
+    hal::write(coalesced, device, std::array<hal::byte, 3>{ 0x06, 1, 2 });
+    hal::write(coalesced, device, std::array<hal::byte, 3>{ 0x08, 3, 4 });
+    hal::write(coalesced, device, std::array<hal::byte, 2>{ 0x0A, 5 });
+    auto const held = i2c.writes.size();
+    coalesced.end_batch();
+
+    // Verify
+    expect(that % 0U == held);
+    expect(that % 1U == i2c.writes.size());
+    expect(std::vector<hal::byte>{ 0x06, 1, 2, 3, 4, 5 } == i2c.writes[0]);
+  };
+
+  "coalescing_i2c flushes on gaps, reads and other devices"_test = []() {
+    // Setup
+    recording_i2c i2c;
+    std::array<hal::byte, 16> buffer{};
+    std::array<hal::byte, 1> devices{ device };
+    coalescing_i2c coalesced(i2c, buffer, devices);
+    std::array<hal::byte, 1> read_buffer{};
+
+    // Exercise
+    coalesced.begin_batch();
+    hal::write(coalesced, device, std::array<hal::byte, 2>{ 0x06, 1 });
+    hal::write(coalesced, device, std::array<hal::byte, 2>{ 0x09, 2 });
+    hal::write_then_read(
+      coalesced, device, std::array<hal::byte, 1>{ 0x00 }, read_buffer);
+    hal::write(coalesced, device, std::array<hal::byte, 2>{ 0x0A, 3 });
+    hal::write(coalesced, other_device, std::array<hal::byte, 2>{ 0x0B, 4 });
+    coalesced.end_batch();
+
+    // Verify
+    expect(that % 5U == i2c.writes.size());
+    expect(that % 0x06 == i2c.writes[0][0]);
+    expect(that % 0x09 == i2c.writes[1][0]);
+    expect(that % 1U == i2c.read_sizes[2]);
+    expect(that % 0x0A == i2c.writes[3][0]);
+    expect(that % other_device == i2c.addresses[4]);
+  };
+
+  "coalescing_i2c flushes when the buffer is full"_test = []() {
+    // Setup
+    recording_i2c i2c;
+    std::array<hal::byte, 4> buffer{};
+    std::array<hal::byte, 1> devices{ device };
+    coalescing_i2c coalesced(i2c, buffer, devices);
+
+    // Exercise
+    coalesced.begin_batch();
+    hal::write(coalesced, device, std::array<hal::byte, 3>{ 0x06, 1, 2 });
+    hal::write(coalesced, device, std::array<hal::byte, 3>{ 0x08, 3, 4 });
+    coalesced.end_batch();
+
+    // Verify
+    expect(that % 2U == i2c.writes.size());
+  };
+};
+}  // namespace hal::expander
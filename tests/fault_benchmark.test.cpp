@@ -0,0 +1,54 @@
+// Copyright 2024 Khalil Estell
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <libhal-expander/fault_benchmark.hpp>
+
+#include <boost/ut.hpp>
+
+namespace hal::expander {
+boost::ut::suite test_fault_benchmark = []() {
+  using namespace boost::ut;
+  using namespace std::literals;
+
+  "benchmark_under_faults()"_test = []() {
+    // Setup
+    fault_benchmark_settings const settings{
+      .faults = { .nack = 0.05f, .stretch = 0.05f, .max_stretch = 2ms },
+      .policy = { .timeout = 1ms, .retries = 5, .backoff = 10us },
+      .iterations = 200,
+    };
+
+    // Exercise
+    auto const report = benchmark_under_faults(settings);
+    auto const repeated = benchmark_under_faults(settings);
+    auto const quiet = benchmark_under_faults({ .faults = {},
+                                                .iterations = 200 });
+
+    // Verify
+    for (auto const* operation : { &report.pca9685_duty_cycle,
+                                   &report.pca9685_channel_ticks,
+                                   &report.tla2528_adc_reading,
+                                   &report.tla2528_scan }) {
+      expect(that % 200U == operation->samples);
+      expect(operation->p50 <= operation->p99);
+      expect(operation->p99 <= operation->max);
+    }
+    expect(report.injected[static_cast<std::size_t>(i2c_fault::nack)] > 0U);
+    expect(report.retries > 0U);
+    expect(report.tla2528_scan.max == repeated.tla2528_scan.max);
+    expect(report.tla2528_scan.max > quiet.tla2528_scan.max);
+    expect(that % 0U == quiet.retries);
+  };
+};
+}  // namespace hal::expander
@@ -0,0 +1,107 @@
+// Copyright 2024 Khalil Estell
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <libhal-expander/fault_injector.hpp>
+
+#include <array>
+#include <bit>
+
+#include <libhal-expander/bus_policy.hpp>
+#include <libhal-expander/pca9685.hpp>
+#include <libhal-expander/tla2528.hpp>
+
+#include <libhal/error.hpp>
+
+#include <boost/ut.hpp>
+
+#include "helpers.hpp"
+
+namespace hal::expander {
+boost::ut::suite test_fault_injector = []() {
+  using namespace boost::ut;
+  using namespace std::literals;
+
+  "fault_injector::script()"_test = []() {
+    // Setup
+    test::tla2528_bench bench;
+    auto& [clock, bus, device] = bench;
+    fault_injector i2c(bus, clock);
+    device.set_analog_input(0, 0x800);
+    std::array const faults{
+      fault{ .kind = i2c_fault::nack },
+      fault{ .kind = i2c_fault::arbitration_lost },
+      fault{ .kind = i2c_fault::stretch, .stretch = 2ms },
+    };
+    i2c.script(faults);
+    std::array<hal::byte, 2> data{};
+    std::array<hal::byte, 1> const command{ 0x10 };
+
+    // Exercise & Verify
+    expect(throws<hal::no_such_device>(
+      [&]() { i2c.transaction(0x10, command, data, hal::never_timeout()); }));
+    expect(throws<hal::resource_unavailable_try_again>(
+      [&]() { i2c.transaction(0x10, command, data, hal::never_timeout()); }));
+    auto const start = clock.now();
+    i2c.transaction(0x10, command, data, hal::never_timeout());
+    expect(clock.now() - start >= 2ms);
+    expect(that % 0x80 == data[0]);
+    expect(that % 1U == i2c.injected(i2c_fault::stretch));
+    expect(that % 3U == i2c.transaction_count());
+  };
+
+  "fault_injector corrupts a single read bit"_test = []() {
+    // Setup
+    test::tla2528_bench bench;
+    auto& [clock, bus, device] = bench;
+    fault_injector i2c(bus, clock, 1234);
+    i2c.randomize({ .corrupt_read = 1.0f });
+    std::array<hal::byte, 2> data{};
+
+    // Exercise
+    i2c.transaction(0x10, {}, data, hal::never_timeout());
+
+    // Verify
+    // The conversion result is 0, so only the flipped bit is set
+    expect(that % 1 == std::popcount(data[0]) + std::popcount(data[1]));
+  };
+
+  "bus_policy recovers from random faults"_test = []() {
+    // Setup
+    test::pca9685_bench bench;
+    auto& [clock, bus, device] = bench;
+    fault_injector i2c(bus, clock, 42);
+    pca9685 driver(i2c, 0x40);
+    driver.set_bus_policy(clock,
+                          { .timeout = 1ms, .retries = 5, .backoff = 10us });
+    i2c.randomize({ .nack = 0.1f, .stretch = 0.1f, .max_stretch = 2ms });
+    auto pwm0 = driver.get_pwm_channel<0>();
+    float duty_cycle = 0.0f;
+
+    // Exercise
+    auto const report = measure_latency(clock, 200, [&]() {
+      duty_cycle = duty_cycle > 0.5f ? 0.0f : duty_cycle + 0.01f;
+      pwm0.duty_cycle(duty_cycle);
+    });
+
+    // Verify
+    expect(that % 200U == report.samples);
+    expect(that % 0U == report.failures);
+    expect(report.p50 <= report.p99);
+    expect(report.p99 <= report.max);
+    expect(report.max > 1ms);
+    expect(i2c.injected(i2c_fault::nack) > 0U);
+    expect(driver.bus().retry_count() > 0U);
+  };
+};
+}  // namespace hal::expander
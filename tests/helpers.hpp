@@ -0,0 +1,131 @@
+// Copyright 2024 Khalil Estell
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <span>
+#include <vector>
+
+#include <libhal/error.hpp>
+#include <libhal/i2c.hpp>
+#include <libhal/units.hpp>
+
+#include <libhal-expander/simulation.hpp>
+
+// Fixtures shared by the driver tests
+namespace hal::expander::test {
+/**
+ * @brief i2c bus that records every transaction and reads back zeros
+ *
+ */
+struct recording_i2c : public hal::i2c
+{
+  void driver_configure(settings const&) override
+  {
+  }
+
+  void driver_transaction(
+    hal::byte p_address,
+    std::span<hal::byte const> p_data_out,
+    std::span<hal::byte> p_data_in,
+    hal::function_ref<hal::timeout_function>) override
+  {
+    if (fail_next) {
+      fail_next = false;
+      throw hal::no_such_device(p_address, this);
+    }
+    address = p_address;
+    addresses.push_back(p_address);
+    writes.emplace_back(p_data_out.begin(), p_data_out.end());
+    read_sizes.push_back(p_data_in.size());
+    if (!p_data_in.empty()) {
+      reads++;
+    }
+    std::fill(p_data_in.begin(), p_data_in.end(), hal::byte{ 0 });
+  }
+
+  /// Make the next transaction fail with hal::no_such_device
+  bool fail_next = false;
+  /// Address of the most recent transaction
+  hal::byte address = 0;
+  /// Number of transactions that read
+  int reads = 0;
+  // One entry per transaction
+  std::vector<hal::byte> addresses;
+  std::vector<std::vector<hal::byte>> writes;
+  std::vector<std::size_t> read_sizes;
+};
+
+/// Address simulated devices are attached at by the benches below
+constexpr hal::byte pca9685_address = 0x40;
+constexpr hal::byte tla2528_address = 0x10;
+
+/**
+ * @brief simulated_i2c bus with a simulated_tla2528 attached
+ *
+ */
+struct tla2528_bench
+{
+  explicit tla2528_bench(
+    hal::time_duration p_read_cost = hal::time_duration(100))
+    : clock(p_read_cost)
+  {
+    i2c.attach(tla2528_address, device);
+  }
+
+  simulated_clock clock;
+  simulated_i2c i2c{ clock };
+  simulated_tla2528 device{};
+};
+
+/**
+ * @brief simulated_i2c bus with a simulated_pca9685 attached
+ *
+ */
+struct pca9685_bench
+{
+  explicit pca9685_bench(
+    hal::time_duration p_read_cost = hal::time_duration(100))
+    : clock(p_read_cost)
+  {
+    i2c.attach(pca9685_address, device);
+  }
+
+  simulated_clock clock;
+  simulated_i2c i2c{ clock };
+  simulated_pca9685 device{};
+};
+
+/**
+ * @brief simulated_i2c bus with both a simulated_pca9685 and a
+ * simulated_tla2528 attached
+ *
+ */
+struct board_bench
+{
+  explicit board_bench(hal::time_duration p_read_cost = hal::time_duration(100))
+    : clock(p_read_cost)
+  {
+    i2c.attach(pca9685_address, pca9685_device);
+    i2c.attach(tla2528_address, tla2528_device);
+  }
+
+  simulated_clock clock;
+  simulated_i2c i2c{ clock };
+  simulated_pca9685 pca9685_device{};
+  simulated_tla2528 tla2528_device{};
+};
+}  // namespace hal::expander::test
@@ -0,0 +1,142 @@
+// Copyright 2024 Khalil Estell
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <libhal-expander/linearization.hpp>
+#include <libhal-expander/simulation.hpp>
+#include <libhal-expander/tla2528_adapters.hpp>
+
+#include <cmath>
+#include <cstdlib>
+
+#include <boost/ut.hpp>
+
+#include "helpers.hpp"
+
+namespace hal::expander {
+namespace {
+// 10k NTC with a Beta of 3950 on the low side of a 10k divider
+double reference_celsius(std::uint16_t p_code)
+{
+  auto const ratio = p_code / 4096.0;
+  auto const resistance = 10'000.0 * ratio / (1.0 - ratio);
+  auto const inverse_kelvin =
+    1.0 / 298.15 + std::log(resistance / 10'000.0) / 3950.0;
+  return 1.0 / inverse_kelvin - 273.15;
+}
+
+constexpr auto beta_table = make_linearization_table<128>(ntc_beta{});
+}  // namespace
+
+boost::ut::suite test_linearization = []() {
+  using namespace boost::ut;
+
+  "linearization_detail::log()"_test = []() {
+    static_assert(linearization_detail::log(1.0) == 0.0);
+
+    for (double const value : { 1e-6, 0.3, 2.718281828, 10.0, 1e6 }) {
+      expect(std::abs(linearization_detail::log(value) - std::log(value)) <
+             1e-12);
+    }
+  };
+
+  "ntc_beta table matches the Beta equation"_test = []() {
+    // A 10k divider reads half scale at the nominal temperature
+    static_assert(beta_table(2048) == 25'000);
+
+    // Between roughly -40C and 90C the table is within 0.05C
+    for (std::uint16_t code = 400; code < 3900; code += 37) {
+      auto const expected = reference_celsius(code) * 1000.0;
+      expect(std::abs(beta_table(code) - expected) < 50.0) << code;
+    }
+    expect(beta_table(4095) == beta_table(5000));
+  };
+
+  "ntc_steinhart_hart table"_test = []() {
+    // Setup
+    constexpr double a = 1.009249522e-3;
+    constexpr double b = 2.378405444e-4;
+    constexpr double c = 2.019202697e-7;
+    constexpr auto table = make_linearization_table<64>(
+      ntc_steinhart_hart{ .a = a, .b = b, .c = c });
+    // Half scale of a 10k divider is 10k ohms
+    auto const ln_r = std::log(10'000.0);
+    auto const expected =
+      (1.0 / (a + b * ln_r + c * ln_r * ln_r * ln_r) - 273.15) * 1000.0;
+
+    // Verify
+    expect(std::abs(table(2048) - expected) < 1.0);
+    expect(table(3000) < table(2048));
+  };
+
+  "point_list table"_test = []() {
+    // Setup
+    constexpr auto table = make_linearization_table<16>(point_list<3>{ {
+      linearization_point{ .code = 0, .value = -10.0 },
+      linearization_point{ .code = 2048, .value = 0.0 },
+      linearization_point{ .code = 4096, .value = 40.0 },
+    } });
+
+    // Verify
+    expect(that % -10'000 == table(0));
+    expect(that % -5'000 == table(1024));
+    expect(that % 0 == table(2048));
+    expect(that % 20'000 == table(3072));
+  };
+
+  "tla2528_sensor::read()"_test = []() {
+    // Setup
+    test::tla2528_bench bench;
+    auto& [clock, i2c, device] = bench;
+    tla2528 driver(i2c);
+    driver.set_pin_mode(tla2528::pin_mode::adc, 5);
+    tla2528_sensor temperature(driver, 5, beta_table);
+    device.set_analog_input(5, 2048);
+
+    // Exercise
+    auto const milli_celsius = temperature.read();
+
+    // Verify
+    expect(that % 25'000 == milli_celsius);
+    expect(throws<hal::argument_out_of_domain>(
+      [&]() { tla2528_sensor(driver, 8, beta_table); }));
+  };
+
+  "tla2528_sensor reserves its channel"_test = []() {
+    // Setup
+    test::tla2528_bench bench;
+    auto& [clock, i2c, device] = bench;
+    tla2528 driver(i2c);
+    driver.set_pin_mode(tla2528::pin_mode::output_pin_push_pull, 3);
+    device.set_analog_input(3, 2048);
+
+    // Exercise
+    {
+      tla2528_sensor temperature(driver, 3, beta_table);
+
+      // Verify
+      expect(that % 25'000 == temperature.read());
+      expect(throws<hal::resource_unavailable_try_again>(
+        [&]() { make_adc(driver, 3); }));
+      expect(throws<hal::resource_unavailable_try_again>(
+        [&]() { tla2528_sensor(driver, 3, beta_table); }));
+      expect(throws<hal::resource_unavailable_try_again>([&]() {
+        driver.set_pin_mode(tla2528::pin_mode::input_pin, 3);
+      }));
+    }
+    auto adc = make_adc(driver, 3);
+    expect(throws<hal::resource_unavailable_try_again>(
+      [&]() { tla2528_sensor(driver, 3, beta_table); }));
+  };
+};
+}  // namespace hal::expander
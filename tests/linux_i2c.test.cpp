@@ -0,0 +1,207 @@
+// Copyright 2024 Khalil Estell
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <libhal-expander/linux_i2c.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <vector>
+
+#include <libhal-util/i2c.hpp>
+#include <libhal/error.hpp>
+
+#include <boost/ut.hpp>
+
+namespace hal::expander {
+namespace {
+struct fake_dev_file : public i2c_dev_file
+{
+  struct message
+  {
+    hal::byte address;
+    bool read;
+    std::vector<hal::byte> data;
+  };
+
+  int driver_rdwr(std::span<i2c_dev_message const> p_messages) override
+  {
+    auto& call = calls.emplace_back();
+    bool nacked = false;
+    for (auto const& msg : p_messages) {
+      if (msg.read) {
+        std::ranges::fill(msg.data, read_value);
+      }
+      call.push_back(
+        { msg.address, msg.read, { msg.data.begin(), msg.data.end() } });
+      nacked = nacked || msg.address == absent_address;
+    }
+    return nacked ? ENXIO : error;
+  }
+
+  std::vector<std::vector<message>> calls;
+  hal::byte read_value = 0xA5;
+  int error = 0;
+  // Messages to this address are not acknowledged
+  hal::byte absent_address = 0;
+};
+}  // namespace
+
+boost::ut::suite test_linux_i2c = []() {
+  using namespace boost::ut;
+  using namespace std::literals;
+
+  "linux_i2c write_then_read is one combined transaction"_test = []() {
+    // Setup
+    fake_dev_file file;
+    linux_i2c i2c(file);
+    std::array<hal::byte, 2> data{};
+
+    // Exercise
+    hal::write_then_read(i2c, 0x10, std::array<hal::byte, 1>{ 0x11 }, data);
+
+    // Verify
+    expect(that % 1U == file.calls.size());
+    expect(that % 2U == file.calls[0].size());
+    expect(not file.calls[0][0].read);
+    expect(file.calls[0][1].read);
+    expect(that % 0xA5 == data[1]);
+  };
+
+  "linux_i2c batches writes into one ioctl"_test = []() {
+    // Setup
+    fake_dev_file file;
+    std::array<hal::byte, 32> buffer{};
+    linux_i2c i2c(file, buffer);
+
+    // Exercise
+    i2c.begin_batch();
+    hal::write(i2c, 0x40, std::array<hal::byte, 5>{ 0x06, 0, 0, 1, 0 });
+    hal::write(i2c, 0x40, std::array<hal::byte, 5>{ 0x0A, 0, 0, 2, 0 });
+    hal::write(i2c, 0x41, std::array<hal::byte, 5>{ 0x06, 0, 0, 3, 0 });
+    auto const calls_before_end = file.calls.size();
+    i2c.end_batch();
+
+    // Verify
+    expect(that % 0U == calls_before_end);
+    expect(that % 1U == file.calls.size());
+    expect(that % 3U == file.calls[0].size());
+    expect(that % 0x41 == file.calls[0][2].address);
+    expect(that % 3 == file.calls[0][2].data[3]);
+    expect(that % 1U == i2c.syscall_count());
+  };
+
+  "linux_i2c submits queued writes with the next read"_test = []() {
+    // Setup
+    fake_dev_file file;
+    std::array<hal::byte, 32> buffer{};
+    linux_i2c i2c(file, buffer);
+    std::array<hal::byte, 2> data{};
+
+    // Exercise
+    i2c.begin_batch();
+    hal::write(i2c, 0x10, std::array<hal::byte, 3>{ 0x08, 0x11, 0x03 });
+    hal::write_then_read(i2c, 0x10, std::array<hal::byte, 1>{ 0x10 }, data);
+    i2c.end_batch();
+
+    // Verify
+    expect(that % 1U == file.calls.size());
+    expect(that % 3U == file.calls[0].size());
+  };
+
+  "linux_i2c::queue_read() defers a whole scan"_test = []() {
+    // Setup
+    fake_dev_file file;
+    linux_i2c i2c(file);
+    std::array<std::array<hal::byte, 2>, 8> results{};
+    std::array<hal::byte, 1> command{ 0x10 };
+
+    // Exercise
+    for (auto& result : results) {
+      i2c.queue_read(0x10, command, result);
+    }
+    auto const queued = i2c.queued();
+    i2c.submit();
+
+    // Verify
+    expect(that % 16U == queued);
+    expect(that % 1U == file.calls.size());
+    expect(that % 0xA5 == results[7][0]);
+  };
+
+  "linux_i2c splits batches at the kernel message limit"_test = []() {
+    // Setup
+    fake_dev_file file;
+    std::array<hal::byte, 256> buffer{};
+    linux_i2c i2c(file, buffer);
+
+    // Exercise
+    i2c.begin_batch();
+    for (std::size_t i = 0; i < linux_i2c::max_messages + 1; i++) {
+      hal::write(i2c, 0x40, std::array<hal::byte, 2>{ 0x06, 0 });
+    }
+    i2c.end_batch();
+
+    // Verify
+    expect(that % 2U == file.calls.size());
+    expect(that % linux_i2c::max_messages == file.calls[0].size());
+  };
+
+  "linux_i2c maps errno values to libhal exceptions"_test = []() {
+    // Setup
+    fake_dev_file file;
+    linux_i2c i2c(file);
+    auto const write = [&i2c]() {
+      hal::write(i2c, 0x10, std::array<hal::byte, 1>{ 0 });
+    };
+
+    // Exercise + Verify
+    file.error = ENXIO;
+    expect(throws<hal::no_such_device>(write));
+    file.error = ETIMEDOUT;
+    expect(throws<hal::timed_out>(write));
+    file.error = EAGAIN;
+    expect(throws<hal::resource_unavailable_try_again>(write));
+    file.error = EIO;
+    expect(throws<hal::io_error>(write));
+  };
+
+  "linux_i2c reports the device that did not acknowledge"_test = []() {
+    // Setup
+    fake_dev_file file;
+    std::array<hal::byte, 16> buffer{};
+    linux_i2c i2c(file, buffer);
+    file.absent_address = 0x41;
+    hal::byte reported = 0;
+
+    // Exercise
+    try {
+      i2c.begin_batch();
+      hal::write(i2c, 0x40, std::array<hal::byte, 1>{ 0 });
+      hal::write(i2c, 0x40, std::array<hal::byte, 1>{ 1 });
+      hal::write(i2c, 0x41, std::array<hal::byte, 1>{ 2 });
+      i2c.end_batch();
+    } catch (hal::no_such_device const& p_error) {
+      reported = static_cast<hal::byte>(p_error.address);
+    }
+
+    // Verify
+    // The batch, then one probe each of 0x40 and 0x41
+    expect(that % 0x41 == reported);
+    expect(that % 3U == file.calls.size());
+    expect(that % 0U == file.calls[1][0].data.size());
+    expect(that % 0x41 == file.calls[2][0].address);
+  };
+};
+}  // namespace hal::expander
@@ -0,0 +1,156 @@
+// Copyright 2024 Khalil Estell
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <libhal-expander/multi_bus_engine.hpp>
+#include <libhal-expander/snapshot_buffer.hpp>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#if defined(__linux__)
+#include <sched.h>
+#endif
+
+#include <libhal/error.hpp>
+
+#include <boost/ut.hpp>
+
+namespace hal::expander {
+#if defined(__linux__)
+namespace {
+struct null_i2c : public hal::i2c
+{
+  void driver_configure(settings const&) override
+  {
+  }
+
+  void driver_transaction(hal::byte,
+                          std::span<hal::byte const>,
+                          std::span<hal::byte>,
+                          hal::function_ref<hal::timeout_function>) override
+  {
+  }
+};
+}  // namespace
+#endif
+
+boost::ut::suite test_multi_bus_engine = []() {
+  using namespace boost::ut;
+  using namespace std::literals;
+
+  "snapshot_buffer::read() returns the last published value"_test = []() {
+    // Setup
+    snapshot_buffer<std::array<int, 4>> snapshot;
+
+    // Exercise
+    auto const initial = snapshot.read();
+    snapshot.publish({ 1, 2, 3, 4 });
+    snapshot.publish({ 5, 6, 7, 8 });
+
+    // Verify
+    expect(that % 0 == initial[0]);
+    expect(that % 5 == snapshot.read()[0]);
+    expect(that % 2U == snapshot.version());
+  };
+
+  "snapshot_buffer::read() never observes a torn value"_test = []() {
+    // Setup
+    snapshot_buffer<std::array<std::uint32_t, 16>> snapshot;
+    std::atomic<bool> done = false;
+    std::thread producer([&]() {
+      for (std::uint32_t i = 1; i < 20'000; i++) {
+        std::array<std::uint32_t, 16> frame;
+        frame.fill(i);
+        snapshot.publish(frame);
+      }
+      done = true;
+    });
+
+    // Exercise
+    bool torn = false;
+    while (!done) {
+      auto const frame = snapshot.read();
+      for (auto const value : frame) {
+        torn = torn || value != frame[0];
+      }
+    }
+    producer.join();
+
+    // Verify
+    expect(not torn);
+  };
+
+#if defined(__linux__)
+  "multi_bus_engine runs each bus on its own worker"_test = []() {
+    // Setup
+    null_i2c bus0;
+    null_i2c bus1;
+    null_i2c idle_bus;
+    std::atomic<std::thread::id> bus0_thread{};
+    std::atomic<std::thread::id> bus1_thread{};
+    snapshot_buffer<int> result;
+    multi_bus_engine engine;
+    engine.add_job(bus0,
+                   [&]() { bus0_thread = std::this_thread::get_id(); });
+    engine.add_job(bus0, [&]() { throw 5; });
+    engine.add_job(bus1, [&]() {
+      bus1_thread = std::this_thread::get_id();
+      result.publish(42);
+    });
+    engine.configure_bus(idle_bus, { .cpu = 0 });
+
+    // Exercise
+    engine.start();
+    while (engine.cycles(bus0) < 3 || engine.cycles(bus1) < 3) {
+      std::this_thread::yield();
+    }
+    engine.stop();
+
+    // Verify
+    expect(that % 3U == engine.bus_count());
+    expect(that % 0U == engine.cycles(idle_bus));
+    expect(bus0_thread.load() != bus1_thread.load());
+    expect(bus0_thread.load() != std::this_thread::get_id());
+    expect(engine.errors(bus0) >= 3U);
+    expect(that % 0U == engine.errors(bus1));
+    expect(that % 42 == result.read());
+    expect(not engine.running());
+  };
+
+  "multi_bus_engine::stop() does not wait out the period"_test = []() {
+    // Setup
+    null_i2c bus;
+    multi_bus_engine engine;
+    engine.configure_bus(bus, { .period = 1h });
+    engine.add_job(bus, []() {});
+    engine.start();
+    while (engine.cycles(bus) < 1) {
+      std::this_thread::yield();
+    }
+    auto const start = std::chrono::steady_clock::now();
+
+    // Exercise
+    engine.stop();
+
+    // Verify
+    expect(std::chrono::steady_clock::now() - start < 10s);
+    expect(that % 1U == engine.cycles(bus));
+    expect(throws<hal::argument_out_of_domain>(
+      [&]() { engine.configure_bus(bus, { .cpu = CPU_SETSIZE }); }));
+  };
+#endif
+};
+}  // namespace hal::expander
@@ -12,19 +12,391 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <libhal-expander/basic_pca9685.hpp>
+#include <libhal-expander/fault_injector.hpp>
 #include <libhal-expander/pca9685.hpp>
+#include <libhal-expander/simulation.hpp>
+
+#include <array>
+#include <vector>
 
 #include <boost/ut.hpp>
 
+#include "helpers.hpp"
+
 namespace hal::expander {
+namespace {
+using test::recording_i2c;
+
+// Bus type unrelated to hal::i2c, only usable with the basic_ drivers
+struct recording_bus
+{
+  void transaction(hal::byte,
+                   std::span<hal::byte const> p_data_out,
+                   std::span<hal::byte>,
+                   hal::function_ref<hal::timeout_function>)
+  {
+    writes.emplace_back(p_data_out.begin(), p_data_out.end());
+  }
+
+  std::vector<std::vector<hal::byte>> writes;
+};
+}  // namespace
+
 boost::ut::suite test_pca9685 = []() {
   using namespace boost::ut;
   using namespace std::literals;
 
   "pca9685::pca9685()"_test = []() {
     // Setup
+    recording_i2c i2c;
+
+    // Exercise
+    pca9685 driver(i2c, 0b100'0000);
+
+    // Verify
+    expect(that % 0b100'0000 == i2c.address);
+    expect(that % 1U == i2c.writes.size());
+    expect(std::vector<hal::byte>{ 0x00, 0b0010'0000, 0b0000'0100 } ==
+           i2c.writes[0]);
+  };
+
+  "pca9685::pwm_channel::duty_cycle()"_test = []() {
+    // Setup
+    recording_i2c i2c;
+    pca9685 driver(i2c, 0b100'0000);
+    auto pwm1 = driver.get_pwm_channel<1>();
+    i2c.writes.clear();
+
+    // Exercise
+    pwm1.duty_cycle(0.5f);
+    pwm1.duty_cycle(0.5f);
+
+    // Verify
+    expect(that % 1U == i2c.writes.size());
+    expect(std::vector<hal::byte>{ 0x0A, 0x00, 0x00, 0x00, 0x08 } ==
+           i2c.writes[0]);
+  };
+
+  "pca9685::pwm_channel::duty_cycle() only sends changed bytes"_test = []() {
+    // Setup
+    recording_i2c i2c;
+    pca9685 driver(i2c, 0b100'0000);
+    auto pwm0 = driver.get_pwm_channel<0>();
+    pwm0.duty_cycle(0.0f);
+    i2c.writes.clear();
+
+    // Exercise
+    pwm0.duty_cycle(1.0f);
+
+    // Verify
+    expect(that % 1U == i2c.writes.size());
+    expect(std::vector<hal::byte>{ 0x08, 0xFF, 0x0F } == i2c.writes[0]);
+  };
+
+  "pca9685::pwm16_channel::duty_cycle()"_test = []() {
+    // Setup
+    recording_i2c i2c;
+    pca9685 driver(i2c, 0b100'0000);
+    auto pwm1 = driver.get_pwm16_channel<1>();
+    auto pwm2 = driver.get_pwm16_channel<2>();
+    i2c.writes.clear();
+
+    // Exercise
+    pwm1.duty_cycle(0x8000);
+    pwm2.duty_cycle(0xFFFF);
+    pwm2.duty_cycle(0);
+
+    // Verify
+    expect(that % 3U == i2c.writes.size());
+    expect(std::vector<hal::byte>{ 0x0A, 0x00, 0x00, 0x00, 0x08 } ==
+           i2c.writes[0]);
+    expect(std::vector<hal::byte>{ 0x0E, 0x00, 0x10, 0x00, 0x00 } ==
+           i2c.writes[1]);
+    expect(std::vector<hal::byte>{ 0x0F, 0x00, 0x00, 0x10 } == i2c.writes[2]);
+    expect(that % 0 == pca9685_registers::duty_cycle_ticks(8));
+    expect(that % 1 == pca9685_registers::duty_cycle_ticks(9));
+    expect(that % 4094 == pca9685_registers::duty_cycle_ticks(0xFFF0));
+    expect(that % 4095 == pca9685_registers::duty_cycle_ticks(0xFFFE));
+    static_assert(pca9685_registers::duty_cycle_edges(8).off_tick == 0x1000);
+    static_assert(pca9685_registers::duty_cycle_edges(9).off_tick == 1);
+  };
+
+  "pca9685::pwm_group_manager::frequency()"_test = []() {
+    // Setup
+    recording_i2c i2c;
+    pca9685 driver(i2c, 0b100'0000);
+    auto group = driver.get_pwm_group_manager();
+    auto pwm0 = driver.get_pwm16_channel<0>();
+    auto const power_on_frequency = pwm0.frequency();
+    i2c.writes.clear();
+
     // Exercise
+    group.frequency(1000);
+
+    // Verify
+    expect(that % 197U == power_on_frequency);
+    expect(that % 1017U == pwm0.frequency());
+    expect(that % 3U == i2c.writes.size());
+    expect(std::vector<hal::byte>{ 0xFE, 0x05 } == i2c.writes[1]);
+    expect(that % pca9685_registers::prescale(1000.0f) ==
+           pca9685_registers::prescale_hz(1000));
+    expect(throws<hal::argument_out_of_domain>(
+      [&]() { group.frequency(24); }));
+    expect(throws<hal::argument_out_of_domain>(
+      [&]() { group.frequency(1526); }));
+    expect(that % 1017U == pwm0.frequency());
+  };
+
+  "pca9685::set_channel_ticks()"_test = []() {
+    // Setup
+    recording_i2c i2c;
+    pca9685 driver(i2c, 0b100'0000);
+    std::array<std::uint16_t, 3> const ticks{ 1, 0x123, 5000 };
+    i2c.writes.clear();
+
+    // Exercise
+    driver.set_channel_ticks(ticks, 13);
+
+    // Verify
+    expect(that % 1U == i2c.writes.size());
+    expect(std::vector<hal::byte>{ 0x3A, 0x00, 0x00, 0x01, 0x00,
+                                   0x00, 0x00, 0x23, 0x01,
+                                   0x00, 0x00, 0xFF, 0x0F } == i2c.writes[0]);
+    expect(throws<hal::argument_out_of_domain>(
+      [&]() { driver.set_channel_ticks(ticks, 14); }));
+  };
+
+  "pca9685::defer_updates() writes at most once per PWM period"_test = []() {
+    // Setup
+    using namespace std::chrono_literals;
+    recording_i2c i2c;
+    simulated_clock clock(0ns);
+    pca9685 driver(i2c, 0b100'0000);
+    auto pwm0 = driver.get_pwm_channel<0>();
+    auto pwm1 = driver.get_pwm_channel<1>();
+    driver.defer_updates(clock);
+    i2c.writes.clear();
+
+    // Exercise
+    pwm0.duty_cycle(0.25f);
+    pwm0.duty_cycle(0.5f);
+    pwm0.duty_cycle(0.75f);
+    pwm1.duty_cycle(0.1f);
+    bool const early = driver.service();
+
+    // Verify
+    // The first update is written right away, the rest are held
+    expect(that % 1U == i2c.writes.size());
+    expect(not early);
+    expect(driver.updates_pending());
+    // Power on prescale of 30: 31 * 4096 * 40 ns
+    expect(5'079'040ns == driver.pwm_period());
+
+    // Exercise
+    clock.advance(driver.pwm_period() - 1ns);
+    bool const before_period = driver.service();
+    clock.advance(1ns);
+    bool const after_period = driver.service();
+
+    // Verify
+    expect(not before_period);
+    expect(after_period);
+    expect(not driver.updates_pending());
+    expect(that % 2U == i2c.writes.size());
+    // Only the last value of channel 0 and the value of channel 1, in one
+    // burst
+    expect(std::vector<hal::byte>{ 0x08, 0xFF, 0x0B, 0x00, 0x00, 0x9A, 0x01 } ==
+           i2c.writes[1]);
+    expect(not driver.service());
+  };
+
+  "pca9685::flush_now() and write_through()"_test = []() {
+    // Setup
+    using namespace std::chrono_literals;
+    recording_i2c i2c;
+    simulated_clock clock(0ns);
+    pca9685 driver(i2c, 0b100'0000);
+    auto pwm0 = driver.get_pwm_channel<0>();
+    driver.defer_updates(clock);
+    pwm0.duty_cycle(0.25f);
+    pwm0.duty_cycle(0.5f);
+    i2c.writes.clear();
+
+    // Exercise
+    driver.flush_now();
+
+    // Verify
+    expect(that % 1U == i2c.writes.size());
+    expect(not driver.updates_pending());
+
+    // Exercise
+    pwm0.duty_cycle(0.75f);
+    driver.write_through();
+    pwm0.duty_cycle(1.0f);
+
+    // Verify
+    // Leaving deferred mode writes the held update and later updates are
+    // written right away
+    expect(that % 3U == i2c.writes.size());
+    expect(not driver.updates_pending());
+  };
+
+  "pca9685::defer_updates() holds off update on acknowledge"_test = []() {
+    // Setup
+    using namespace std::chrono_literals;
+    test::pca9685_bench bench(0ns);
+    auto& [clock, i2c, device] = bench;
+    constexpr hal::byte mode2 = 0x01;
+    constexpr hal::byte och = 1 << 3;
+    pca9685::settings const settings{ .output_changes_on_i2c_acknowledge =
+                                        true };
+    pca9685 driver(i2c, test::pca9685_address, settings);
+    expect(that % och == (device.register_value(mode2) & och));
+
+    // Exercise
+    driver.defer_updates(clock);
+    auto const deferred_mode2 = device.register_value(mode2);
+    driver.configure(settings);
+    auto const reconfigured_mode2 = device.register_value(mode2);
+    driver.write_through();
+
+    // Verify
+    expect(that % 0 == (deferred_mode2 & och));
+    expect(that % 0 == (reconfigured_mode2 & och));
+    expect(that % och == (device.register_value(mode2) & och));
+  };
+
+  "pca9685 writes whole channels with update on acknowledge"_test = []() {
+    // Setup
+    using namespace std::chrono_literals;
+    test::pca9685_bench bench(0ns);
+    auto& [clock, i2c, device] = bench;
+    pca9685 driver(i2c,
+                   test::pca9685_address,
+                   pca9685::settings{ .output_changes_on_i2c_acknowledge =
+                                        true });
+    auto pwm0 = driver.get_pwm_channel<0>();
+    pwm0.duty_cycle(0.5f);
+    auto const first_output = device.output_off_ticks(0);
+
+    // Exercise
+    pwm0.duty_cycle(0.25f);
+
+    // Verify
+    expect(that % 2048 == first_output);
+    expect(that % 1024 == device.off_ticks(0));
+    expect(that % 1024 == device.output_off_ticks(0));
+  };
+
+  "pca9685::pwm_period() follows the prescale"_test = []() {
+    // Setup
+    using namespace std::chrono_literals;
+    recording_i2c i2c;
+    simulated_clock clock(0ns);
+    pca9685 driver(i2c, 0b100'0000);
+    pca9685 restored(i2c, pca9685_state{ .prescale = 5 });
+    auto pwm0 = driver.get_pwm_channel<0>();
+    driver.defer_updates(clock);
+
+    // Exercise
+    pwm0.frequency(1000.0f);
+    pwm0.duty_cycle(0.25f);
+    pwm0.duty_cycle(0.5f);
+    clock.advance(983'040ns);
+
+    // Verify
+    expect(983'040ns == driver.pwm_period());
+    expect(983'040ns == restored.pwm_period());
+    expect(driver.service());
+  };
+
+  "pca9685::write_behind() retries failed writes from service()"_test = []() {
+    // Setup
+    test::pca9685_bench bench;
+    auto& [clock, bus, device] = bench;
+    fault_injector i2c(bus, clock);
+    pca9685 driver(i2c, 0b100'0000);
+    auto pwm2 = driver.get_pwm_channel<2>();
+    auto pwm9 = driver.get_pwm_channel<9>();
+    driver.write_behind(2);
+    auto const transactions = i2c.transaction_count();
+
+    // Exercise
+    pwm2.duty_cycle(0.5f);
+    pwm9.duty_cycle(1.0f);
+
+    // Verify
+    // Updates never reach the bus from the caller
+    expect(that % transactions == i2c.transaction_count());
+    expect(that % 0b0000'0010'0000'0100 == driver.unconfirmed_channels());
+
+    // Exercise
+    // Channel 2 is written, then channel 9 fails on both attempts
+    std::array const faults{
+      fault{},
+      fault{ .kind = i2c_fault::nack },
+      fault{ .kind = i2c_fault::arbitration_lost },
+    };
+    i2c.script(faults);
+    bool const failed_service = driver.service();
+
+    // Verify
+    expect(not failed_service);
+    expect(that % 2U == driver.absorbed_failures());
+    expect(that % 0b0000'0010'0000'0000 == driver.unconfirmed_channels());
+    expect(that % 2048 == device.off_ticks(2));
+
+    // Exercise
+    bool const recovered = driver.service();
+
+    // Verify
+    expect(recovered);
+    expect(that % 0 == driver.unconfirmed_channels());
+    expect(that % 4095 == device.off_ticks(9));
+    expect(not driver.service());
+  };
+
+  "pca9685::write_through() leaves write-behind mode"_test = []() {
+    // Setup
+    test::pca9685_bench bench;
+    auto& [clock, bus, device] = bench;
+    fault_injector i2c(bus, clock);
+    pca9685 driver(i2c, 0b100'0000);
+    auto pwm0 = driver.get_pwm_channel<0>();
+    driver.write_behind();
+    pwm0.duty_cycle(0.25f);
+
+    // Exercise
+    driver.write_through();
+    std::array const faults{ fault{ .kind = i2c_fault::nack } };
+    i2c.script(faults);
+
+    // Verify
+    expect(that % 1024 == device.off_ticks(0));
+    expect(throws<hal::no_such_device>([&]() { pwm0.duty_cycle(0.5f); }));
+    expect(that % 1 == driver.unconfirmed_channels());
+  };
+
+  "basic_pca9685 matches pca9685"_test = []() {
+    // Setup
+    recording_i2c i2c;
+    recording_bus bus;
+    pca9685 erased(i2c, 0b100'0000);
+    basic_pca9685 basic(bus, 0b100'0000);
+    auto erased_pwm3 = erased.get_pwm_channel<3>();
+    auto basic_pwm3 = basic.get_pwm_channel<3>();
+
+    // Exercise
+    erased_pwm3.frequency(1000.0f);
+    erased_pwm3.duty_cycle(0.25f);
+    basic_pwm3.frequency(1000.0f);
+    basic_pwm3.duty_cycle(0.25f);
+
     // Verify
+    expect(i2c.writes == bus.writes);
+    expect(throws<hal::argument_out_of_domain>(
+      [&]() { basic_pwm3.frequency(10.0f); }));
   };
 };
 }  // namespace hal::expander
@@ -0,0 +1,135 @@
+// Copyright 2024 Khalil Estell
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <libhal-expander/pca9685_color_group.hpp>
+
+#include <vector>
+
+#include <boost/ut.hpp>
+
+#include "helpers.hpp"
+
+namespace hal::expander {
+using test::recording_i2c;
+
+boost::ut::suite test_pca9685_color_group = []() {
+  using namespace boost::ut;
+
+  "to_rgb()"_test = []() {
+    static_assert(to_rgb({ .hue = 0 }).red == 255);
+    static_assert(to_rgb({ .hue = 120 }).green == 255);
+    static_assert(to_rgb({ .hue = 240 }).blue == 255);
+    static_assert(to_rgb({ .hue = 360 }).red == 255);
+
+    // Exercise
+    auto const yellow = to_rgb({ .hue = 60 });
+    auto const grey = to_rgb({ .hue = 200, .saturation = 0, .value = 128 });
+    auto const dark = to_rgb({ .hue = 30, .value = 0 });
+
+    // Verify
+    expect(that % 255 == yellow.red);
+    expect(that % 255 == yellow.green);
+    expect(that % 0 == yellow.blue);
+    expect(that % 128 == grey.red);
+    expect(that % 128 == grey.green);
+    expect(that % 128 == grey.blue);
+    expect(that % 0 == dark.red);
+  };
+
+  "make_gamma_table()"_test = []() {
+    // Exercise
+    auto const linear = make_gamma_table(1.0f);
+    auto const gamma = make_gamma_table(2.0f);
+
+    // Verify
+    expect(that % 0 == linear[0]);
+    expect(that % 4095 == linear[255]);
+    expect(that % 4095 == gamma[255]);
+    expect(that % 1032 == gamma[128]);
+  };
+
+  "pca9685_color_group::set(rgb_color) is one burst"_test = []() {
+    // Setup
+    recording_i2c i2c;
+    pca9685 driver(i2c, 0b100'0000);
+    pca9685_color_group fixture(driver, 4, 3, {});
+    i2c.writes.clear();
+
+    // Exercise
+    fixture.set(rgb_color{ .red = 255, .green = 0, .blue = 51 });
+
+    // Verify
+    expect(that % 1U == i2c.writes.size());
+    // Channel 4 ON_L through channel 6 OFF_H
+    expect(std::vector<hal::byte>{ 0x16, 0x00, 0x00, 0xFF, 0x0F,
+                                   0x00, 0x00, 0x00, 0x00,
+                                   0x00, 0x00, 0x33, 0x03 } == i2c.writes[0]);
+  };
+
+  "pca9685_color_group white balance and gamma"_test = []() {
+    // Setup
+    recording_i2c i2c;
+    pca9685 driver(i2c, 0b100'0000);
+    auto const gamma = make_gamma_table(2.0f);
+    pca9685_color_group fixture(
+      driver,
+      0,
+      4,
+      { .white_balance = { 255, 128, 255, 255 }, .gamma = &gamma });
+    i2c.writes.clear();
+
+    // Exercise
+    fixture.set(rgb_color{ .red = 128, .green = 255, .blue = 0, .white = 255 });
+
+    // Verify
+    expect(that % 1U == i2c.writes.size());
+    // Green is balanced down to 128, so red and green both map to gamma[128]
+    expect(std::vector<hal::byte>{ 0x06, 0x00, 0x00, 0x08, 0x04,
+                                   0x00, 0x00, 0x08, 0x04,
+                                   0x00, 0x00, 0x00, 0x00,
+                                   0x00, 0x00, 0xFF, 0x0F } == i2c.writes[0]);
+  };
+
+  "pca9685_color_group extracts white"_test = []() {
+    // Setup
+    recording_i2c i2c;
+    pca9685 driver(i2c, 0b100'0000);
+    pca9685_color_group fixture(driver, 0, 4, { .extract_white = true });
+    i2c.writes.clear();
+
+    // Exercise
+    fixture.set(rgb_color{ .red = 255, .green = 255, .blue = 255 });
+
+    // Verify
+    expect(that % 1U == i2c.writes.size());
+    expect(std::vector<hal::byte>{ 0x06, 0x00, 0x00, 0x00, 0x00,
+                                   0x00, 0x00, 0x00, 0x00,
+                                   0x00, 0x00, 0x00, 0x00,
+                                   0x00, 0x00, 0xFF, 0x0F } == i2c.writes[0]);
+  };
+
+  "pca9685_color_group::pca9685_color_group() validates channels"_test = []() {
+    // Setup
+    recording_i2c i2c;
+    pca9685 driver(i2c, 0b100'0000);
+
+    // Exercise + Verify
+    expect(throws<hal::argument_out_of_domain>(
+      [&]() { pca9685_color_group(driver, 0, 2, {}); }));
+    expect(throws<hal::argument_out_of_domain>(
+      [&]() { pca9685_color_group(driver, 13, 4, {}); }));
+    expect(nothrow([&]() { pca9685_color_group(driver, 12, 4, {}); }));
+  };
+};
+}  // namespace hal::expander
@@ -0,0 +1,134 @@
+// Copyright 2024 Khalil Estell
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <libhal-expander/pca9685_complementary_pair.hpp>
+
+#include <vector>
+
+#include <boost/ut.hpp>
+
+#include "helpers.hpp"
+
+namespace hal::expander {
+using test::recording_i2c;
+
+boost::ut::suite test_pca9685_complementary_pair = []() {
+  using namespace boost::ut;
+  using namespace std::literals;
+
+  "dead_time_ticks()"_test = []() {
+    // 1 kHz with 4096 ticks is ~244ns per tick
+    static_assert(dead_time_ticks(0ns, 1000.0f) == 0);
+    static_assert(dead_time_ticks(244ns, 1000.0f) == 1);
+    static_assert(dead_time_ticks(245ns, 1000.0f) == 2);
+    static_assert(dead_time_ticks(1s, 1000.0f) == 2048);
+  };
+
+  "complementary_edges()"_test = []() {
+    // Setup
+    constexpr auto half = complementary_edges(2048, 10);
+    constexpr auto off = complementary_edges(0, 10);
+    constexpr auto on = complementary_edges(4096, 10);
+    constexpr auto squeezed = complementary_edges(4080, 10);
+
+    // Verify
+    expect(that % 0 == half[0].on_tick);
+    expect(that % 2048 == half[0].off_tick);
+    expect(that % 2058 == half[1].on_tick);
+    expect(that % 4086 == half[1].off_tick);
+
+    expect(that % 0x1000 == off[0].off_tick);
+    expect(that % 10 == off[1].on_tick);
+    expect(that % 4086 == off[1].off_tick);
+
+    expect(that % 0x1000 == on[0].on_tick);
+    expect(that % 0x1000 == on[1].off_tick);
+
+    expect(that % 4080 == squeezed[0].off_tick);
+    expect(that % 0x1000 == squeezed[1].off_tick);
+  };
+
+  "complementary_edges() without dead time"_test = []() {
+    // Setup
+    constexpr auto half = complementary_edges(2048, 0);
+    constexpr auto off = complementary_edges(0, 0);
+    constexpr auto on = complementary_edges(4096, 0);
+
+    // Verify
+    expect(that % 2048 == half[0].off_tick);
+    expect(that % 2048 == half[1].on_tick);
+    expect(that % 0 == half[1].off_tick);
+
+    expect(that % 0x1000 == off[0].off_tick);
+    expect(that % 0x1000 == off[1].on_tick);
+    expect(that % 0 == off[1].off_tick);
+
+    expect(that % 0x1000 == on[0].on_tick);
+    expect(that % 0x1000 == on[1].off_tick);
+  };
+
+  "pca9685_complementary_pair writes both channels in one burst"_test = []() {
+    // Setup
+    recording_i2c i2c;
+    pca9685 driver(i2c, 0b100'0000);
+    pca9685_complementary_pair bridge(driver, 2, 16);
+    i2c.writes.clear();
+
+    // Exercise
+    bridge.duty_cycle(0.25f);
+
+    // Verify
+    expect(that % 1U == i2c.writes.size());
+    // Channel 2 HIGH from 0 to 1024, channel 3 HIGH from 1040 to 4080
+    expect(std::vector<hal::byte>{ 0x0E, 0x00, 0x00, 0x00, 0x04,
+                                   0x10, 0x04, 0xF0, 0x0F } == i2c.writes[0]);
+    expect(throws<hal::argument_out_of_domain>(
+      [&]() { bridge.duty_cycle(1.5f); }));
+  };
+
+  "pca9685_complementary_pair ignores the burst gap"_test = []() {
+    // Setup
+    recording_i2c i2c;
+    pca9685 driver(i2c, 0b100'0000);
+    driver.set_policy(expander_policy{ .pca9685_burst_gap = 0 });
+    pca9685_complementary_pair bridge(driver, 2, 16);
+    bridge.high_side_ticks(1024);
+    i2c.writes.clear();
+
+    // Exercise
+    bridge.high_side_ticks(1040);
+
+    // Verify
+    expect(that % 1U == i2c.writes.size());
+    // Channel 2 HIGH from 0 to 1040, channel 3 HIGH from 1056 to 4080
+    expect(std::vector<hal::byte>{ 0x0E, 0x00, 0x00, 0x10, 0x04,
+                                   0x20, 0x04, 0xF0, 0x0F } == i2c.writes[0]);
+  };
+
+  "pca9685_complementary_pair::dead_time()"_test = []() {
+    // Setup
+    recording_i2c i2c;
+    pca9685 driver(i2c, 0b100'0000);
+    pca9685_complementary_pair bridge(driver, 0);
+
+    // Exercise
+    bridge.dead_time(1us, 1000.0f);
+
+    // Verify
+    expect(that % 5 == bridge.dead_time());
+    expect(throws<hal::argument_out_of_domain>(
+      [&]() { pca9685_complementary_pair(driver, 15); }));
+  };
+};
+}  // namespace hal::expander
@@ -0,0 +1,174 @@
+// Copyright 2024 Khalil Estell
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <libhal-expander/register_map.hpp>
+
+#include <array>
+#include <vector>
+
+#include <boost/ut.hpp>
+
+namespace hal::expander {
+namespace {
+struct burst
+{
+  hal::byte address;
+  std::vector<hal::byte> data;
+};
+
+template<class shadow>
+std::vector<burst> flush_all(shadow& p_shadow, std::size_t p_max_gap = 0)
+{
+  std::vector<burst> bursts;
+  p_shadow.flush(
+    [&bursts](hal::byte p_address, std::span<hal::byte const> p_data) {
+      bursts.push_back({ p_address, { p_data.begin(), p_data.end() } });
+    },
+    p_max_gap);
+  return bursts;
+}
+}  // namespace
+
+boost::ut::suite test_register_map = []() {
+  using namespace boost::ut;
+  using namespace std::literals;
+
+  using control = register_id<0x10>;
+  using enable = register_field<control, hal::bit_mask::from<0>()>;
+  using mode = register_field<control, hal::bit_mask::from<3, 2>()>;
+
+  "register_shadow::insert() only touches the field"_test = []() {
+    // Setup
+    register_shadow<0x10, 8> shadow;
+    shadow.load(0x10, std::array<hal::byte, 1>{ 0b1000'0000 });
+
+    // Exercise
+    shadow.insert<enable>(1U);
+    shadow.insert<mode>(0b10U);
+
+    // Verify
+    expect(that % 0b1000'1001 == shadow.get<control>());
+    expect(that % 0b10 == shadow.extract<mode>());
+    expect(shadow.dirty(control::address));
+  };
+
+  "register_shadow::set() same value is not dirty"_test = []() {
+    // Setup
+    register_shadow<0x00, 4> shadow;
+    shadow.load(0x00, std::array<hal::byte, 4>{ 1, 2, 3, 4 });
+
+    // Exercise
+    shadow.set(0x01, 2);
+
+    // Verify
+    expect(not shadow.dirty());
+    expect(flush_all(shadow).empty());
+  };
+
+  "register_shadow::set() unknown register is always dirty"_test = []() {
+    // Setup
+    register_shadow<0x00, 4> shadow;
+
+    // Exercise
+    shadow.set(0x02, 0);
+
+    // Verify
+    expect(shadow.dirty(0x02));
+    expect(not shadow.known(0x01));
+  };
+
+  "register_shadow::flush() merges contiguous bytes"_test = []() {
+    // Setup
+    register_shadow<0x06, 16> shadow;
+    shadow.set(0x06, std::array<hal::byte, 4>{ 0, 0, 0xFF, 0x0F });
+    shadow.set(0x0A, std::array<hal::byte, 4>{ 0, 0, 0x00, 0x08 });
+
+    // Exercise
+    auto bursts = flush_all(shadow);
+
+    // Verify
+    expect(that % 1U == bursts.size());
+    expect(that % 0x06 == bursts[0].address);
+    expect(that % 8U == bursts[0].data.size());
+    expect(that % 0x08 == bursts[0].data[7]);
+    expect(not shadow.dirty());
+  };
+
+  "register_shadow::flush() bridges small known gaps"_test = []() {
+    // Setup
+    register_shadow<0x00, 8> shadow;
+    shadow.load(0x00, std::array<hal::byte, 8>{});
+    shadow.set(0x01, 0xAA);
+    shadow.set(0x03, 0xBB);
+    shadow.set(0x07, 0xCC);
+
+    // Exercise
+    auto bursts = flush_all(shadow, 1);
+
+    // Verify
+    expect(that % 2U == bursts.size());
+    expect(that % 0x01 == bursts[0].address);
+    expect(that % 3U == bursts[0].data.size());
+    expect(that % 0x07 == bursts[1].address);
+  };
+
+  "register_shadow::flush() never bridges unknown bytes"_test = []() {
+    // Setup
+    register_shadow<0x00, 4> shadow;
+    shadow.set(0x00, 0xAA);
+    shadow.set(0x02, 0xBB);
+
+    // Exercise
+    auto bursts = flush_all(shadow, 2);
+
+    // Verify
+    expect(that % 2U == bursts.size());
+  };
+
+  "register_shadow::flush() keeps bytes dirty if the writer throws"_test =
+    []() {
+      // Setup
+      register_shadow<0x00, 4> shadow;
+      shadow.set(0x00, 0xAA);
+
+      // Exercise
+      bool threw = false;
+      try {
+        shadow.flush([](hal::byte, std::span<hal::byte const>) {
+          throw hal::byte{ 0 };
+        });
+      } catch (hal::byte) {
+        threw = true;
+      }
+
+      // Verify
+      expect(threw);
+      expect(shadow.dirty(0x00));
+    };
+
+  "register_shadow::forget() clears known and dirty"_test = []() {
+    // Setup
+    register_shadow<0x00, 4> shadow;
+    shadow.set(0x00, 0xAA);
+
+    // Exercise
+    shadow.forget();
+
+    // Verify
+    expect(not shadow.dirty());
+    expect(not shadow.known(0x00));
+    expect(that % 0 == shadow.get(0x00));
+  };
+};
+}  // namespace hal::expander
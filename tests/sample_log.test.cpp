@@ -0,0 +1,198 @@
+// Copyright 2024 Khalil Estell
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <libhal-expander/sample_log.hpp>
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include <libhal/error.hpp>
+
+#include <libhal-expander/simulation.hpp>
+#include <libhal-expander/tla2528.hpp>
+
+#include <boost/ut.hpp>
+
+#include "helpers.hpp"
+
+namespace hal::expander {
+namespace {
+constexpr hal::byte logged_pins = 0b1011'0101;
+
+struct log_file
+{
+  std::vector<hal::byte> bytes{};
+
+  sample_log_encoder::sink sink()
+  {
+    return [this](std::span<hal::byte const> p_data) {
+      bytes.insert(bytes.end(), p_data.begin(), p_data.end());
+    };
+  }
+};
+
+// Slow ramps with the occasional full scale step, like a sensor with spikes
+std::uint16_t waveform(std::size_t p_frame, std::size_t p_pin)
+{
+  if ((p_frame + p_pin) % 97 == 0) {
+    return (p_frame / 97) % 2 ? 4095 : 0;
+  }
+  return static_cast<std::uint16_t>((p_frame * (p_pin + 1) + p_pin * 300) %
+                                    4096);
+}
+}  // namespace
+
+boost::ut::suite test_sample_log = []() {
+  using namespace boost::ut;
+
+  "sample_log round trips scans of the simulated device"_test = []() {
+    // Setup
+    test::tla2528_bench bench;
+    auto& [clock, i2c, device] = bench;
+    tla2528 adc(i2c);
+    for (hal::byte pin = 0; pin < 8; pin++) {
+      adc.set_pin_mode(tla2528::pin_mode::adc, pin);
+    }
+    log_file file;
+    std::array<hal::byte, 256> block{};
+    sample_log_encoder encoder(logged_pins, 1e9f, block, file.sink());
+    std::vector<sample_log_frame> expected;
+
+    // Exercise
+    for (std::size_t frame = 0; frame < 1000; frame++) {
+      for (hal::byte pin = 0; pin < 8; pin++) {
+        device.set_analog_input(pin, waveform(frame, pin));
+      }
+      std::array<std::uint16_t, 8> codes{};
+      adc.scan(logged_pins, codes);
+      auto const timestamp = clock.uptime();
+      encoder.append(timestamp, codes);
+      expected.push_back({ .timestamp = timestamp, .codes = codes });
+    }
+    encoder.flush();
+
+    // Verify
+    sample_log_reader reader(file.bytes);
+    expect(that % logged_pins == reader.channels());
+    expect(that % 1e9f == reader.timestamp_frequency());
+    expect(that % encoder.blocks_written() == reader.block_count());
+    expect(reader.block_count() > 1);
+
+    std::vector<sample_log_frame> decoded;
+    for (std::size_t i = 0; i < reader.block_count(); i++) {
+      auto const log_block = reader.block(i);
+      expect(that % i == log_block.sequence());
+      for (auto const& frame : log_block) {
+        decoded.push_back(frame);
+      }
+    }
+    expect(that % expected.size() == decoded.size());
+    for (std::size_t i = 0; i < expected.size() && i < decoded.size(); i++) {
+      expect(expected[i].timestamp == decoded[i].timestamp) << i;
+      expect(expected[i].codes == decoded[i].codes) << i;
+    }
+
+    // 5 pins as CSV floats take well over 30 bytes per scan
+    expect(file.bytes.size() < expected.size() * 14) << file.bytes.size();
+  };
+
+  "sample_log blocks decode on their own"_test = []() {
+    // Setup
+    log_file file;
+    std::array<hal::byte, sample_log_format::min_block_size> block{};
+    sample_log_encoder encoder(0b0000'0011, 1e6f, block, file.sink());
+    std::array<std::uint16_t, 8> codes{};
+    for (std::uint16_t frame = 0; frame < 40; frame++) {
+      codes[0] = static_cast<std::uint16_t>(frame * 100);
+      codes[1] = static_cast<std::uint16_t>(4095 - frame);
+      encoder.append(frame * 1000U, codes);
+    }
+    encoder.flush();
+    sample_log_reader reader(file.bytes);
+
+    // Exercise
+    auto const index = reader.find(25'500);
+    auto const log_block = reader.block(index);
+    auto const first = *log_block.begin();
+
+    // Verify
+    expect(log_block.first_timestamp() <= 25'500);
+    expect(that % log_block.first_timestamp() == first.timestamp);
+    auto const frame = first.timestamp / 1000;
+    expect(that % frame * 100 == first.codes[0]);
+    expect(that % 4095 - frame == first.codes[1]);
+    expect(that % 0 == first.codes[2]);
+    expect(that % 0U == reader.find(0));
+    expect(that % reader.block_count() - 1 == reader.find(1'000'000));
+  };
+
+  "sample_log_encoder only completes full or flushed blocks"_test = []() {
+    // Setup
+    log_file file;
+    std::array<hal::byte, 64> block{};
+    sample_log_encoder encoder(0xFF, 1e6f, block, file.sink());
+    std::array<std::uint16_t, 8> codes{};
+
+    // Exercise
+    encoder.append(10, codes);
+    encoder.append(20, codes);
+
+    // Verify
+    expect(that % sample_log_format::header_size == file.bytes.size());
+    expect(that % 2U == encoder.pending_frames());
+
+    // Exercise
+    encoder.flush();
+    encoder.flush();
+
+    // Verify
+    expect(that % sample_log_format::header_size + block.size() ==
+           file.bytes.size());
+    expect(that % 1U == encoder.blocks_written());
+    expect(that % 0U == encoder.pending_frames());
+    expect(throws<hal::argument_out_of_domain>(
+      [&]() { encoder.append(19, codes); }));
+  };
+
+  "sample_log rejects invalid arguments and logs"_test = []() {
+    // Setup
+    log_file file;
+    std::array<hal::byte, sample_log_format::min_block_size - 1> small{};
+    std::array<hal::byte, 64> block{};
+    sample_log_encoder encoder(0x01, 1e6f, block, file.sink());
+    std::array<std::uint16_t, 8> codes{};
+    encoder.append(10, codes);
+    encoder.flush();
+    auto wrong_version = file.bytes;
+    wrong_version[4]++;
+    auto truncated = file.bytes;
+    truncated.pop_back();
+
+    // Exercise + Verify
+    expect(throws<hal::argument_out_of_domain>([&]() {
+      sample_log_encoder invalid(0x01, 1e6f, small, file.sink());
+    }));
+    expect(throws<hal::io_error>(
+      [&]() { sample_log_reader reader(wrong_version); }));
+    expect(throws<hal::io_error>([&]() {
+      sample_log_reader reader(std::span(file.bytes).first(4));
+    }));
+    // A partially written block is not counted
+    expect(that % 0U == sample_log_reader(truncated).block_count());
+    expect(throws<hal::argument_out_of_domain>(
+      [&]() { (void)sample_log_reader(truncated).block(0); }));
+  };
+};
+}  // namespace hal::expander
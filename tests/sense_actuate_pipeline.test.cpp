@@ -0,0 +1,93 @@
+// Copyright 2024 Khalil Estell
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <libhal-expander/sense_actuate_pipeline.hpp>
+
+#include <libhal-expander/simulation.hpp>
+
+#include <boost/ut.hpp>
+
+#include "helpers.hpp"
+
+namespace hal::expander {
+boost::ut::suite test_sense_actuate_pipeline = []() {
+  using namespace boost::ut;
+  using namespace std::literals;
+
+  "sense_actuate_pipeline::run_cycle()"_test = []() {
+    // Setup
+    test::board_bench bench;
+    auto& [clock, i2c, outputs, sensors] = bench;
+    tla2528 adc(i2c);
+    pca9685 pwm(i2c, 0x40);
+    sensors.set_analog_input(1, 1000);
+    sensors.set_analog_input(2, 3000);
+    sense_actuate_pipeline pipeline(
+      adc,
+      pwm,
+      clock,
+      [](std::span<std::uint16_t const, 8> p_codes,
+         std::span<std::uint16_t> p_ticks) {
+        p_ticks[0] = static_cast<std::uint16_t>(4095 - p_codes[1]);
+        p_ticks[1] = static_cast<std::uint16_t>(p_codes[2] / 2);
+      },
+      { .input_channels = 0b0110, .first_output = 8, .output_count = 2 });
+
+    // Exercise
+    pipeline.run_cycle();
+    sensors.set_analog_input(1, 0);
+    pipeline.run_cycle();
+
+    // Verify
+    expect(that % 4095 == outputs.off_ticks(8));
+    expect(that % 1500 == outputs.off_ticks(9));
+    expect(that % 4U == sensors.conversion_count());
+    expect(that % 2U == pipeline.stats().cycles);
+    expect(that % 0U == pipeline.stats().dropped);
+    expect(pipeline.stats().min_latency > 0ns);
+    expect(pipeline.stats().max_latency >= pipeline.stats().min_latency);
+    expect(pipeline.stats().max_jitter ==
+           pipeline.stats().max_latency - pipeline.stats().min_latency);
+  };
+
+  "sense_actuate_pipeline::actuate() commits the newest frame"_test = []() {
+    // Setup
+    test::board_bench bench;
+    auto& [clock, i2c, outputs, sensors] = bench;
+    tla2528 adc(i2c);
+    pca9685 pwm(i2c, 0x40);
+    sense_actuate_pipeline pipeline(
+      adc,
+      pwm,
+      clock,
+      [](std::span<std::uint16_t const, 8> p_codes,
+         std::span<std::uint16_t> p_ticks) { p_ticks[0] = p_codes[0]; },
+      { .input_channels = 0b0001, .output_count = 1 });
+
+    // Exercise
+    sensors.set_analog_input(0, 100);
+    pipeline.sense();
+    sensors.set_analog_input(0, 200);
+    pipeline.sense();
+    auto const committed = pipeline.actuate();
+    auto const repeated = pipeline.actuate();
+
+    // Verify
+    expect(committed);
+    expect(not repeated);
+    expect(that % 200 == outputs.off_ticks(0));
+    expect(that % 1U == pipeline.stats().cycles);
+  };
+};
+}  // namespace hal::expander
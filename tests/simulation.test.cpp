@@ -0,0 +1,111 @@
+// Copyright 2024 Khalil Estell
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <libhal-expander/simulation.hpp>
+
+#include <libhal-expander/pca9685.hpp>
+#include <libhal-expander/tla2528.hpp>
+
+#include <libhal/error.hpp>
+
+#include <boost/ut.hpp>
+
+#include "helpers.hpp"
+
+namespace hal::expander {
+boost::ut::suite test_simulation = []() {
+  using namespace boost::ut;
+  using namespace std::literals;
+
+  "simulated_i2c charges transfer time"_test = []() {
+    // Setup
+    test::pca9685_bench bench;
+    auto& [clock, i2c, device] = bench;
+    std::array<hal::byte, 2> const data{ 0x00, 0x20 };
+
+    // Exercise
+    i2c.transaction(0x40, data, {}, hal::never_timeout());
+
+    // Verify
+    // 3 bytes of 9 bits at 100 kHz
+    expect(that % 270'000 == clock.now().count());
+    expect(that % 1U == i2c.transaction_count());
+    expect(throws<hal::no_such_device>([&]() {
+      i2c.transaction(0x41, data, {}, hal::never_timeout());
+    }));
+  };
+
+  "pca9685 drives simulated_pca9685"_test = []() {
+    // Setup
+    test::pca9685_bench bench;
+    auto& [clock, i2c, device] = bench;
+    pca9685 driver(i2c, 0x40);
+    auto pwm5 = driver.get_pwm_channel<5>();
+
+    // Exercise
+    pwm5.duty_cycle(0.5f);
+    pwm5.frequency(200.0f);
+
+    // Verify
+    expect(that % 2048 == device.off_ticks(5));
+    expect(that % 0x20 == device.register_value(0x00));
+    expect(that % 30 == device.register_value(0xFE));
+  };
+
+  "tla2528 reads simulated_tla2528"_test = []() {
+    // Setup
+    test::tla2528_bench bench;
+    auto& [clock, i2c, device] = bench;
+    tla2528 driver(i2c);
+    device.set_analog_input(3, 4095);
+    device.set_digital_inputs(0b0100'0000);
+
+    // Exercise
+    driver.set_pin_mode(tla2528::pin_mode::adc, 3);
+    driver.set_pin_mode(tla2528::pin_mode::input_pin, 6);
+    driver.set_pin_mode(tla2528::pin_mode::output_pin_push_pull, 7);
+    driver.set_output_pin(7, true);
+    auto const reading = driver.get_adc_reading(3);
+    auto const inputs = driver.get_input_bus();
+
+    // Verify
+    expect(that % 1.0f == reading);
+    expect(that % 0b1100'0000 == inputs);
+    expect(that % 1U == device.conversion_count());
+    expect(that % 0b1000'0000 == device.register_value(0x09));
+  };
+
+  "measure_latency()"_test = []() {
+    // Setup
+    simulated_clock clock(0ns);
+    int run = 0;
+
+    // Exercise
+    auto const report = measure_latency(clock, 100, [&]() {
+      run++;
+      clock.advance(run == 100 ? 1ms : 1us);
+      if (run == 50) {
+        throw hal::io_error(nullptr);
+      }
+    });
+
+    // Verify
+    expect(that % 100U == report.samples);
+    expect(that % 1U == report.failures);
+    expect(1us == report.p50);
+    expect(1us == report.p99);
+    expect(1ms == report.max);
+  };
+};
+}  // namespace hal::expander
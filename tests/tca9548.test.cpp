@@ -0,0 +1,103 @@
+// Copyright 2024 Khalil Estell
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <libhal-expander/pca9685.hpp>
+#include <libhal-expander/tca9548.hpp>
+
+#include <array>
+#include <vector>
+
+#include <boost/ut.hpp>
+
+#include "helpers.hpp"
+
+namespace hal::expander {
+using test::recording_i2c;
+
+boost::ut::suite test_tca9548 = []() {
+  using namespace boost::ut;
+
+  "tca9548::port selects only on change"_test = []() {
+    // Setup
+    recording_i2c i2c;
+    tca9548 mux(i2c, 0x71);
+    auto port2 = mux.get_port<2>();
+    auto port5 = mux.get_port<5>();
+    std::array<hal::byte, 2> const data{ 0xAB, 0xCD };
+
+    // Exercise
+    port2.transaction(0x40, data, {}, hal::never_timeout());
+    port2.transaction(0x40, data, {}, hal::never_timeout());
+    port5.transaction(0x40, data, {}, hal::never_timeout());
+
+    // Verify
+    expect(that % 2U == mux.select_count());
+    expect(std::vector<hal::byte>{ 0x71, 0x40, 0x40, 0x71, 0x40 } ==
+           i2c.addresses);
+    expect(std::vector<hal::byte>{ 0b0000'0100 } == i2c.writes[0]);
+    expect(std::vector<hal::byte>{ 0b0010'0000 } == i2c.writes[3]);
+  };
+
+  "tca9548 reselects after a failed select or invalidate()"_test = []() {
+    // Setup
+    recording_i2c i2c;
+    tca9548 mux(i2c);
+    auto port1 = mux.get_port<1>();
+    std::array<hal::byte, 1> const data{ 0x00 };
+
+    // Exercise
+    i2c.fail_next = true;
+    expect(throws<hal::no_such_device>(
+      [&]() { port1.transaction(0x40, data, {}, hal::never_timeout()); }));
+    port1.transaction(0x40, data, {}, hal::never_timeout());
+    mux.invalidate();
+    port1.transaction(0x40, data, {}, hal::never_timeout());
+
+    // Verify
+    expect(that % 3U == mux.select_count());
+    expect(throws<hal::argument_out_of_domain>([&]() { mux.select(8); }));
+  };
+
+  "run_grouped_by_port() selects once per port"_test = []() {
+    // Setup
+    recording_i2c i2c;
+    tca9548 mux(i2c);
+    auto port0 = mux.get_port<0>();
+    auto port1 = mux.get_port<1>();
+    pca9685 left_a(port0, 0x40);
+    pca9685 right_a(port1, 0x40);
+    pca9685 left_b(port0, 0x41);
+    pca9685 right_b(port1, 0x41);
+    std::vector<int> order;
+    auto const update = [&order](pca9685& p_device, int p_id) {
+      p_device.get_pwm_channel<0>().duty_cycle(0.5f);
+      order.push_back(p_id);
+    };
+    std::array<tca9548_job, 4> jobs{ {
+      { 1, [&]() { update(right_a, 0); } },
+      { 0, [&]() { update(left_a, 1); } },
+      { 1, [&]() { update(right_b, 2); } },
+      { 0, [&]() { update(left_b, 3); } },
+    } };
+    auto const selects = mux.select_count();
+
+    // Exercise
+    run_grouped_by_port(jobs);
+
+    // Verify
+    expect(std::vector<int>{ 1, 3, 0, 2 } == order);
+    expect(that % 2U == mux.select_count() - selects);
+  };
+};
+}  // namespace hal::expander
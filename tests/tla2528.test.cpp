@@ -12,20 +12,173 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <libhal-expander/basic_tla2528.hpp>
 #include <libhal-expander/tla2528.hpp>
+#include <libhal-expander/simulation.hpp>
 #include <libhal-expander/tla2528_adapters.hpp>
 
+#include <vector>
+
 #include <boost/ut.hpp>
 
+#include "helpers.hpp"
+
 namespace hal::expander {
+namespace {
+using test::recording_i2c;
+
+// Bus type unrelated to hal::i2c, only usable with the basic_ drivers
+struct recording_bus
+{
+  void transaction(hal::byte,
+                   std::span<hal::byte const> p_data_out,
+                   std::span<hal::byte> p_data_in,
+                   hal::function_ref<hal::timeout_function>)
+  {
+    writes.emplace_back(p_data_out.begin(), p_data_out.end());
+    std::fill(p_data_in.begin(), p_data_in.end(), hal::byte{ 0 });
+  }
+
+  std::vector<std::vector<hal::byte>> writes;
+};
+}  // namespace
+
 boost::ut::suite test_tla2528 = []() {
   using namespace boost::ut;
   using namespace std::literals;
 
   "tla2528::tla2528()"_test = []() {
     // Setup
+    recording_i2c i2c;
+
+    // Exercise
+    tla2528 driver(i2c);
+
+    // Verify
+    expect(that % 0U == i2c.writes.size());
+  };
+
+  "tla2528::set_pin_mode()"_test = []() {
+    // Setup
+    recording_i2c i2c;
+    tla2528 driver(i2c);
+
     // Exercise
+    driver.set_pin_mode(tla2528::pin_mode::output_pin_push_pull, 2);
+    driver.set_pin_mode(tla2528::pin_mode::output_pin_push_pull, 2);
+    driver.set_pin_mode(tla2528::pin_mode::input_pin, 3);
+
+    // Verify
+    expect(that % 1 == i2c.reads);
+    expect(that % 3U == i2c.writes.size());
+    expect(std::vector<hal::byte>{
+             0b0010'1000, 0x05, 0b0100, 0x00, 0b0100, 0x00, 0b0100 } ==
+           i2c.writes[1]);
+    expect(std::vector<hal::byte>{ 0b0000'1000, 0x05, 0b1100 } ==
+           i2c.writes[2]);
+  };
+
+  "tla2528::get_adc_reading() selects the channel once"_test = []() {
+    // Setup
+    recording_i2c i2c;
+    tla2528 driver(i2c);
+
+    // Exercise
+    driver.get_adc_reading(4);
+    driver.get_adc_reading(4);
+
+    // Verify
+    expect(that % 3U == i2c.writes.size());
+    expect(std::vector<hal::byte>{ 0b0000'1000, 0x11, 0x04 } ==
+           i2c.writes[0]);
+  };
+
+  "basic_tla2528 matches tla2528"_test = []() {
+    // Setup
+    recording_i2c i2c;
+    recording_bus bus;
+    tla2528 erased(i2c);
+    basic_tla2528 basic(bus);
+
+    // Exercise
+    erased.set_pin_mode(tla2528::pin_mode::adc, 1);
+    erased.set_pin_mode(tla2528::pin_mode::output_pin_open_drain, 6);
+    erased.set_output_pin(6, true);
+    erased.get_input_bus();
+    erased.get_adc_reading(1);
+    basic.set_pin_mode(tla2528_pin_mode::adc, 1);
+    basic.set_pin_mode(tla2528_pin_mode::output_pin_open_drain, 6);
+    basic.set_output_pin(6, true);
+    basic.get_input_bus();
+    basic.get_adc_reading(1);
+
+    // Verify
+    expect(i2c.writes == bus.writes);
+    expect(throws<hal::argument_out_of_domain>(
+      [&]() { basic.get_adc_reading(8); }));
+  };
+
+  "adc_code() rounds oversampled frames to 12 bits"_test = []() {
+    using tla2528_registers::adc_code;
+
+    // Verify
+    expect(that % 0x800 == adc_code({ 0x80, 0x00 }));
+    expect(that % 0x800 == adc_code({ 0x7F, 0xF8 }));
+    expect(that % 0x7FF == adc_code({ 0x7F, 0xF7 }));
+    expect(that % 4095 == adc_code({ 0xFF, 0xF0 }));
+    expect(that % 4095 == adc_code({ 0xFF, 0xFF }));
+  };
+
+  "tla2528::get_microvolts() with a fixed reference"_test = []() {
+    // Setup
+    test::tla2528_bench bench;
+    auto& [clock, i2c, device] = bench;
+    tla2528 driver(i2c);
+    driver.set_pin_mode(tla2528::pin_mode::adc, 1);
+    device.set_analog_input(1, 4095);
+
+    // Exercise
+    auto const default_reference = driver.get_microvolts(1);
+    driver.set_reference(5'000'000);
+    device.set_analog_input(1, 2048);
+    auto const microvolts = driver.get_microvolts(1);
+    auto const millivolts = driver.get_millivolts(1);
+
+    // Verify
+    expect(that % 3'299'194U == default_reference);
+    expect(that % 2'500'000U == microvolts);
+    expect(that % 2'500U == millivolts);
+  };
+
+  "tla2528::scan_microvolts() with a reference pin"_test = []() {
+    // Setup
+    test::tla2528_bench bench;
+    auto& [clock, i2c, device] = bench;
+    tla2528 driver(i2c);
+    driver.set_pin_mode(tla2528::pin_mode::adc, 2);
+    driver.set_pin_mode(tla2528::pin_mode::adc, 7);
+    driver.set_reference(7, 2'500'000);
+    // AVDD has sagged, so the 2.5 V reference reads high
+    device.set_analog_input(7, 3600);
+    device.set_analog_input(2, 1800);
+    std::array<std::uint32_t, 8> microvolts{};
+
+    // Exercise
+    driver.scan_microvolts(0b0000'0100, microvolts);
+
+    // Verify
+    expect(that % 1'250'000U == microvolts[2]);
+    expect(that % 0U == microvolts[7]);
+    expect(that % 2U == device.conversion_count());
+    expect(that % 2'500U == driver.get_millivolts(7));
+
+    // Exercise
+    device.set_analog_input(7, 0);
+
     // Verify
+    expect(throws<hal::io_error>([&]() { driver.get_microvolts(2); }));
+    expect(throws<hal::argument_out_of_domain>(
+      [&]() { driver.set_reference(8, 2'500'000); }));
   };
 };
 }  // namespace hal::expander
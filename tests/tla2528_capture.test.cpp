@@ -0,0 +1,237 @@
+// Copyright 2024 Khalil Estell
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <libhal-expander/tla2528_capture.hpp>
+
+#include <array>
+#include <cstdint>
+
+#include <libhal/error.hpp>
+
+#include <libhal-expander/simulation.hpp>
+
+#include <boost/ut.hpp>
+
+#include "helpers.hpp"
+
+namespace hal::expander {
+namespace {
+using condition = tla2528_trigger::condition;
+
+struct capture_bench : test::tla2528_bench
+{
+  capture_bench()
+  {
+    adc.set_pin_mode(tla2528::pin_mode::adc, 0);
+    adc.set_pin_mode(tla2528::pin_mode::adc, 3);
+  }
+
+  tla2528 adc{ i2c };
+};
+}  // namespace
+
+boost::ut::suite test_tla2528_capture = []() {
+  using namespace boost::ut;
+
+  "tla2528_trigger::met()"_test = []() {
+    constexpr tla2528_trigger rising{ .when = condition::rising_edge,
+                                      .threshold = 100 };
+    static_assert(rising.met(99, 100));
+    static_assert(not rising.met(100, 101));
+    static_assert(not rising.met(101, 99));
+
+    constexpr tla2528_trigger falling{ .when = condition::falling_edge,
+                                       .threshold = 100 };
+    static_assert(falling.met(101, 100));
+    static_assert(not falling.met(100, 99));
+
+    constexpr tla2528_trigger above{ .when = condition::above,
+                                     .threshold = 100 };
+    static_assert(above.met(0, 100) && not above.met(200, 99));
+
+    constexpr tla2528_trigger below{ .when = condition::below,
+                                     .threshold = 100 };
+    static_assert(below.met(0, 100) && not below.met(0, 101));
+
+    constexpr tla2528_trigger rising_slope{ .when = condition::rising_slope,
+                                            .threshold = 50 };
+    static_assert(rising_slope.met(4000, 4050));
+    static_assert(not rising_slope.met(4000, 4049));
+    static_assert(not rising_slope.met(4050, 4000));
+
+    constexpr tla2528_trigger falling_slope{ .when = condition::falling_slope,
+                                             .threshold = 50 };
+    static_assert(falling_slope.met(50, 0));
+    static_assert(not falling_slope.met(0, 4095));
+  };
+
+  "tla2528_capture keeps pre and post trigger samples"_test = []() {
+    // Setup
+    capture_bench bench;
+    tla2528_capture<8> capture(
+      bench.adc,
+      bench.clock,
+      {
+        .pins = 0b0000'1001,
+        .trigger = { .pin = 3, .when = condition::rising_edge,
+                     .threshold = 1000 },
+        .pre_trigger = 3,
+        .post_trigger = 4,
+      });
+    capture.arm();
+
+    // Exercise
+    // The input ramps by 100 per sample on pin 3, so sample 10 reaches 1000,
+    // and the ring wraps several times before the trigger.
+    std::uint16_t step = 0;
+    while (!capture.sample()) {
+      step++;
+      bench.device.set_analog_input(3, static_cast<std::uint16_t>(step * 100));
+      bench.device.set_analog_input(0, step);
+    }
+
+    // Verify
+    auto const samples = capture.samples();
+    expect(that % 7U == samples.size());
+    expect(that % 3U == capture.trigger_index());
+    expect(capture.current_state() ==
+           tla2528_capture<8>::state::complete);
+    for (std::size_t i = 0; i < samples.size(); i++) {
+      auto const expected_step = 7 + i;
+      expect(that % expected_step * 100 == samples[i].codes[3]) << i;
+      expect(that % expected_step == samples[i].codes[0]) << i;
+      expect(that % 0 == samples[i].codes[1]) << i;
+      if (i > 0) {
+        expect(samples[i].timestamp > samples[i - 1].timestamp) << i;
+      }
+    }
+
+    // Exercise
+    auto const scans = bench.device.conversion_count();
+    capture.sample();
+
+    // Verify
+    // A complete capture stops sampling until it is armed again
+    expect(that % scans == bench.device.conversion_count());
+    expect(that % 7U == capture.samples().size());
+
+    // Exercise
+    capture.arm();
+
+    // Verify
+    expect(capture.samples().empty());
+  };
+
+  "tla2528_capture waits for a full pre-trigger history"_test = []() {
+    // Setup
+    capture_bench bench;
+    tla2528_capture<16> capture(
+      bench.adc,
+      bench.clock,
+      {
+        .pins = 0b0000'0001,
+        .trigger = { .when = condition::above, .threshold = 0 },
+        .pre_trigger = 5,
+        .post_trigger = 2,
+      });
+    capture.arm();
+
+    // Exercise
+    int calls = 0;
+    while (!capture.sample()) {
+      calls++;
+    }
+
+    // Verify
+    // The condition holds from the first sample, but triggers on the sixth
+    expect(that % 6 == calls);
+    expect(that % 7U == capture.samples().size());
+    expect(that % 5U == capture.trigger_index());
+  };
+
+  "tla2528_capture::force_trigger() keeps the samples taken so far"_test =
+    []() {
+      // Setup
+      capture_bench bench;
+      tla2528_capture<16> capture(
+        bench.adc,
+        bench.clock,
+        {
+          .pins = 0b0000'0001,
+          .trigger = { .when = condition::falling_slope, .threshold = 4095 },
+          .pre_trigger = 8,
+          .post_trigger = 3,
+        });
+      capture.arm();
+      capture.sample();
+      capture.sample();
+
+      // Exercise
+      capture.force_trigger();
+      capture.sample();
+      capture.sample();
+      bool const complete = capture.sample();
+
+      // Verify
+      expect(complete);
+      expect(that % 5U == capture.samples().size());
+      expect(that % 2U == capture.trigger_index());
+    };
+
+  "tla2528_capture::arm() drops an earlier force_trigger()"_test = []() {
+    // Setup
+    capture_bench bench;
+    tla2528_capture<16> capture(
+      bench.adc,
+      bench.clock,
+      {
+        .pins = 0b0000'0001,
+        .trigger = { .when = condition::falling_slope, .threshold = 4095 },
+        .pre_trigger = 0,
+        .post_trigger = 1,
+      });
+    capture.force_trigger();
+
+    // Exercise
+    capture.arm();
+    bool const complete = capture.sample();
+
+    // Verify
+    expect(not complete);
+    expect(tla2528_capture<16>::state::armed == capture.current_state());
+  };
+
+  "tla2528_capture rejects invalid settings"_test = []() {
+    // Setup
+    capture_bench bench;
+    using capture = tla2528_capture<8>;
+
+    // Exercise + Verify
+    expect(throws<hal::argument_out_of_domain>([&]() {
+      capture(bench.adc, bench.clock, { .pre_trigger = 5, .post_trigger = 4 });
+    }));
+    expect(throws<hal::argument_out_of_domain>([&]() {
+      capture(bench.adc, bench.clock, { .pre_trigger = 0, .post_trigger = 0 });
+    }));
+    expect(throws<hal::argument_out_of_domain>([&]() {
+      capture(bench.adc,
+              bench.clock,
+              { .pins = 0b0000'0001, .trigger = { .pin = 1 } });
+    }));
+    expect(throws<hal::argument_out_of_domain>([&]() {
+      capture(bench.adc, bench.clock, { .trigger = { .pin = 8 } });
+    }));
+  };
+};
+}  // namespace hal::expander
@@ -0,0 +1,106 @@
+// Copyright 2024 Khalil Estell
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <libhal-expander/simulation.hpp>
+#include <libhal-expander/tla2528_adapters.hpp>
+#include <libhal-expander/tla2528_encoders.hpp>
+
+#include <boost/ut.hpp>
+
+#include "helpers.hpp"
+
+namespace hal::expander {
+boost::ut::suite test_tla2528_encoders = []() {
+  using namespace boost::ut;
+
+  "tla2528_encoders decodes both directions"_test = []() {
+    // Setup
+    test::tla2528_bench bench;
+    auto& [clock, i2c, device] = bench;
+    tla2528 driver(i2c);
+    std::array<encoder_pins, 2> const pins{ { { 0, 1 }, { 5, 4 } } };
+    auto encoders = make_encoders(driver, pins);
+    // A leads B on encoder 0, B leads A on encoder 1
+    constexpr std::array<hal::byte, 8> sequence{
+      0b00'0000, 0b01'0001, 0b11'0011, 0b10'0010,
+      0b00'0000, 0b01'0001, 0b11'0011, 0b10'0010,
+    };
+    auto const transactions = i2c.transaction_count();
+
+    // Exercise
+    for (auto const levels : sequence) {
+      device.set_digital_inputs(levels);
+      encoders.sample();
+    }
+
+    // Verify
+    expect(that % 2U == encoders.count());
+    expect(that % 8U == i2c.transaction_count() - transactions);
+    expect(that % 7 == encoders.position(0));
+    expect(that % -7 == encoders.position(1));
+    expect(that % 0U == encoders.errors(0));
+    expect(that % 0U == encoders.errors(1));
+  };
+
+  "tla2528_encoders counts illegal transitions"_test = []() {
+    // Setup
+    test::tla2528_bench bench;
+    auto& [clock, i2c, device] = bench;
+    tla2528 driver(i2c);
+    std::array<encoder_pins, 1> const pins{ { { 2, 3 } } };
+    auto encoders = make_encoders(driver, pins);
+
+    // Exercise
+    encoders.decode(0b1100);
+    encoders.decode(0b0000);
+    encoders.decode(0b0100);
+
+    // Verify
+    expect(that % 1 == encoders.position(0));
+    expect(that % 2U == encoders.errors(0));
+
+    // Exercise
+    encoders.reset(0, -100);
+
+    // Verify
+    expect(that % -100 == encoders.position(0));
+    expect(that % 0U == encoders.errors(0));
+  };
+
+  "make_encoders() reserves pins"_test = []() {
+    // Setup
+    test::tla2528_bench bench;
+    auto& [clock, i2c, device] = bench;
+    tla2528 driver(i2c);
+    std::array<encoder_pins, 1> const pins{ { { 0, 1 } } };
+    std::array<encoder_pins, 1> const repeated{ { { 2, 2 } } };
+    std::array<encoder_pins, 1> const invalid{ { { 2, 8 } } };
+    std::array<encoder_pins, 5> const too_many{};
+
+    // Exercise + Verify
+    expect(throws<hal::argument_out_of_domain>(
+      [&]() { make_encoders(driver, repeated); }));
+    expect(throws<hal::argument_out_of_domain>(
+      [&]() { make_encoders(driver, invalid); }));
+    expect(throws<hal::argument_out_of_domain>(
+      [&]() { make_encoders(driver, too_many); }));
+    {
+      auto encoders = make_encoders(driver, pins);
+      expect(throws<hal::resource_unavailable_try_again>(
+        [&]() { make_input_pin(driver, 1); }));
+    }
+    expect(nothrow([&]() { make_input_pin(driver, 1); }));
+  };
+};
+}  // namespace hal::expander
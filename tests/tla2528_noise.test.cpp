@@ -0,0 +1,186 @@
+// Copyright 2024 Khalil Estell
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <libhal-expander/tla2528_noise.hpp>
+
+#include <libhal/error.hpp>
+
+#include <libhal-expander/fault_injector.hpp>
+#include <libhal-expander/simulation.hpp>
+#include <libhal-expander/tla2528_registers.hpp>
+
+#include <boost/ut.hpp>
+
+#include "helpers.hpp"
+
+namespace hal::expander {
+namespace {
+struct noise_bench : test::tla2528_bench
+{
+  noise_bench()
+  {
+    for (hal::byte pin = 0; pin < 3; pin++) {
+      adc.set_pin_mode(tla2528::pin_mode::adc, pin);
+    }
+    device.set_analog_input(0, 1000);
+    device.set_analog_input(1, 2000);
+    device.set_analog_input(2, 3000);
+  }
+
+  tla2528 adc{ i2c };
+};
+
+std::size_t index(tla2528_oversampling p_ratio)
+{
+  return static_cast<std::size_t>(p_ratio);
+}
+}  // namespace
+
+boost::ut::suite test_tla2528_noise = []() {
+  using namespace boost::ut;
+
+  "tla2528::set_oversampling() writes OSR_CFG once"_test = []() {
+    // Setup
+    noise_bench bench;
+
+    // Exercise
+    bench.adc.set_oversampling(tla2528_oversampling::x16);
+    auto const writes = bench.i2c.transaction_count();
+    bench.adc.set_oversampling(tla2528_oversampling::x16);
+
+    // Verify
+    expect(that % 4 == bench.device.register_value(
+                         tla2528_registers::osr_cfg::address));
+    expect(tla2528_oversampling::x16 == bench.adc.get_oversampling());
+    expect(that % writes == bench.i2c.transaction_count());
+  };
+
+  "characterize_noise() picks the smallest ratio meeting each target"_test =
+    []() {
+      // Setup
+      noise_bench bench;
+      // Uniform noise of +/-8 codes is about 4.9 codes standard deviation
+      bench.device.set_analog_noise(1, 8);
+      // Uniform noise of +/-2 codes is about 1.4 codes standard deviation
+      bench.device.set_analog_noise(2, 2);
+
+      // Exercise
+      auto const profile = characterize_noise(
+        bench.adc,
+        {
+          .pins = 0b0000'0111,
+          .samples = 512,
+          .max_std_dev_millicodes = { 100, 1000, 900 },
+        });
+
+      // Verify
+      auto const& x1 = profile.stats[index(tla2528_oversampling::x1)];
+      expect(that % 1'000'000U == x1[0].mean_millicodes);
+      expect(that % 0U == x1[0].std_dev_millicodes);
+      expect(that % 0 == x1[0].peak_to_peak);
+      expect(that % 12.0f == x1[0].effective_bits);
+      expect(x1[1].std_dev_millicodes > 4500 && x1[1].std_dev_millicodes < 5300)
+        << x1[1].std_dev_millicodes;
+      expect(that % 16 == x1[1].peak_to_peak);
+      expect(x1[1].effective_bits > 7.8f && x1[1].effective_bits < 8.0f)
+        << x1[1].effective_bits;
+
+      // Averaging 4 halves the noise
+      auto const& x4 = profile.stats[index(tla2528_oversampling::x4)];
+      auto const halved = x1[1].std_dev_millicodes / 2;
+      expect(x4[1].std_dev_millicodes > halved * 8 / 10 &&
+             x4[1].std_dev_millicodes < halved * 12 / 10)
+        << x4[1].std_dev_millicodes;
+
+      expect(tla2528_oversampling::x1 == profile.pin_ratio[0]);
+      // 4.9 / sqrt(32) = 0.87 codes
+      expect(tla2528_oversampling::x32 == profile.pin_ratio[1]);
+      // 1.4 / sqrt(2) is 1.0 codes before rounding, over the 0.9 target
+      expect(tla2528_oversampling::x4 == profile.pin_ratio[2]);
+      expect(that % 0 == profile.unmet);
+      expect(tla2528_oversampling::x32 == profile.ratio);
+      expect(tla2528_oversampling::x32 == bench.adc.get_oversampling());
+    };
+
+  "characterize_noise() resolves noise below one code"_test = []() {
+    // Setup
+    noise_bench bench;
+    // Uniform noise of +/-1 code is about 0.82 codes standard deviation
+    bench.device.set_analog_noise(0, 1);
+
+    // Exercise
+    auto const profile = characterize_noise(bench.adc,
+                                            {
+                                              .pins = 0b0000'0001,
+                                              .samples = 512,
+                                              .max_std_dev_millicodes = { 250 },
+                                            });
+
+    // Verify
+    // Averaging 16 quarters the noise to about 0.2 codes
+    auto const& x16 = profile.stats[index(tla2528_oversampling::x16)];
+    expect(x16[0].std_dev_millicodes > 150 && x16[0].std_dev_millicodes < 260)
+      << x16[0].std_dev_millicodes;
+    expect(x16[0].effective_bits > 12.0f) << x16[0].effective_bits;
+    expect(tla2528_oversampling::x16 == profile.ratio);
+  };
+
+  "characterize_noise() restores the ratio when a scan fails"_test = []() {
+    // Setup
+    noise_bench bench;
+    fault_injector i2c(bench.i2c, bench.clock);
+    tla2528 adc(i2c, test::tla2528_address);
+    adc.set_oversampling(tla2528_oversampling::x2);
+    // Selecting x1, then the first scan fails
+    std::array<fault, 2> const faults{ fault{}, fault{ i2c_fault::nack } };
+    i2c.script(faults);
+
+    // Exercise
+    auto const fails = throws<hal::no_such_device>(
+      [&]() { (void)characterize_noise(adc, { .pins = 0b0000'0001 }); });
+
+    // Verify
+    expect(fails);
+    expect(tla2528_oversampling::x2 == adc.get_oversampling());
+    expect(that % 1 == bench.device.register_value(
+                         tla2528_registers::osr_cfg::address));
+  };
+
+  "characterize_noise() reports unmet targets"_test = []() {
+    // Setup
+    noise_bench bench;
+    bench.device.set_analog_noise(0, 400);
+    bench.adc.set_oversampling(tla2528_oversampling::x2);
+
+    // Exercise
+    auto const profile = characterize_noise(bench.adc,
+                                            {
+                                              .pins = 0b0000'0001,
+                                              .samples = 64,
+                                              .max_std_dev_millicodes = { 1 },
+                                              .apply = false,
+                                            });
+
+    // Verify
+    expect(that % 0b0000'0001 == profile.unmet);
+    expect(tla2528_oversampling::x128 == profile.ratio);
+    expect(tla2528_oversampling::x2 == bench.adc.get_oversampling());
+    expect(that % 0U == profile.stats[0][1].std_dev_millicodes);
+    expect(throws<hal::argument_out_of_domain>(
+      [&]() { (void)characterize_noise(bench.adc, { .samples = 1 }); }));
+    expect(throws<hal::argument_out_of_domain>(
+      [&]() { (void)characterize_noise(bench.adc, { .samples = 1025 }); }));
+  };
+};
+}  // namespace hal::expander
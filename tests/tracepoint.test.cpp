@@ -0,0 +1,164 @@
+// Copyright 2024 Khalil Estell
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <libhal-expander/pca9685.hpp>
+#include <libhal-expander/tracepoint.hpp>
+
+#include <utility>
+#include <vector>
+
+#include <boost/ut.hpp>
+
+namespace hal::expander {
+namespace {
+// 1 MHz clock whose time is set by the test
+struct manual_clock : public hal::steady_clock
+{
+  hal::hertz driver_frequency() override
+  {
+    return 1'000'000.0f;
+  }
+
+  std::uint64_t driver_uptime() override
+  {
+    return m_uptime;
+  }
+
+  std::uint64_t m_uptime = 0;
+};
+
+struct recording_sink : public trace_sink
+{
+  void driver_record(trace_op p_op, trace_phase p_phase) override
+  {
+    events.emplace_back(p_op, p_phase);
+  }
+
+  std::vector<std::pair<trace_op, trace_phase>> events;
+};
+
+struct null_i2c : public hal::i2c
+{
+  void driver_configure(settings const&) override
+  {
+  }
+
+  void driver_transaction(hal::byte,
+                          std::span<hal::byte const>,
+                          std::span<hal::byte>,
+                          hal::function_ref<hal::timeout_function>) override
+  {
+  }
+};
+}  // namespace
+
+boost::ut::suite test_tracepoint = []() {
+  using namespace boost::ut;
+  using namespace std::literals;
+
+  "ticks_to_nanoseconds()"_test = []() {
+    // 2^24 + 1 ticks is past the precision of a float
+    expect(that % 16'777'217'000U == ticks_to_nanoseconds(16'777'217, 1e6f));
+    expect(that % 1'000'000'000'000U ==
+           ticks_to_nanoseconds(48'000'000'000, 48e6f));
+    expect(that % 20U == ticks_to_nanoseconds(1, 48e6f));
+  };
+
+  "percentile_rank()"_test = []() {
+    expect(that % 99U == percentile_rank(100, 0.99f));
+    expect(that % 50U == percentile_rank(100, 0.5f));
+    expect(that % 1U == percentile_rank(100, 0.0f));
+    expect(that % 100U == percentile_rank(100, 2.0f));
+    expect(that % 9'900'000'000U == percentile_rank(10'000'000'000, 0.99f));
+    expect(that % 0U == percentile_rank(0, 0.5f));
+  };
+
+  "latency_histogram::percentile()"_test = []() {
+    // Setup
+    latency_histogram histogram;
+
+    // Exercise
+    for (int i = 0; i < 99; i++) {
+      histogram.add(100);
+    }
+    histogram.add(5000);
+
+    // Verify
+    expect(that % 100U == histogram.count);
+    expect(that % 5000U == histogram.max);
+    expect(that % 127U == histogram.percentile(0.5f));
+    expect(that % 127U == histogram.percentile(0.99f));
+    expect(that % 5000U == histogram.percentile(1.0f));
+    expect(that % 0U == latency_histogram{}.percentile(0.5f));
+  };
+
+  "trace_histogram separates bus time from compute time"_test = []() {
+    // Setup
+    manual_clock clock;
+    trace_histogram histogram(clock);
+    auto const op = trace_op::pca9685_duty_cycle;
+
+    // Exercise
+    histogram.record(op, trace_phase::entry);
+    histogram.record(op, trace_phase::compute_begin);
+    clock.m_uptime += 2;
+    histogram.record(op, trace_phase::compute_end);
+    histogram.record(op, trace_phase::bus_begin);
+    clock.m_uptime += 30;
+    histogram.record(op, trace_phase::bus_end);
+    clock.m_uptime += 1;
+    histogram.record(op, trace_phase::bus_begin);
+    clock.m_uptime += 10;
+    histogram.record(op, trace_phase::bus_end);
+    histogram.record(op, trace_phase::exit);
+
+    // Verify
+    expect(that % 1U == histogram.total(op).count);
+    expect(that % 43'000U == histogram.total(op).max);
+    expect(that % 40'000U == histogram.bus(op).max);
+    expect(that % 2'000U == histogram.compute(op).max);
+    expect(that % 0U == histogram.total(trace_op::tla2528_get_input).count);
+  };
+
+  "pca9685 tracepoints"_test = []() {
+    // Setup
+    null_i2c i2c;
+    recording_sink sink;
+    pca9685 driver(i2c, 0b100'0000);
+    auto pwm0 = driver.get_pwm_channel<0>();
+    set_trace_sink(&sink);
+
+    // Exercise
+    pwm0.duty_cycle(0.5f);
+    set_trace_sink(nullptr);
+
+    // Verify
+    if constexpr (tracing_enabled) {
+      auto const op = trace_op::pca9685_duty_cycle;
+      expect(std::vector<std::pair<trace_op, trace_phase>>{
+               { op, trace_phase::entry },
+               { op, trace_phase::compute_begin },
+               { op, trace_phase::compute_end },
+               { op, trace_phase::compute_begin },
+               { op, trace_phase::compute_end },
+               { op, trace_phase::bus_begin },
+               { op, trace_phase::bus_end },
+               { op, trace_phase::exit },
+             } == sink.events);
+    } else {
+      expect(that % 0U == sink.events.size());
+    }
+  };
+};
+}  // namespace hal::expander